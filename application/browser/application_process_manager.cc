@@ -4,21 +4,72 @@
 
 #include "xwalk/application/browser/application_process_manager.h"
 
+#include <stdio.h>
+
 #include <string>
 
+#include "base/bind.h"
+#include "base/file_util.h"
+#include "base/memory/scoped_handle.h"
+#include "content/public/browser/browser_thread.h"
+#include "xwalk/application/common/application_file_util.h"
 #include "xwalk/application/common/application_manifest_constants.h"
+#include "xwalk/application/common/application_resource.h"
+#include "xwalk/application/common/application_resource_cache.h"
 #include "xwalk/application/common/constants.h"
+#include "xwalk/application/common/manifest.h"
 #include "xwalk/runtime/browser/runtime.h"
 #include "xwalk/runtime/browser/runtime_context.h"
 #include "net/base/net_util.h"
 
+using content::BrowserThread;
 using content::WebContents;
 using xwalk::Runtime;
 using xwalk::RuntimeContext;
 
+namespace keys = xwalk::application_manifest_keys;
+
 namespace xwalk {
 namespace application {
 
+namespace {
+
+const size_t kReadBufferSize = 64 * 1024;
+
+}  // namespace
+
+// static
+void ApplicationProcessManager::PreloadMainScripts(
+    scoped_refptr<const Application> application) {
+  const base::ListValue* main_scripts = NULL;
+  if (!application->GetManifest()->GetList(keys::kAppMainScriptsKey,
+                                           &main_scripts))
+    return;
+
+  scoped_ptr<char[]> buffer(new char[kReadBufferSize]);
+  for (size_t i = 0; i < main_scripts->GetSize(); ++i) {
+    std::string script;
+    if (!main_scripts->GetString(i, &script))
+      continue;
+    // The same relative path as the one of the request for the script, so
+    // the resolved path is found in the cache.
+    ApplicationResource resource(application->ID(), application->Path(),
+        ApplicationURLToRelativeFilePath(
+            application->GetResourceURL(script)));
+    ApplicationResourceCache::ResolvedFile resolved_file;
+    resolved_file.file_path = resource.GetFilePath();
+    const base::FilePath& path = resolved_file.file_path;
+    if (path.empty())
+      continue;
+    ApplicationResourceCache::GetInstance()->Set(resource, resolved_file);
+
+    ScopedStdioHandle file(file_util::OpenFile(path, "rb"));
+    if (!file.get())
+      continue;
+    while (fread(buffer.get(), 1, kReadBufferSize, file.get()) > 0) {}
+  }
+}
+
 ApplicationProcessManager::ApplicationProcessManager(
     RuntimeContext* runtime_context)
     : runtime_context_(runtime_context),
@@ -32,63 +83,40 @@ ApplicationProcessManager::~ApplicationProcessManager() {
 bool ApplicationProcessManager::LaunchApplication(
         RuntimeContext* runtime_context,
         const Application* application) {
-  if (RunMainDocument(application))
-    return true;
-  // NOTE: For now we allow launching a web app from a local path. This may go
-  // away at some point.
-  return RunFromLocalPath(application);
-}
-
-bool ApplicationProcessManager::RunMainDocument(
-    const Application* application) {
-  const Manifest* manifest = application->GetManifest();
-  const base::DictionaryValue* dict = NULL;
-  if (!manifest->GetDictionary(application_manifest_keys::kAppMainKey, &dict))
+  LaunchDescriptor descriptor;
+  if (!LaunchDescriptor::FromManifest(application->ID(),
+                                      *application->GetManifest()->value(),
+                                      &descriptor))
     return false;
+  return LaunchApplication(runtime_context, application, descriptor);
+}
 
-  GURL url;
-  std::string main_source;
-  const base::ListValue* main_scripts = NULL;
-  manifest->GetString(application_manifest_keys::kAppMainSourceKey,
-      &main_source);
-  manifest->GetList(application_manifest_keys::kAppMainScriptsKey,
-      &main_scripts);
-
-  if (!main_source.empty() && (main_scripts && main_scripts->GetSize()))
-    LOG(WARNING) << "An app should not has more than one main document.";
-
-  if (!main_source.empty()) {
-    url = application->GetResourceURL(main_source);
-  } else if (main_scripts && main_scripts->GetSize()) {
-    // When no main.source is defined but main.scripts are, we implicitly create
-    // a main document.
-    url = application->GetResourceURL(kGeneratedMainDocumentFilename);
-  } else {
-    LOG(WARNING) << "The app.main field doesn't contain a valid main document.";
+bool ApplicationProcessManager::LaunchApplication(
+        RuntimeContext* runtime_context,
+        const Application* application,
+        const LaunchDescriptor& descriptor) {
+  DCHECK(application);
+  if (!descriptor.entry_url.is_valid()) {
+    LOG(WARNING) << "Invalid launch URL for app.";
     return false;
   }
 
-  main_runtime_ = Runtime::Create(runtime_context_, url);
-  return true;
-}
+  // The main scripts are read while the runtime starts. Packed applications
+  // are served from their package, there are no files to preload.
+  if (descriptor.main_document_type ==
+          LaunchDescriptor::MAIN_DOCUMENT_GENERATED &&
+      !application->Path().MatchesExtension(kApplicationFileExtension)) {
+    BrowserThread::PostBlockingPoolTask(FROM_HERE,
+        base::Bind(&PreloadMainScripts, make_scoped_refptr(application)));
+  }
 
-bool ApplicationProcessManager::RunFromLocalPath(
-    const Application* application) {
-  const Manifest* manifest = application->GetManifest();
-  std::string entry_page;
-  if (manifest->GetString(application_manifest_keys::kLaunchLocalPathKey,
-        &entry_page) && !entry_page.empty()) {
-    GURL url = application->GetResourceURL(entry_page);
-    if (url.is_empty()) {
-      LOG(WARNING) << "Can't find a valid local path URL for app.";
-      return false;
-    }
-
-    Runtime::CreateWithDefaultWindow(runtime_context_, url);
+  if (descriptor.window_mode == LaunchDescriptor::WINDOW_MODE_NONE) {
+    main_runtime_ = Runtime::Create(runtime_context_, descriptor.entry_url);
     return true;
   }
 
-  return false;
+  Runtime::CreateWithDefaultWindow(runtime_context_, descriptor.entry_url);
+  return true;
 }
 
 }  // namespace application
@@ -15,6 +15,7 @@
 #include "base/memory/weak_ptr.h"
 #include "base/time/time.h"
 #include "xwalk/application/common/application.h"
+#include "xwalk/application/common/launch_descriptor.h"
 
 class GURL;
 
@@ -39,11 +40,20 @@ class ApplicationProcessManager {
   bool LaunchApplication(xwalk::RuntimeContext* runtime_context,
                          const Application* application);
 
+  // Launches |application| from the descriptor stored when it was
+  // installed, without looking up its manifest.
+  bool LaunchApplication(xwalk::RuntimeContext* runtime_context,
+                         const Application* application,
+                         const LaunchDescriptor& descriptor);
+
   Runtime* GetMainDocumentRuntime() const { return main_runtime_; }
 
+  // Reads the main scripts of |application|, so their paths are resolved in
+  // ApplicationResourceCache and their content is in the page cache when the
+  // generated main document requests them. It blocks on IO.
+  static void PreloadMainScripts(scoped_refptr<const Application> application);
+
  private:
-  bool RunMainDocument(const Application* application);
-  bool RunFromLocalPath(const Application* application);
 
   xwalk::RuntimeContext* runtime_context_;
   xwalk::Runtime* main_runtime_;
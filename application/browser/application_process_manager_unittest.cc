@@ -0,0 +1,44 @@
+// Copyright (c) 2013 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "xwalk/application/browser/application_process_manager.h"
+
+#include "base/path_service.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "xwalk/application/common/application_file_util.h"
+#include "xwalk/application/common/application_resource.h"
+#include "xwalk/application/common/application_resource_cache.h"
+
+namespace xwalk {
+namespace application {
+
+TEST(ApplicationProcessManagerTest, PreloadMainScripts) {
+  base::FilePath path;
+  ASSERT_TRUE(PathService::Get(base::DIR_SOURCE_ROOT, &path));
+  path = path.AppendASCII("xwalk")
+      .AppendASCII("application")
+      .AppendASCII("test")
+      .AppendASCII("data")
+      .AppendASCII("main_document");
+  std::string error;
+  scoped_refptr<const Application> application(
+      LoadApplication(path, Manifest::COMMAND_LINE, &error));
+  ASSERT_TRUE(application) << error;
+
+  ApplicationResourceCache* cache = ApplicationResourceCache::GetInstance();
+  cache->Invalidate(application->ID());
+  ApplicationResource script(application->ID(), application->Path(),
+                             base::FilePath(FILE_PATH_LITERAL("main.js")));
+  ApplicationResourceCache::ResolvedFile file;
+  EXPECT_FALSE(cache->Get(script, &file));
+
+  // The scripts are resolved for the requests of the main document.
+  ApplicationProcessManager::PreloadMainScripts(application);
+  ASSERT_TRUE(cache->Get(script, &file));
+  EXPECT_EQ(application->Path().AppendASCII("main.js"), file.file_path);
+  cache->Invalidate(application->ID());
+}
+
+}  // namespace application
+}  // namespace xwalk
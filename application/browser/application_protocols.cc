@@ -4,49 +4,79 @@
 
 #include "xwalk/application/browser/application_protocols.h"
 
+#include <string.h>
+
 #include <algorithm>
 #include <string>
 #include <vector>
 
+#include "base/file_util.h"
 #include "base/files/file_path.h"
+#include "base/memory/ref_counted_memory.h"
 #include "base/memory/weak_ptr.h"
+#include "base/message_loop/message_loop.h"
+#include "base/task_runner_util.h"
 #include "base/threading/thread_restrictions.h"
 #include "base/threading/worker_pool.h"
 #include "base/threading/sequenced_worker_pool.h"
 #include "content/public/browser/browser_thread.h"
 #include "content/public/browser/resource_request_info.h"
 #include "url/url_util.h"
+#include "net/base/io_buffer.h"
+#include "net/base/mime_util.h"
 #include "net/base/net_errors.h"
+#include "net/filter/filter.h"
+#include "net/http/http_request_headers.h"
 #include "net/http/http_response_headers.h"
 #include "net/http/http_response_info.h"
 #include "net/url_request/url_request_error_job.h"
 #include "net/url_request/url_request_file_job.h"
 #include "net/url_request/url_request_simple_job.h"
+#include "xwalk/application/browser/application_resource_memory_cache.h"
 #include "xwalk/application/common/application.h"
+#include "xwalk/application/common/application_archive.h"
 #include "xwalk/application/common/application_file_util.h"
 #include "xwalk/application/common/application_manifest_constants.h"
 #include "xwalk/application/common/application_resource.h"
+#include "xwalk/application/common/application_resource_cache.h"
 #include "xwalk/application/common/constants.h"
 
 using content::ResourceRequestInfo;
 using xwalk::application::Application;
+using xwalk::application::ApplicationArchive;
+using xwalk::application::ApplicationResourceCache;
+using xwalk::application::FormatHTTPDate;
+using xwalk::application::GetResourceValidators;
+using xwalk::application::IsNotModified;
+using xwalk::application::MemoryCachedResource;
+using xwalk::application::ResourceMemoryCache;
+using xwalk::application::ResourceValidators;
 
 namespace {
 
+// The total size of the resources in the memory cache of an application.
+const size_t kMemoryCacheSize = 4 * 1024 * 1024;
+
+// |validators| may be NULL for the resources which can't be revalidated.
 net::HttpResponseHeaders* BuildHttpHeaders(
     const std::string& mime_type, const std::string& method,
     const base::FilePath& file_path, const base::FilePath& relative_path,
-    bool is_authority_match) {
+    bool is_authority_match, const ResourceValidators* validators,
+    bool not_modified) {
   std::string raw_headers;
+  bool found = false;
   if (method == "GET") {
-    if (relative_path.empty())
+    if (relative_path.empty()) {
       raw_headers.append("HTTP/1.1 400 Bad Request");
-    else if (!is_authority_match)
+    } else if (!is_authority_match) {
       raw_headers.append("HTTP/1.1 403 Forbidden");
-    else if (file_path.empty())
+    } else if (file_path.empty()) {
       raw_headers.append("HTTP/1.1 404 Not Found");
-    else
-      raw_headers.append("HTTP/1.1 200 OK");
+    } else {
+      found = true;
+      raw_headers.append(not_modified ? "HTTP/1.1 304 Not Modified" :
+                                        "HTTP/1.1 200 OK");
+    }
   } else {
     raw_headers.append("HTTP/1.1 501 Not Implemented");
   }
@@ -60,18 +90,56 @@ net::HttpResponseHeaders* BuildHttpHeaders(
     raw_headers.append(mime_type);
   }
 
+  // The resources change when the application is updated, so they're always
+  // revalidated, which is cheap.
+  if (found && validators && !validators->etag.empty()) {
+    raw_headers.append(1, '\0');
+    raw_headers.append("Cache-Control: no-cache");
+    raw_headers.append(1, '\0');
+    raw_headers.append("ETag: ");
+    raw_headers.append(validators->etag);
+    raw_headers.append(1, '\0');
+    raw_headers.append("Last-Modified: ");
+    raw_headers.append(FormatHTTPDate(validators->last_modified));
+  }
+
   raw_headers.append(2, '\0');
   return new net::HttpResponseHeaders(raw_headers);
 }
 
+// Returns the main document loading the main scripts of |application|, or
+// NULL if it has none.
+scoped_refptr<base::RefCountedString> GenerateMainDocument(
+    const Application* application) {
+  // TODO(xiang): use manifest handler instead of the raw data.
+  const base::ListValue* main_scripts;
+  if (!application->GetManifest()->GetList(
+          xwalk::application_manifest_keys::kAppMainScriptsKey,
+          &main_scripts))
+    return NULL;
+
+  scoped_refptr<base::RefCountedString> document(new base::RefCountedString);
+  std::string* data = &document->data();
+  *data = "<!DOCTYPE html>\n<body>\n";
+  for (size_t i = 0; i < main_scripts->GetSize(); ++i) {
+    std::string script;
+    main_scripts->GetString(i, &script);
+    *data += "<script src=\"";
+    *data += script;
+    *data += "\"></script>\n";
+  }
+  return document;
+}
+
 class GeneratedMainDocumentJob: public net::URLRequestSimpleJob {
  public:
-  GeneratedMainDocumentJob(net::URLRequest* request,
-                           net::NetworkDelegate* network_delegate,
-                           const base::FilePath& relative_path,
-                           const scoped_refptr<const Application> application)
+  GeneratedMainDocumentJob(
+      net::URLRequest* request,
+      net::NetworkDelegate* network_delegate,
+      const base::FilePath& relative_path,
+      const scoped_refptr<base::RefCountedString>& main_document)
     : net::URLRequestSimpleJob(request, network_delegate),
-      application_(application),
+      main_document_(main_document),
       mime_type_("text/html"),
       relative_path_(relative_path) {
   }
@@ -83,42 +151,101 @@ class GeneratedMainDocumentJob: public net::URLRequestSimpleJob {
                       const net::CompletionCallback& callback) const OVERRIDE {
     *mime_type = mime_type_;
     *charset = "utf-8";
-    *data = "<!DOCTYPE html>\n<body>\n";
-
-    // TODO(xiang): use manifest handler instead of the raw data.
-    const base::ListValue* main_scripts;
-    application_->GetManifest()->GetList(
-        xwalk::application_manifest_keys::kAppMainScriptsKey,
-        &main_scripts);
-    for (size_t i = 0; i < main_scripts->GetSize(); ++i) {
-      std::string script;
-      main_scripts->GetString(i, &script);
-      *data += "<script src=\"";
-      *data += script;
-      *data += "\"></script>\n";
-    }
+    *data = main_document_->data();
     return net::OK;
   }
 
   virtual void GetResponseInfo(net::HttpResponseInfo* info) OVERRIDE {
     response_info_.headers = BuildHttpHeaders(mime_type_, "GET", relative_path_,
-        relative_path_, true);
+        relative_path_, true, NULL, false);
     *info = response_info_;
   }
 
  private:
   virtual ~GeneratedMainDocumentJob() {}
 
-  scoped_refptr<const Application> application_;
+  scoped_refptr<base::RefCountedString> main_document_;
   const std::string mime_type_;
   const base::FilePath relative_path_;
   net::HttpResponseInfo response_info_;
 };
 
-void ReadResourceFilePath(
+struct ResourceFileInfo {
+  ApplicationResourceCache::ResolvedFile file;
+  // The content of a small file, from the memory cache.
+  scoped_refptr<MemoryCachedResource> memory_cached_resource;
+};
+
+bool GetResourceFileInfo(const base::FilePath& file_path,
+                         base::PlatformFileInfo* file_info) {
+  return !file_path.empty() &&
+      file_util::GetFileInfo(file_path, file_info) &&
+      !file_info->is_directory;
+}
+
+// Resolves the path of |resource| unless it's cached, and reads the
+// validators of the file. If the file didn't change since it was cached, it's
+// only stat'ed. Small files are got from |memory_cache|, or read into it, if
+// it's not NULL, the compressed copy of the others is looked up.
+void ReadResourceFileInfo(
     const xwalk::application::ApplicationResource& resource,
-    base::FilePath* file_path) {
-  *file_path = resource.GetFilePath();
+    const scoped_refptr<ResourceMemoryCache>& memory_cache,
+    ResourceFileInfo* info) {
+  // The paths resolved in the previous version of the application may not be
+  // the ones of the resources anymore.
+  ApplicationResourceCache* cache = ApplicationResourceCache::GetInstance();
+  cache->InvalidateIfChanged(resource.application_id(),
+                             resource.application_root());
+  ApplicationResourceCache::ResolvedFile cached_file;
+  cache->Get(resource, &cached_file);
+
+  ApplicationResourceCache::ResolvedFile* file = &info->file;
+  file->file_path = cached_file.file_path;
+  base::PlatformFileInfo file_info;
+  if (!GetResourceFileInfo(file->file_path, &file_info)) {
+    // The file cached may be gone with an update of the application.
+    file->file_path = resource.GetFilePath();
+    if (!GetResourceFileInfo(file->file_path, &file_info))
+      return;
+  }
+  file->has_file_info = true;
+  file->size = file_info.size;
+  file->last_modified = file_info.last_modified;
+  const bool is_unchanged = cached_file.has_file_info &&
+      file->file_path == cached_file.file_path &&
+      file->size == cached_file.size &&
+      file->last_modified == cached_file.last_modified;
+
+  if (memory_cache &&
+      file_info.size <= xwalk::application::kMaxMemoryCachedResourceSize) {
+    const ResourceValidators validators =
+        GetResourceValidators(file->size, file->last_modified);
+    info->memory_cached_resource =
+        memory_cache->Get(resource.relative_path(), validators);
+    if (!info->memory_cached_resource) {
+      std::string mime_type;
+      net::GetMimeTypeFromFile(file->file_path, &mime_type);
+      scoped_refptr<MemoryCachedResource> cached_resource(
+          new MemoryCachedResource(mime_type, validators));
+      if (file_util::ReadFileToString(file->file_path,
+                                      cached_resource->mutable_data())) {
+        memory_cache->Put(resource.relative_path(), cached_resource);
+        info->memory_cached_resource = cached_resource;
+      }
+    }
+  } else if (is_unchanged) {
+    file->compressed_file_path = cached_file.compressed_file_path;
+  } else {
+    // A compressed copy older than the file is stale.
+    const base::FilePath compressed_file_path = file->file_path.AddExtension(
+        xwalk::application::kCompressedResourceExtension);
+    base::PlatformFileInfo compressed_file_info;
+    if (file_util::GetFileInfo(compressed_file_path, &compressed_file_info) &&
+        !compressed_file_info.is_directory &&
+        compressed_file_info.last_modified >= file_info.last_modified)
+      file->compressed_file_path = compressed_file_path;
+  }
+  cache->Set(resource, *file);
 }
 
 class URLRequestApplicationJob : public net::URLRequestFileJob {
@@ -130,12 +257,17 @@ class URLRequestApplicationJob : public net::URLRequestFileJob {
       const std::string& application_id,
       const base::FilePath& directory_path,
       const base::FilePath& relative_path,
-      bool is_authority_match)
+      bool is_authority_match,
+      const scoped_refptr<ResourceMemoryCache>& memory_cache)
       : net::URLRequestFileJob(
           request, network_delegate, base::FilePath(), file_task_runner),
       resource_(application_id, directory_path, relative_path),
       relative_path_(relative_path),
       is_authority_match_(is_authority_match),
+      memory_cache_(memory_cache),
+      not_modified_(false),
+      is_compressed_(false),
+      memory_data_offset_(0),
       weak_factory_(this) {
   }
 
@@ -144,30 +276,98 @@ class URLRequestApplicationJob : public net::URLRequestFileJob {
     GetMimeType(&mime_type);
     std::string method = request()->method();
     response_info_.headers = BuildHttpHeaders(mime_type, method, file_path_,
-        relative_path_, is_authority_match_);
+        relative_path_, is_authority_match_, &validators_, not_modified_);
+    if (is_compressed_)
+      response_info_.headers->AddHeader("Content-Encoding: gzip");
     *info = response_info_;
   }
 
+  // The type of a compressed copy is the one of the resource file.
+  virtual bool GetMimeType(std::string* mime_type) const OVERRIDE {
+    return net::GetMimeTypeFromFile(resource_file_path_, mime_type);
+  }
+
+  virtual net::Filter* SetupFilter() const OVERRIDE {
+    if (is_compressed_)
+      return net::Filter::GZipFactory();
+    return URLRequestFileJob::SetupFilter();
+  }
+
+  virtual void SetExtraRequestHeaders(
+      const net::HttpRequestHeaders& headers) OVERRIDE {
+    request_headers_ = headers;
+    URLRequestFileJob::SetExtraRequestHeaders(headers);
+  }
+
   virtual void Start() OVERRIDE {
-    base::FilePath* read_file_path = new base::FilePath;
+    ResourceFileInfo* file_info = new ResourceFileInfo;
 
+    // A resource loaded already isn't resolved again, but its file is stat'ed
+    // again, so its validators and the resource in memory aren't stale after
+    // the application is updated.
     bool posted = base::WorkerPool::PostTaskAndReply(
         FROM_HERE,
-        base::Bind(&ReadResourceFilePath, resource_,
-                   base::Unretained(read_file_path)),
-        base::Bind(&URLRequestApplicationJob::OnFilePathRead,
+        base::Bind(&ReadResourceFileInfo, resource_, memory_cache_,
+                   base::Unretained(file_info)),
+        base::Bind(&URLRequestApplicationJob::OnFileInfoRead,
                    weak_factory_.GetWeakPtr(),
-                   base::Owned(read_file_path)),
+                   base::Owned(file_info)),
         true /* task is slow */);
     DCHECK(posted);
   }
 
+  virtual void Kill() OVERRIDE {
+    weak_factory_.InvalidateWeakPtrs();
+    URLRequestFileJob::Kill();
+  }
+
+  virtual bool ReadRawData(net::IOBuffer* buf,
+                           int buf_size,
+                           int* bytes_read) OVERRIDE {
+    if (not_modified_) {
+      *bytes_read = 0;
+      return true;
+    }
+    if (memory_cached_resource_) {
+      const std::string& data = memory_cached_resource_->data();
+      size_t size = std::min(data.size() - memory_data_offset_,
+                             static_cast<size_t>(buf_size));
+      memcpy(buf->data(), data.data() + memory_data_offset_, size);
+      memory_data_offset_ += size;
+      *bytes_read = static_cast<int>(size);
+      return true;
+    }
+    return URLRequestFileJob::ReadRawData(buf, buf_size, bytes_read);
+  }
+
  private:
   virtual ~URLRequestApplicationJob() {}
 
-  void OnFilePathRead(base::FilePath* read_file_path) {
-    file_path_ = *read_file_path;
-    if (file_path_.empty())
+  void OnFileInfoRead(ResourceFileInfo* file_info) {
+    const ApplicationResourceCache::ResolvedFile& file = file_info->file;
+    file_path_ = file.file_path;
+    resource_file_path_ = file.file_path;
+    if (file.has_file_info) {
+      validators_ = GetResourceValidators(file.size, file.last_modified);
+    }
+    not_modified_ = file.has_file_info &&
+        IsNotModified(request_headers_, validators_);
+    // The ranges are in the resource file, not in its compressed copy, nor
+    // are they served from memory.
+    bool has_range =
+        request_headers_.HasHeader(net::HttpRequestHeaders::kRange);
+    if (file_info->memory_cached_resource && !not_modified_ && !has_range) {
+      // The file is in memory already, it isn't read again.
+      memory_cached_resource_ = file_info->memory_cached_resource;
+      set_expected_content_size(memory_cached_resource_->data().size());
+      NotifyHeadersComplete();
+      return;
+    }
+    if (!file.compressed_file_path.empty() && !not_modified_ && !has_range) {
+      file_path_ = file.compressed_file_path;
+      is_compressed_ = true;
+    }
+    if (file_path_.empty() || not_modified_)
       NotifyHeadersComplete();
     else
       URLRequestFileJob::Start();
@@ -177,18 +377,163 @@ class URLRequestApplicationJob : public net::URLRequestFileJob {
   base::FilePath relative_path_;
   bool is_authority_match_;
   xwalk::application::ApplicationResource resource_;
+  scoped_refptr<ResourceMemoryCache> memory_cache_;
+  net::HttpRequestHeaders request_headers_;
+  ResourceValidators validators_;
+  bool not_modified_;
+  // The file served is the compressed copy of |resource_file_path_|.
+  base::FilePath resource_file_path_;
+  bool is_compressed_;
+  // The content served, when it's in memory already.
+  scoped_refptr<MemoryCachedResource> memory_cached_resource_;
+  size_t memory_data_offset_;
   base::WeakPtrFactory<URLRequestApplicationJob> weak_factory_;
 };
 
+scoped_refptr<ApplicationArchive::EntryReader> OpenArchiveEntry(
+    const scoped_refptr<ApplicationArchive>& archive,
+    const base::FilePath& relative_path) {
+  std::string name = relative_path.AsUTF8Unsafe();
+#if defined(FILE_PATH_USES_WIN_SEPARATORS)
+  std::replace(name.begin(), name.end(), '\\', '/');
+#endif
+  return archive->OpenEntry(name);
+}
+
+int ReadArchiveEntry(
+    const scoped_refptr<ApplicationArchive::EntryReader>& reader,
+    const scoped_refptr<net::IOBuffer>& buffer,
+    int size) {
+  return reader->Read(buffer->data(), size);
+}
+
+// Serves the resources of an application installed packed, from its package.
+class URLRequestApplicationArchiveJob : public net::URLRequestJob {
+ public:
+  URLRequestApplicationArchiveJob(
+      net::URLRequest* request,
+      net::NetworkDelegate* network_delegate,
+      const scoped_refptr<base::TaskRunner>& file_task_runner,
+      const scoped_refptr<ApplicationArchive>& archive,
+      const base::FilePath& relative_path,
+      bool is_authority_match)
+      : net::URLRequestJob(request, network_delegate),
+        file_task_runner_(file_task_runner),
+        archive_(archive),
+        relative_path_(relative_path),
+        is_authority_match_(is_authority_match),
+        weak_factory_(this) {
+  }
+
+  virtual void Start() OVERRIDE {
+    if (!is_authority_match_ || relative_path_.empty()) {
+      base::MessageLoop::current()->PostTask(FROM_HERE,
+          base::Bind(&URLRequestApplicationArchiveJob::OnEntryOpened,
+                     weak_factory_.GetWeakPtr(),
+                     scoped_refptr<ApplicationArchive::EntryReader>()));
+      return;
+    }
+
+    // The package is mapped and indexed by the first request.
+    bool posted = base::PostTaskAndReplyWithResult(
+        file_task_runner_.get(),
+        FROM_HERE,
+        base::Bind(&OpenArchiveEntry, archive_, relative_path_),
+        base::Bind(&URLRequestApplicationArchiveJob::OnEntryOpened,
+                   weak_factory_.GetWeakPtr()));
+    DCHECK(posted);
+  }
+
+  virtual void Kill() OVERRIDE {
+    weak_factory_.InvalidateWeakPtrs();
+    net::URLRequestJob::Kill();
+  }
+
+  virtual bool GetMimeType(std::string* mime_type) const OVERRIDE {
+    return net::GetMimeTypeFromFile(relative_path_, mime_type);
+  }
+
+  virtual void GetResponseInfo(net::HttpResponseInfo* info) OVERRIDE {
+    std::string mime_type;
+    GetMimeType(&mime_type);
+    response_info_.headers = BuildHttpHeaders(mime_type, request()->method(),
+        reader_ ? relative_path_ : base::FilePath(), relative_path_,
+        is_authority_match_, NULL, false);
+    *info = response_info_;
+  }
+
+  virtual bool ReadRawData(net::IOBuffer* buf,
+                           int buf_size,
+                           int* bytes_read) OVERRIDE {
+    if (!reader_ || request()->method() != "GET") {
+      *bytes_read = 0;
+      return true;
+    }
+
+    // The reader is only used by one task at a time, since there's only one
+    // read pending at a time.
+    bool posted = base::PostTaskAndReplyWithResult(
+        file_task_runner_.get(),
+        FROM_HERE,
+        base::Bind(&ReadArchiveEntry, reader_, make_scoped_refptr(buf),
+                   buf_size),
+        base::Bind(&URLRequestApplicationArchiveJob::OnDataRead,
+                   weak_factory_.GetWeakPtr()));
+    DCHECK(posted);
+    SetStatus(net::URLRequestStatus(net::URLRequestStatus::IO_PENDING, 0));
+    return false;
+  }
+
+ private:
+  virtual ~URLRequestApplicationArchiveJob() {}
+
+  void OnEntryOpened(scoped_refptr<ApplicationArchive::EntryReader> reader) {
+    reader_ = reader;
+    if (reader_)
+      set_expected_content_size(reader_->size());
+    NotifyHeadersComplete();
+  }
+
+  void OnDataRead(int result) {
+    if (result < 0) {
+      NotifyDone(net::URLRequestStatus(net::URLRequestStatus::FAILED,
+                                       net::ERR_FAILED));
+      return;
+    }
+    SetStatus(net::URLRequestStatus());
+    NotifyReadComplete(result);
+  }
+
+  scoped_refptr<base::TaskRunner> file_task_runner_;
+  scoped_refptr<ApplicationArchive> archive_;
+  scoped_refptr<ApplicationArchive::EntryReader> reader_;
+  net::HttpResponseInfo response_info_;
+  base::FilePath relative_path_;
+  bool is_authority_match_;
+  base::WeakPtrFactory<URLRequestApplicationArchiveJob> weak_factory_;
+};
+
 class ApplicationProtocolHandler
     : public net::URLRequestJobFactory::ProtocolHandler {
  public:
   explicit ApplicationProtocolHandler(const Application* application)
-    : application_(application) {
+    : application_(application),
+      memory_cache_(new ResourceMemoryCache(kMemoryCacheSize)) {
     CHECK(application_);
+    // The manifest doesn't change while the application runs, so its main
+    // document is only generated once.
+    main_document_ = GenerateMainDocument(application_);
+    // Packed applications are served from their package.
+    if (application_->Path().MatchesExtension(
+            xwalk::application::kApplicationFileExtension))
+      archive_ = new ApplicationArchive(application_->Path());
   }
 
-  virtual ~ApplicationProtocolHandler() {}
+  virtual ~ApplicationProtocolHandler() {
+    VLOG(1) << "Application resources memory cache: "
+            << memory_cache_->hits() << " hits, "
+            << memory_cache_->misses() << " misses.";
+  }
 
   virtual net::URLRequestJob* MaybeCreateJob(
       net::URLRequest* request,
@@ -196,6 +541,9 @@ class ApplicationProtocolHandler
 
  private:
   const Application* application_;
+  scoped_refptr<ApplicationArchive> archive_;
+  scoped_refptr<ResourceMemoryCache> memory_cache_;
+  scoped_refptr<base::RefCountedString> main_document_;
   DISALLOW_COPY_AND_ASSIGN(ApplicationProtocolHandler);
 };
 
@@ -212,23 +560,40 @@ ApplicationProtocolHandler::MaybeCreateJob(
     directory_path = application_->Path();
 
   std::string path = request->url().path();
-  if (is_authority_match &&
+  if (is_authority_match && main_document_ &&
       path.size() > 1 &&
       path.substr(1) == xwalk::application::kGeneratedMainDocumentFilename) {
     return new GeneratedMainDocumentJob(request, network_delegate,
-        relative_path, application_);
+        relative_path, main_document_);
+  }
+
+  // Only the requests which can be served from the memory cache count.
+  bool is_cacheable = is_authority_match && !archive_ &&
+      !relative_path.empty() && request->method() == "GET";
+
+  scoped_refptr<base::TaskRunner> file_task_runner =
+      content::BrowserThread::GetBlockingPool()->
+      GetTaskRunnerWithShutdownBehavior(
+          base::SequencedWorkerPool::SKIP_ON_SHUTDOWN);
+  if (archive_) {
+    return new URLRequestApplicationArchiveJob(
+        request,
+        network_delegate,
+        file_task_runner,
+        archive_,
+        relative_path,
+        is_authority_match);
   }
 
   return new URLRequestApplicationJob(
       request,
       network_delegate,
-      content::BrowserThread::GetBlockingPool()->
-      GetTaskRunnerWithShutdownBehavior(
-          base::SequencedWorkerPool::SKIP_ON_SHUTDOWN),
+      file_task_runner,
       application_id,
       directory_path,
       relative_path,
-      is_authority_match);
+      is_authority_match,
+      is_cacheable ? memory_cache_ : NULL);
 }
 
 }  // namespace
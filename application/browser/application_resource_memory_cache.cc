@@ -0,0 +1,148 @@
+// Copyright (c) 2013 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "xwalk/application/browser/application_resource_memory_cache.h"
+
+#include <vector>
+
+#include "base/format_macros.h"
+#include "base/strings/string_split.h"
+#include "base/strings/string_util.h"
+#include "base/strings/stringprintf.h"
+#include "net/http/http_request_headers.h"
+
+namespace xwalk {
+namespace application {
+
+ResourceValidators GetResourceValidators(int64 size,
+                                         const base::Time& last_modified) {
+  ResourceValidators validators;
+  validators.etag = base::StringPrintf("\"%" PRIx64 "-%" PRIx64 "\"",
+      size, last_modified.ToInternalValue());
+  validators.last_modified = last_modified;
+  return validators;
+}
+
+std::string FormatHTTPDate(const base::Time& time) {
+  static const char* const kWeekdays[] = {
+    "Sun", "Mon", "Tue", "Wed", "Thu", "Fri", "Sat"
+  };
+  static const char* const kMonths[] = {
+    "Jan", "Feb", "Mar", "Apr", "May", "Jun",
+    "Jul", "Aug", "Sep", "Oct", "Nov", "Dec"
+  };
+  base::Time::Exploded exploded;
+  time.UTCExplode(&exploded);
+  return base::StringPrintf("%s, %02d %s %04d %02d:%02d:%02d GMT",
+                            kWeekdays[exploded.day_of_week],
+                            exploded.day_of_month,
+                            kMonths[exploded.month - 1],
+                            exploded.year,
+                            exploded.hour,
+                            exploded.minute,
+                            exploded.second);
+}
+
+bool IsNotModified(const net::HttpRequestHeaders& headers,
+                   const ResourceValidators& validators) {
+  if (validators.etag.empty())
+    return false;
+
+  std::string value;
+  if (headers.GetHeader(net::HttpRequestHeaders::kIfNoneMatch, &value)) {
+    std::vector<std::string> etags;
+    base::SplitString(value, ',', &etags);
+    for (size_t i = 0; i < etags.size(); ++i) {
+      std::string etag = etags[i];
+      if (etag == "*")
+        return true;
+      if (StartsWithASCII(etag, "W/", true))
+        etag = etag.substr(2);
+      if (etag == validators.etag)
+        return true;
+    }
+    return false;
+  }
+
+  // HTTP-dates have a resolution of one second.
+  base::Time since;
+  if (headers.GetHeader(net::HttpRequestHeaders::kIfModifiedSince, &value) &&
+      base::Time::FromString(value.c_str(), &since))
+    return validators.last_modified.ToTimeT() <= since.ToTimeT();
+  return false;
+}
+
+MemoryCachedResource::MemoryCachedResource(
+    const std::string& mime_type,
+    const ResourceValidators& validators)
+    : mime_type_(mime_type),
+      validators_(validators) {
+}
+
+MemoryCachedResource::~MemoryCachedResource() {
+}
+
+ResourceMemoryCache::ResourceMemoryCache(size_t max_size)
+    : resources_(ResourceMap::NO_AUTO_EVICT),
+      max_size_(max_size),
+      size_(0),
+      hits_(0),
+      misses_(0) {
+}
+
+ResourceMemoryCache::~ResourceMemoryCache() {
+}
+
+scoped_refptr<MemoryCachedResource> ResourceMemoryCache::Get(
+    const base::FilePath& relative_path,
+    const ResourceValidators& validators) {
+  base::AutoLock lock(lock_);
+  ResourceMap::iterator it = resources_.Get(relative_path);
+  if (it == resources_.end()) {
+    ++misses_;
+    return NULL;
+  }
+  if (it->second->validators().etag != validators.etag) {
+    size_ -= it->second->data().size();
+    resources_.Erase(it);
+    ++misses_;
+    return NULL;
+  }
+  ++hits_;
+  return it->second;
+}
+
+void ResourceMemoryCache::Put(
+    const base::FilePath& relative_path,
+    const scoped_refptr<MemoryCachedResource>& resource) {
+  base::AutoLock lock(lock_);
+  ResourceMap::iterator it = resources_.Peek(relative_path);
+  if (it != resources_.end())
+    size_ -= it->second->data().size();
+  resources_.Put(relative_path, resource);
+  size_ += resource->data().size();
+  while (size_ > max_size_) {
+    ResourceMap::reverse_iterator oldest = resources_.rbegin();
+    size_ -= oldest->second->data().size();
+    resources_.Erase(oldest);
+  }
+}
+
+int ResourceMemoryCache::hits() const {
+  base::AutoLock lock(lock_);
+  return hits_;
+}
+
+int ResourceMemoryCache::misses() const {
+  base::AutoLock lock(lock_);
+  return misses_;
+}
+
+size_t ResourceMemoryCache::size() const {
+  base::AutoLock lock(lock_);
+  return size_;
+}
+
+}  // namespace application
+}  // namespace xwalk
@@ -0,0 +1,114 @@
+// Copyright (c) 2013 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef XWALK_APPLICATION_BROWSER_APPLICATION_RESOURCE_MEMORY_CACHE_H_
+#define XWALK_APPLICATION_BROWSER_APPLICATION_RESOURCE_MEMORY_CACHE_H_
+
+#include <string>
+
+#include "base/basictypes.h"
+#include "base/containers/mru_cache.h"
+#include "base/files/file_path.h"
+#include "base/memory/ref_counted.h"
+#include "base/synchronization/lock.h"
+#include "base/time/time.h"
+
+namespace net {
+class HttpRequestHeaders;
+}
+
+namespace xwalk {
+namespace application {
+
+// The validators of a resource file, which let the resource be revalidated
+// instead of loaded again.
+struct ResourceValidators {
+  std::string etag;
+  base::Time last_modified;
+};
+
+// Returns the validators of a file of |size| bytes modified at
+// |last_modified|.
+ResourceValidators GetResourceValidators(int64 size,
+                                         const base::Time& last_modified);
+
+// Formats |time| as an HTTP-date, see RFC 2616 section 3.3.1.
+std::string FormatHTTPDate(const base::Time& time);
+
+// Returns whether the conditional |headers| of a request match |validators|,
+// so the resource doesn't need to be sent again. If-None-Match is a list of
+// entity tags, compared with the weak comparison function, and takes
+// precedence over If-Modified-Since, see RFC 2616 section 14.26.
+bool IsNotModified(const net::HttpRequestHeaders& headers,
+                   const ResourceValidators& validators);
+
+// A resource file small enough to be kept in memory.
+class MemoryCachedResource
+    : public base::RefCountedThreadSafe<MemoryCachedResource> {
+ public:
+  MemoryCachedResource(const std::string& mime_type,
+                       const ResourceValidators& validators);
+
+  const std::string& mime_type() const { return mime_type_; }
+  const ResourceValidators& validators() const { return validators_; }
+  std::string* mutable_data() { return &data_; }
+  const std::string& data() const { return data_; }
+
+ private:
+  friend class base::RefCountedThreadSafe<MemoryCachedResource>;
+  ~MemoryCachedResource();
+
+  std::string mime_type_;
+  ResourceValidators validators_;
+  std::string data_;
+
+  DISALLOW_COPY_AND_ASSIGN(MemoryCachedResource);
+};
+
+// The resource files of an application recently loaded, up to a total size,
+// so loading them again only takes a stat of the file to revalidate them.
+// It's used from the worker threads loading the resources.
+class ResourceMemoryCache
+    : public base::RefCountedThreadSafe<ResourceMemoryCache> {
+ public:
+  // Keeps up to |max_size| bytes of resources.
+  explicit ResourceMemoryCache(size_t max_size);
+
+  // Returns NULL and counts a miss if |relative_path| isn't cached, or if it
+  // was cached with other |validators| than the ones of the file now, in
+  // which case it's evicted.
+  scoped_refptr<MemoryCachedResource> Get(const base::FilePath& relative_path,
+                                          const ResourceValidators& validators);
+
+  // Caches |resource|, evicting the least recently used resources until the
+  // cache fits its maximum size.
+  void Put(const base::FilePath& relative_path,
+           const scoped_refptr<MemoryCachedResource>& resource);
+
+  int hits() const;
+  int misses() const;
+  // The total size of the resources cached.
+  size_t size() const;
+
+ private:
+  friend class base::RefCountedThreadSafe<ResourceMemoryCache>;
+  typedef base::MRUCache<base::FilePath, scoped_refptr<MemoryCachedResource> >
+      ResourceMap;
+
+  ~ResourceMemoryCache();
+
+  mutable base::Lock lock_;
+  ResourceMap resources_;
+  const size_t max_size_;
+  size_t size_;
+  int hits_;
+  int misses_;
+
+  DISALLOW_COPY_AND_ASSIGN(ResourceMemoryCache);
+};
+
+}  // namespace application
+}  // namespace xwalk
+
+#endif  // XWALK_APPLICATION_BROWSER_APPLICATION_RESOURCE_MEMORY_CACHE_H_
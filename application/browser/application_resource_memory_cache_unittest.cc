@@ -0,0 +1,134 @@
+// Copyright (c) 2013 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "xwalk/application/browser/application_resource_memory_cache.h"
+
+#include "net/http/http_request_headers.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace xwalk {
+namespace application {
+
+namespace {
+
+// Tue, 15 Nov 1994 08:12:31 GMT and a half.
+const double kLastModified = 784887151.5;
+
+scoped_refptr<MemoryCachedResource> CreateResource(size_t size) {
+  scoped_refptr<MemoryCachedResource> resource(
+      new MemoryCachedResource("text/html", ResourceValidators()));
+  resource->mutable_data()->assign(size, 'x');
+  return resource;
+}
+
+}  // namespace
+
+TEST(ApplicationResourceMemoryCacheTest, FormatHTTPDate) {
+  base::Time last_modified = base::Time::FromDoubleT(kLastModified);
+  std::string date = FormatHTTPDate(last_modified);
+  EXPECT_EQ("Tue, 15 Nov 1994 08:12:31 GMT", date);
+
+  base::Time parsed;
+  ASSERT_TRUE(base::Time::FromString(date.c_str(), &parsed));
+  EXPECT_EQ(last_modified.ToTimeT(), parsed.ToTimeT());
+}
+
+TEST(ApplicationResourceMemoryCacheTest, IfNoneMatch) {
+  ResourceValidators validators =
+      GetResourceValidators(42, base::Time::FromDoubleT(kLastModified));
+  net::HttpRequestHeaders headers;
+  EXPECT_FALSE(IsNotModified(headers, validators));
+
+  headers.SetHeader(net::HttpRequestHeaders::kIfNoneMatch, validators.etag);
+  EXPECT_TRUE(IsNotModified(headers, validators));
+  headers.SetHeader(net::HttpRequestHeaders::kIfNoneMatch, "*");
+  EXPECT_TRUE(IsNotModified(headers, validators));
+  headers.SetHeader(net::HttpRequestHeaders::kIfNoneMatch,
+                    "\"other\", W/" + validators.etag);
+  EXPECT_TRUE(IsNotModified(headers, validators));
+
+  // A tag starting with the one of the resource doesn't match it.
+  headers.SetHeader(net::HttpRequestHeaders::kIfNoneMatch,
+                    "\"other\", " + validators.etag + "x");
+  EXPECT_FALSE(IsNotModified(headers, validators));
+
+  // If-Modified-Since is ignored when If-None-Match doesn't match.
+  headers.SetHeader(net::HttpRequestHeaders::kIfModifiedSince,
+                    FormatHTTPDate(validators.last_modified));
+  EXPECT_FALSE(IsNotModified(headers, validators));
+
+  // The resources without validators are always sent.
+  headers.SetHeader(net::HttpRequestHeaders::kIfNoneMatch, "*");
+  EXPECT_FALSE(IsNotModified(headers, ResourceValidators()));
+}
+
+TEST(ApplicationResourceMemoryCacheTest, IfModifiedSince) {
+  base::Time last_modified = base::Time::FromDoubleT(kLastModified);
+  ResourceValidators validators = GetResourceValidators(42, last_modified);
+  net::HttpRequestHeaders headers;
+
+  // The date sent back by the client is truncated to the second.
+  headers.SetHeader(net::HttpRequestHeaders::kIfModifiedSince,
+                    FormatHTTPDate(last_modified));
+  EXPECT_TRUE(IsNotModified(headers, validators));
+  headers.SetHeader(net::HttpRequestHeaders::kIfModifiedSince,
+                    "Wed, 16 Nov 1994 00:00:00 GMT");
+  EXPECT_TRUE(IsNotModified(headers, validators));
+  headers.SetHeader(net::HttpRequestHeaders::kIfModifiedSince,
+                    "Tue, 15 Nov 1994 08:12:30 GMT");
+  EXPECT_FALSE(IsNotModified(headers, validators));
+  headers.SetHeader(net::HttpRequestHeaders::kIfModifiedSince, "invalid");
+  EXPECT_FALSE(IsNotModified(headers, validators));
+}
+
+TEST(ApplicationResourceMemoryCacheTest, EvictsLeastRecentlyUsed) {
+  scoped_refptr<ResourceMemoryCache> cache(new ResourceMemoryCache(100));
+  const base::FilePath first(FILE_PATH_LITERAL("first.html"));
+  const base::FilePath second(FILE_PATH_LITERAL("second.html"));
+  const base::FilePath third(FILE_PATH_LITERAL("third.html"));
+
+  cache->Put(first, CreateResource(40));
+  cache->Put(second, CreateResource(40));
+  EXPECT_EQ(80u, cache->size());
+
+  // Getting the first resource makes the second one the least recently used,
+  // so it's evicted for the third one to fit.
+  EXPECT_TRUE(cache->Get(first, ResourceValidators()));
+  cache->Put(third, CreateResource(40));
+  EXPECT_EQ(80u, cache->size());
+  EXPECT_TRUE(cache->Get(first, ResourceValidators()));
+  EXPECT_FALSE(cache->Get(second, ResourceValidators()));
+  EXPECT_TRUE(cache->Get(third, ResourceValidators()));
+  EXPECT_EQ(3, cache->hits());
+  EXPECT_EQ(1, cache->misses());
+
+  // Replacing a resource accounts for its new size only.
+  cache->Put(third, CreateResource(10));
+  EXPECT_EQ(50u, cache->size());
+
+  // A resource larger than the cache isn't kept.
+  cache->Put(second, CreateResource(101));
+  EXPECT_EQ(0u, cache->size());
+  EXPECT_FALSE(cache->Get(second, ResourceValidators()));
+}
+
+TEST(ApplicationResourceMemoryCacheTest, EvictsChangedResource) {
+  scoped_refptr<ResourceMemoryCache> cache(new ResourceMemoryCache(100));
+  const base::FilePath path(FILE_PATH_LITERAL("index.html"));
+  const base::Time last_modified = base::Time::FromDoubleT(kLastModified);
+  const ResourceValidators validators =
+      GetResourceValidators(40, last_modified);
+  cache->Put(path, new MemoryCachedResource("text/html", validators));
+  EXPECT_TRUE(cache->Get(path, validators));
+
+  // The file was modified since it was cached.
+  EXPECT_FALSE(cache->Get(path, GetResourceValidators(40,
+      last_modified + base::TimeDelta::FromSeconds(1))));
+  EXPECT_FALSE(cache->Get(path, validators));
+  EXPECT_EQ(1, cache->hits());
+  EXPECT_EQ(2, cache->misses());
+}
+
+}  // namespace application
+}  // namespace xwalk
@@ -4,13 +4,23 @@
 
 #include "xwalk/application/browser/application_service.h"
 
+#include <algorithm>
+#include <map>
 #include <string>
+#include <vector>
 
 #include "base/file_util.h"
+#include "base/files/file_enumerator.h"
+#include "base/memory/scoped_vector.h"
+#include "base/threading/simple_thread.h"
 #include "xwalk/application/browser/application_process_manager.h"
 #include "xwalk/application/browser/application_system.h"
+#include "xwalk/application/browser/installer/precompressed_resources.h"
 #include "xwalk/application/browser/installer/xpk_extractor.h"
+#include "xwalk/application/browser/installer/xpk_package.h"
 #include "xwalk/application/common/application_file_util.h"
+#include "xwalk/application/common/application_resource_cache.h"
+#include "xwalk/application/common/constants.h"
 #include "xwalk/runtime/browser/runtime_context.h"
 
 using xwalk::RuntimeContext;
@@ -21,9 +31,129 @@ namespace application {
 const base::FilePath::CharType kApplicationsDir[] =
     FILE_PATH_LITERAL("applications");
 
+const base::FilePath::CharType kSharedResourcesDir[] =
+    FILE_PATH_LITERAL(".shared");
+
+namespace {
+
+// Installing is mostly bound by the storage, more threads would mostly add
+// seeks.
+const int kMaxInstallThreads = 4;
+
+const base::FilePath::CharType kXPKFilePattern[] = FILE_PATH_LITERAL("*.xpk");
+
+// The application still works without the compressed copies, so failing to
+// write them isn't an error.
+void CompressResources(const base::FilePath& app_dir) {
+  int files_compressed = 0;
+  int64 bytes_saved = 0;
+  if (!WriteCompressedResources(app_dir, &files_compressed, &bytes_saved)) {
+    LOG(WARNING) << "Can't compress the resources of " << app_dir.value();
+    return;
+  }
+  LOG(INFO) << "Compressed " << files_compressed << " resources, "
+            << bytes_saved << " bytes less to read.";
+}
+
+// Copies the XPK package |path| of |app_id| to a temporary file of
+// |data_dir| and verifies the copy, rather than the source which could change
+// in the meantime. The caller moves the copy in place.
+bool CopyVerifiedPackage(const base::FilePath& path,
+                         const std::string& app_id,
+                         const base::FilePath& data_dir,
+                         base::FilePath* temp_path) {
+  if (!file_util::CreateTemporaryFileInDir(data_dir, temp_path) ||
+      !base::CopyFile(path, *temp_path)) {
+    LOG(ERROR) << "Can't copy " << path.value();
+    base::DeleteFile(*temp_path, false);
+    return false;
+  }
+
+  scoped_ptr<XPKPackage> package = XPKPackage::Create(*temp_path);
+  if (!package || package->Id() != app_id || !package->Verify()) {
+    LOG(ERROR) << "XPK file is invalid.";
+    base::DeleteFile(*temp_path, false);
+    return false;
+  }
+  return true;
+}
+
+// Verifies, extracts and loads a package of a batch in an install thread.
+class BatchPackageExtractor : public base::DelegateSimpleThread::Delegate {
+ public:
+  BatchPackageExtractor(const base::FilePath& path,
+                        const std::string& id,
+                        const base::FilePath& unpacked_dir,
+                        SharedResourceStore* shared_resources,
+                        bool compress_resources,
+                        size_t result_index)
+      : path_(path),
+        id_(id),
+        unpacked_dir_(unpacked_dir),
+        shared_resources_(shared_resources),
+        compress_resources_(compress_resources),
+        result_index_(result_index),
+        bytes_saved_(0) {
+  }
+
+  virtual void Run() OVERRIDE {
+    scoped_refptr<XPKExtractor> extractor = XPKExtractor::Create(path_);
+    if (!extractor || extractor->GetPackageID() != id_ ||
+        !extractor->ExtractTo(unpacked_dir_)) {
+      error_ = "XPK file is invalid.";
+      return;
+    }
+    application_ = LoadApplication(unpacked_dir_, id_, Manifest::COMMAND_LINE,
+                                   &error_);
+    if (application_ && compress_resources_)
+      CompressResources(unpacked_dir_);
+    if (application_ && shared_resources_ &&
+        !shared_resources_->ShareFiles(unpacked_dir_, &bytes_saved_))
+      LOG(WARNING) << "Can't share the resources of " << id_;
+  }
+
+  const base::FilePath& path() const { return path_; }
+  const base::FilePath& unpacked_dir() const { return unpacked_dir_; }
+  size_t result_index() const { return result_index_; }
+  scoped_refptr<Application> application() const { return application_; }
+  const std::string& error() const { return error_; }
+  int64 bytes_saved() const { return bytes_saved_; }
+
+ private:
+  base::FilePath path_;
+  std::string id_;
+  base::FilePath unpacked_dir_;
+  SharedResourceStore* shared_resources_;
+  bool compress_resources_;
+  size_t result_index_;
+  int64 bytes_saved_;
+  scoped_refptr<Application> application_;
+  std::string error_;
+
+  DISALLOW_COPY_AND_ASSIGN(BatchPackageExtractor);
+};
+
+}  // namespace
+
+ApplicationService::BatchInstallResult::BatchInstallResult()
+    : succeeded(false),
+      already_installed(false) {
+}
+
 ApplicationService::ApplicationService(RuntimeContext* runtime_context)
     : runtime_context_(runtime_context),
-      app_store_(new ApplicationStore(runtime_context)) {
+      app_store_(new ApplicationStore(runtime_context->GetPath())),
+      compress_resources_(false) {
+  // An install or update killed while replacing an application directory
+  // can leave it renamed away, it's restored before anything uses it.
+  const base::FilePath data_dir =
+      runtime_context->GetPath().Append(kApplicationsDir);
+  if (base::DirectoryExists(data_dir))
+    XPKExtractor::RecoverInterruptedReplaces(data_dir);
+
+  const base::FilePath shared_dir = data_dir.Append(kSharedResourcesDir);
+  if (SharedResourceStore::IsSupported() && base::DirectoryExists(shared_dir))
+    shared_resources_.reset(new SharedResourceStore(shared_dir));
 }
 
 ApplicationService::~ApplicationService() {
@@ -46,10 +176,9 @@ bool ApplicationService::Install(const base::FilePath& path, std::string* id) {
   base::FilePath unpacked_dir;
   std::string app_id;
   if (!base::DirectoryExists(path)) {
-    scoped_refptr<XPKExtractor> extractor = XPKExtractor::Create(path);
-    if (extractor)
-      app_id = extractor->GetPackageID();
-
+    // Only the header is read to know whether the package is installed
+    // already, it's mapped and verified when it's extracted.
+    app_id = XPKPackage::ReadID(path);
     if (app_id.empty()) {
       LOG(ERROR) << "XPK file is invalid.";
       return false;
@@ -61,14 +190,25 @@ bool ApplicationService::Install(const base::FilePath& path, std::string* id) {
       return true;
     }
 
-    base::FilePath temp_dir;
-    extractor->Extract(&temp_dir);
-    unpacked_dir = data_dir.AppendASCII(app_id);
-    if (base::DirectoryExists(unpacked_dir) &&
-        !base::DeleteFile(unpacked_dir, true))
+    scoped_refptr<XPKExtractor> extractor = XPKExtractor::Create(path);
+    if (!extractor || extractor->GetPackageID() != app_id) {
+      LOG(ERROR) << "XPK file is invalid.";
       return false;
-    if (!base::Move(temp_dir, unpacked_dir))
+    }
+
+    unpacked_dir = data_dir.AppendASCII(app_id);
+    if (!extractor->ExtractTo(unpacked_dir))
       return false;
+
+    // The compressed copies are shared too.
+    if (compress_resources_)
+      CompressResources(unpacked_dir);
+
+    int64 bytes_saved = 0;
+    if (shared_resources_ &&
+        shared_resources_->ShareFiles(unpacked_dir, &bytes_saved)) {
+      LOG(INFO) << "Sharing resources saved " << bytes_saved << " bytes.";
+    }
   } else {
     unpacked_dir = path;
   }
@@ -96,12 +236,290 @@ bool ApplicationService::Install(const base::FilePath& path, std::string* id) {
   return false;
 }
 
+bool ApplicationService::InstallPacked(const base::FilePath& path,
+                                       std::string* id) {
+  const std::string app_id = XPKPackage::ReadID(path);
+  if (app_id.empty()) {
+    LOG(ERROR) << "XPK file is invalid.";
+    return false;
+  }
+
+  if (app_store_->Contains(app_id)) {
+    *id = app_id;
+    LOG(INFO) << "Already installed: " << app_id;
+    return true;
+  }
+
+  const base::FilePath data_dir =
+      runtime_context_->GetPath().Append(kApplicationsDir);
+  if (!base::DirectoryExists(data_dir) &&
+      !file_util::CreateDirectory(data_dir))
+    return false;
+
+  // The copy is renamed in place only once it's verified.
+  base::FilePath temp_path;
+  if (!CopyVerifiedPackage(path, app_id, data_dir, &temp_path))
+    return false;
+
+  const base::FilePath package_path =
+      data_dir.AppendASCII(app_id).AddExtension(kApplicationFileExtension);
+  if (!base::Move(temp_path, package_path)) {
+    LOG(ERROR) << "Can't move the package to " << package_path.value();
+    base::DeleteFile(temp_path, false);
+    return false;
+  }
+
+  std::string error;
+  scoped_refptr<Application> application =
+      LoadPackedApplication(package_path,
+                            app_id,
+                            Manifest::COMMAND_LINE,
+                            &error);
+  if (!application || !app_store_->AddApplication(application)) {
+    LOG(ERROR) << "Error during application installation: " << error;
+    base::DeleteFile(package_path, false);
+    return false;
+  }
+
+  LOG(INFO) << "Installed packed application with id: " << app_id
+            << " successfully.";
+  *id = app_id;
+  return true;
+}
+
+bool ApplicationService::InstallBatch(
+    const std::vector<base::FilePath>& paths,
+    std::vector<BatchInstallResult>* results) {
+  const base::FilePath data_dir =
+      runtime_context_->GetPath().Append(kApplicationsDir);
+  if (!base::DirectoryExists(data_dir) &&
+      !file_util::CreateDirectory(data_dir))
+    return false;
+
+  std::vector<base::FilePath> packages;
+  for (size_t i = 0; i < paths.size(); ++i) {
+    if (!base::DirectoryExists(paths[i])) {
+      packages.push_back(paths[i]);
+      continue;
+    }
+    std::vector<base::FilePath> directory_packages;
+    base::FileEnumerator enumerator(
+        paths[i], false, base::FileEnumerator::FILES, kXPKFilePattern);
+    for (base::FilePath package = enumerator.Next(); !package.empty();
+         package = enumerator.Next())
+      directory_packages.push_back(package);
+    std::sort(directory_packages.begin(), directory_packages.end());
+    packages.insert(packages.end(),
+                    directory_packages.begin(), directory_packages.end());
+  }
+
+  // Only the headers are read in this thread, to skip the packages that are
+  // invalid or installed already.
+  ScopedVector<BatchPackageExtractor> extractors;
+  // The index in |results| of the package installing each id, the later
+  // packages with the same id get its result.
+  std::map<std::string, size_t> installing_results;
+  std::vector<size_t> duplicate_results;
+  size_t first_result = results->size();
+  for (size_t i = 0; i < packages.size(); ++i) {
+    BatchInstallResult result;
+    result.path = packages[i];
+    result.id = XPKPackage::ReadID(packages[i]);
+    if (result.id.empty()) {
+      LOG(ERROR) << "XPK file is invalid: " << packages[i].value();
+    } else if (app_store_->Contains(result.id)) {
+      LOG(INFO) << "Already installed: " << result.id;
+      result.succeeded = true;
+      result.already_installed = true;
+    } else if (installing_results.count(result.id)) {
+      result.already_installed = true;
+      duplicate_results.push_back(results->size());
+    } else {
+      installing_results[result.id] = results->size();
+      extractors.push_back(new BatchPackageExtractor(
+          packages[i], result.id, data_dir.AppendASCII(result.id),
+          shared_resources_.get(), compress_resources_, results->size()));
+    }
+    results->push_back(result);
+  }
+
+  if (!extractors.empty()) {
+    base::DelegateSimpleThreadPool pool(
+        "XPKInstaller",
+        std::min(kMaxInstallThreads, static_cast<int>(extractors.size())));
+    pool.Start();
+    for (size_t i = 0; i < extractors.size(); ++i)
+      pool.AddWork(extractors[i]);
+    pool.JoinAll();
+  }
+
+  std::vector<scoped_refptr<const Application> > applications;
+  std::vector<BatchPackageExtractor*> loaded;
+  std::vector<BatchPackageExtractor*> failed;
+  int64 bytes_saved = 0;
+  for (size_t i = 0; i < extractors.size(); ++i) {
+    if (extractors[i]->application()) {
+      applications.push_back(extractors[i]->application());
+      loaded.push_back(extractors[i]);
+      bytes_saved += extractors[i]->bytes_saved();
+    } else {
+      LOG(ERROR) << "Error during installation of "
+                 << extractors[i]->path().value() << ": "
+                 << extractors[i]->error();
+      failed.push_back(extractors[i]);
+    }
+  }
+
+  if (shared_resources_)
+    LOG(INFO) << "Sharing resources saved " << bytes_saved << " bytes.";
+
+  std::vector<bool> added;
+  if (!app_store_->AddApplications(applications, &added))
+    LOG(ERROR) << "Some of the installed applications couldn't be stored.";
+  for (size_t i = 0; i < loaded.size(); ++i) {
+    if (added[i])
+      (*results)[loaded[i]->result_index()].succeeded = true;
+    else
+      failed.push_back(loaded[i]);
+  }
+
+  // Nothing refers to the files of the packages which failed.
+  for (size_t i = 0; i < failed.size(); ++i)
+    base::DeleteFile(failed[i]->unpacked_dir(), true);
+  if (!failed.empty() && shared_resources_)
+    shared_resources_->DeleteUnusedFiles();
+
+  for (size_t i = 0; i < duplicate_results.size(); ++i) {
+    BatchInstallResult& result = (*results)[duplicate_results[i]];
+    result.succeeded = (*results)[installing_results[result.id]].succeeded;
+  }
+
+  for (size_t i = first_result; i < results->size(); ++i) {
+    if (!(*results)[i].succeeded)
+      return false;
+  }
+  return true;
+}
+
+bool ApplicationService::Update(const base::FilePath& path, std::string* id) {
+  const std::string app_id = XPKPackage::ReadID(path);
+  if (app_id.empty()) {
+    LOG(ERROR) << "XPK file is invalid.";
+    return false;
+  }
+
+  if (!app_store_->Contains(app_id)) {
+    LOG(ERROR) << "Cannot update application with id " << app_id
+               << "; application is not installed.";
+    return false;
+  }
+
+  const base::FilePath data_dir =
+      runtime_context_->GetPath().Append(kApplicationsDir);
+  const base::FilePath package_path =
+      data_dir.AppendASCII(app_id).AddExtension(kApplicationFileExtension);
+  if (base::PathExists(package_path))
+    return UpdatePacked(path, app_id, package_path, id);
+
+  scoped_refptr<XPKExtractor> extractor = XPKExtractor::Create(path);
+  if (!extractor || extractor->GetPackageID() != app_id) {
+    LOG(ERROR) << "XPK file is invalid.";
+    return false;
+  }
+
+  // The files are updated before the store, so if the update is interrupted
+  // in between, updating again finds them unchanged and only fixes the store.
+  const base::FilePath unpacked_dir = data_dir.AppendASCII(app_id);
+  XPKExtractor::UpdateStats stats;
+  if (!extractor->UpdateTo(unpacked_dir, &stats))
+    return false;
+  ApplicationResourceCache::GetInstance()->Invalidate(app_id);
+
+  // The compressed copies aren't in the package, the update dropped them.
+  if (compress_resources_)
+    CompressResources(unpacked_dir);
+
+  // The changed files aren't shared yet, and the previous ones may not be
+  // used anymore.
+  if (shared_resources_) {
+    int64 bytes_saved = 0;
+    shared_resources_->ShareFiles(unpacked_dir, &bytes_saved);
+    shared_resources_->DeleteUnusedFiles();
+  }
+
+  std::string error;
+  scoped_refptr<Application> application =
+      LoadApplication(unpacked_dir,
+                      app_id,
+                      Manifest::COMMAND_LINE,
+                      &error);
+  if (!application) {
+    LOG(ERROR) << "Error during application update: " << error;
+    return false;
+  }
+
+  if (!app_store_->UpdateApplication(application)) {
+    LOG(ERROR) << "Application with id " << app_id
+               << " couldn't be updated.";
+    return false;
+  }
+
+  LOG(INFO) << "Updated application with id: " << app_id << " ("
+            << stats.files_written << " files written, "
+            << stats.files_linked << " unchanged, "
+            << stats.files_removed << " removed).";
+  *id = app_id;
+  return true;
+}
+
+bool ApplicationService::UpdatePacked(const base::FilePath& path,
+                                      const std::string& app_id,
+                                      const base::FilePath& package_path,
+                                      std::string* id) {
+  base::FilePath temp_path;
+  if (!CopyVerifiedPackage(path, app_id, package_path.DirName(), &temp_path))
+    return false;
+
+  // The new manifest is checked before the installed package is replaced.
+  std::string error;
+  if (!LoadPackedApplication(temp_path, app_id, Manifest::COMMAND_LINE,
+                             &error)) {
+    LOG(ERROR) << "Error during application update: " << error;
+    base::DeleteFile(temp_path, false);
+    return false;
+  }
+
+  // The rename replaces the package at once, a running application keeps
+  // serving the previous one it mapped.
+  if (!base::Move(temp_path, package_path)) {
+    LOG(ERROR) << "Can't move the package to " << package_path.value();
+    base::DeleteFile(temp_path, false);
+    return false;
+  }
+
+  scoped_refptr<Application> application =
+      LoadPackedApplication(package_path,
+                            app_id,
+                            Manifest::COMMAND_LINE,
+                            &error);
+  if (!application || !app_store_->UpdateApplication(application)) {
+    LOG(ERROR) << "Application with id " << app_id
+               << " couldn't be updated.";
+    return false;
+  }
+
+  LOG(INFO) << "Updated packed application with id: " << app_id;
+  *id = app_id;
+  return true;
+}
+
 bool ApplicationService::Uninstall(const std::string& id) {
   if (!app_store_->RemoveApplication(id)) {
     LOG(ERROR) << "Cannot uninstall application with id " << id
                << "; application is not installed.";
     return false;
   }
+  ApplicationResourceCache::GetInstance()->Invalidate(id);
 
   const base::FilePath resources =
       runtime_context_->GetPath().Append(kApplicationsDir).AppendASCII(id);
@@ -111,6 +529,18 @@ bool ApplicationService::Uninstall(const std::string& id) {
                << id << "; Cannot remove all resources.";
     return false;
   }
+
+  const base::FilePath package = runtime_context_->GetPath()
+      .Append(kApplicationsDir).AppendASCII(id)
+      .AddExtension(kApplicationFileExtension);
+  if (base::PathExists(package) && !base::DeleteFile(package, false)) {
+    LOG(ERROR) << "Error occurred while trying to remove application with id "
+               << id << "; Cannot remove its package.";
+    return false;
+  }
+
+  if (shared_resources_)
+    shared_resources_->DeleteUnusedFiles();
   return true;
 }
 
@@ -121,10 +551,18 @@ bool ApplicationService::Launch(const std::string& id) {
     return false;
   }
 
+  // The application must be known before its runtime is created, since the
+  // requests to the application scheme are served from it. Only this
+  // application is read from the store at this point.
   application_ = application;
-  return runtime_context_->GetApplicationSystem()->
-      process_manager()->LaunchApplication(runtime_context_,
-                                           application.get());
+  ApplicationProcessManager* process_manager =
+      runtime_context_->GetApplicationSystem()->process_manager();
+  LaunchDescriptor descriptor;
+  if (app_store_->GetLaunchDescriptor(id, &descriptor))
+    return process_manager->LaunchApplication(runtime_context_,
+                                              application.get(), descriptor);
+  return process_manager->LaunchApplication(runtime_context_,
+                                            application.get());
 }
 
 bool ApplicationService::Launch(const base::FilePath& path) {
@@ -146,11 +584,41 @@ bool ApplicationService::Launch(const base::FilePath& path) {
                                            application.get());
 }
 
+bool ApplicationService::EnableResourceSharing() {
+  if (shared_resources_)
+    return true;
+
+  if (!SharedResourceStore::IsSupported()) {
+    LOG(ERROR) << "Sharing resources isn't supported on this platform.";
+    return false;
+  }
+
+  const base::FilePath shared_dir = runtime_context_->GetPath()
+      .Append(kApplicationsDir).Append(kSharedResourcesDir);
+  if (!file_util::CreateDirectory(shared_dir)) {
+    LOG(ERROR) << "Can't create " << shared_dir.value();
+    return false;
+  }
+  shared_resources_.reset(new SharedResourceStore(shared_dir));
+  return true;
+}
+
+bool ApplicationService::GetSharedResourceReport(
+    SharedResourceStore::Report* report) const {
+  return shared_resources_ && shared_resources_->GetReport(report);
+}
+
 ApplicationStore::ApplicationMap*
 ApplicationService::GetInstalledApplications() const {
   return app_store_->GetInstalledApplications();
 }
 
+bool ApplicationService::QueryApplications(
+    const ApplicationQuery& query,
+    std::vector<ApplicationSummary>* results) const {
+  return app_store_->QueryApplications(query, results);
+}
+
 scoped_refptr<const Application> ApplicationService::GetApplicationByID(
     const std::string& id) const {
   return app_store_->GetApplicationByID(id);
@@ -6,10 +6,12 @@
 #define XWALK_APPLICATION_BROWSER_APPLICATION_SERVICE_H_
 
 #include <string>
+#include <vector>
 
 #include "base/memory/scoped_ptr.h"
 #include "base/files/file_path.h"
 #include "xwalk/application/browser/application_store.h"
+#include "xwalk/application/browser/installer/shared_resource_store.h"
 #include "xwalk/runtime/browser/runtime_context.h"
 #include "xwalk/application/common/application.h"
 
@@ -27,20 +29,72 @@ class ApplicationService {
   explicit ApplicationService(xwalk::RuntimeContext* runtime_context);
   virtual ~ApplicationService();
 
+  struct BatchInstallResult {
+    BatchInstallResult();
+
+    base::FilePath path;
+    std::string id;
+    bool succeeded;
+    // Whether the application was installed before the batch, or by an
+    // earlier package of the batch. Nothing was extracted for this package.
+    bool already_installed;
+  };
+
   bool Install(const base::FilePath& path, std::string* id);
+  // Installs the XPK package |path| without extracting it: the package is
+  // verified and copied, and the application resources are served from it.
+  bool InstallPacked(const base::FilePath& path, std::string* id);
+  // Installs the XPK packages in |paths|, and the ones in the directories in
+  // |paths|. The packages are verified and extracted in parallel and added to
+  // the store in a single transaction. Fills |results| with an entry for each
+  // package, in order, and returns false if any of them failed. Packages
+  // already installed succeed without being extracted again. The files of
+  // the packages which failed are deleted.
+  bool InstallBatch(const std::vector<base::FilePath>& paths,
+                    std::vector<BatchInstallResult>* results);
+  // Updates the installed application to the XPK package |path|, which must
+  // have the same id. Only the files changed since the installed version are
+  // written, see XPKExtractor::UpdateTo(). An application installed packed
+  // gets its package replaced like InstallPacked() copies it.
+  bool Update(const base::FilePath& path, std::string* id);
   bool Uninstall(const std::string& id);
   bool Launch(const std::string& id);
   bool Launch(const base::FilePath& path);
 
+  // Stores the files of the applications installed from now on once for
+  // identical content across applications, see SharedResourceStore. Stays
+  // enabled for the next runs. Fails on the platforms where sharing isn't
+  // supported.
+  bool EnableResourceSharing();
+  // Returns false if resource sharing isn't enabled.
+  bool GetSharedResourceReport(SharedResourceStore::Report* report) const;
+
+  // Writes a compressed copy of the text resources of the applications
+  // installed or updated from now on, see WriteCompressedResources().
+  void set_compress_resources(bool compress_resources) {
+    compress_resources_ = compress_resources;
+  }
+
   scoped_refptr<const Application> GetApplicationByID(
        const std::string& id) const;
   ApplicationStore::ApplicationMap* GetInstalledApplications() const;
+  bool QueryApplications(const ApplicationQuery& query,
+                         std::vector<ApplicationSummary>* results) const;
   // Currently there's only one running application at a time.
   const Application* GetRunningApplication() const;
 
  private:
+  // Updates the application |app_id| installed packed as |package_path|.
+  bool UpdatePacked(const base::FilePath& path,
+                    const std::string& app_id,
+                    const base::FilePath& package_path,
+                    std::string* id);
+
   xwalk::RuntimeContext* runtime_context_;
   scoped_ptr<ApplicationStore> app_store_;
+  // Only created when resource sharing is enabled.
+  scoped_ptr<SharedResourceStore> shared_resources_;
+  bool compress_resources_;
   scoped_refptr<const Application> application_;
 
   DISALLOW_COPY_AND_ASSIGN(ApplicationService);
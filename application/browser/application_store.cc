@@ -5,9 +5,9 @@
 #include "xwalk/application/browser/application_store.h"
 
 #include <utility>
+#include <vector>
 
 #include "xwalk/application/common/application_file_util.h"
-#include "xwalk/runtime/browser/runtime_context.h"
 
 namespace xwalk {
 namespace application {
@@ -18,12 +18,11 @@ const char ApplicationStore::kApplicationPath[] = "path";
 
 const char ApplicationStore::kInstallTime[] = "install_time";
 
-ApplicationStore::ApplicationStore(xwalk::RuntimeContext* runtime_context)
-    : runtime_context_(runtime_context),
-      db_store_(new DBStoreImpl(runtime_context->GetPath())),
+ApplicationStore::ApplicationStore(const base::FilePath& data_path)
+    : db_store_(new DBStoreImpl(data_path)),
+      db_initialized_(false),
       applications_(new ApplicationMap) {
   db_store_->AddObserver(this);
-  db_store_->InitDB();
 }
 
 ApplicationStore::~ApplicationStore() {
@@ -42,11 +41,65 @@ bool ApplicationStore::AddApplication(
   return true;
 }
 
+bool ApplicationStore::AddApplications(
+    const std::vector<scoped_refptr<const Application> >& applications,
+    std::vector<bool>* added) {
+  InitDBIfNeeded();
+  added->assign(applications.size(), false);
+  std::vector<bool> stored_before(applications.size());
+  db_store_->BeginBatch();
+  bool succeeded = true;
+  for (size_t i = 0; i < applications.size(); ++i) {
+    stored_before[i] = Contains(applications[i]->ID());
+    (*added)[i] = AddApplication(applications[i]);
+    if (!(*added)[i])
+      succeeded = false;
+  }
+  if (!db_store_->EndBatch()) {
+    // The database cache was rolled back with the transaction, see
+    // DBStore::EndBatch().
+    for (size_t i = 0; i < applications.size(); ++i) {
+      if (!stored_before[i]) {
+        applications_->erase(applications[i]->ID());
+        (*added)[i] = false;
+      }
+    }
+    return false;
+  }
+  return succeeded;
+}
+
+bool ApplicationStore::UpdateApplication(
+    scoped_refptr<const Application> application) {
+  const std::string& id = application->ID();
+  if (!Contains(id)) {
+    LOG(ERROR) << "Application " << id << " is not installed.";
+    return false;
+  }
+
+  db_store_->BeginBatch();
+  db_store_->SetValue(
+      id + "." + kManifestPath,
+      application->GetManifest()->value()->DeepCopy());
+  db_store_->SetValue(
+      id + "." + kApplicationPath,
+      new base::StringValue(application->Path().value()));
+  if (!db_store_->EndBatch()) {
+    LOG(ERROR) << "Error occurred while trying to update application "
+                  "information with id " << id << " in database.";
+    return false;
+  }
+
+  (*applications_)[id] = application;
+  return true;
+}
+
 bool ApplicationStore::RemoveApplication(const std::string& id) {
-  if (applications_->erase(id) != 1) {
+  if (!Contains(id)) {
     LOG(ERROR) << "Application " << id << " is invalid.";
     return false;
   }
+  applications_->erase(id);
 
   if (!db_store_->Remove(id)) {
     LOG(ERROR) << "Error occurred while trying to remove application"
@@ -58,7 +111,9 @@ bool ApplicationStore::RemoveApplication(const std::string& id) {
 }
 
 bool ApplicationStore::Contains(const std::string& app_id) const {
-  return applications_->find(app_id) != applications_->end();
+  InitDBIfNeeded();
+  return applications_->find(app_id) != applications_->end() ||
+         db_store_->HasApplication(app_id);
 }
 
 scoped_refptr<const Application> ApplicationStore::GetApplicationByID(
@@ -68,61 +123,99 @@ scoped_refptr<const Application> ApplicationStore::GetApplicationByID(
     return it->second;
   }
 
-  return NULL;
+  // Before the database is loaded, only this application is read.
+  if (!db_initialized_ && !db_store_->PreloadApplication(application_id))
+    return NULL;
+
+  return LoadApplication(application_id);
+}
+
+bool ApplicationStore::GetLaunchDescriptor(
+    const std::string& application_id,
+    LaunchDescriptor* descriptor) const {
+  return db_store_->GetLaunchDescriptor(application_id, descriptor);
 }
 
 ApplicationStore::ApplicationMap*
 ApplicationStore::GetInstalledApplications() const {
+  InitDBIfNeeded();
+  const base::DictionaryValue* db = db_store_->GetApplications();
+  if (db) {
+    for (base::DictionaryValue::Iterator it(*db); !it.IsAtEnd();
+         it.Advance()) {
+      if (applications_->find(it.key()) == applications_->end())
+        LoadApplication(it.key());
+    }
+  }
   return applications_.get();
 }
 
-void ApplicationStore::InitApplications(const base::DictionaryValue* db) {
-  CHECK(db);
-
-  for (base::DictionaryValue::Iterator it(*db); !it.IsAtEnd();
-       it.Advance()) {
-    const std::string& id = it.key();
-    const base::DictionaryValue* value;
-    const base::DictionaryValue* manifest;
-    std::string app_path;
-    if (!it.value().GetAsDictionary(&value) ||
-        !value->GetString(ApplicationStore::kApplicationPath, &app_path) ||
-        !value->GetDictionary(ApplicationStore::kManifestPath, &manifest))
-      break;
-
-    std::string error;
-    scoped_refptr<Application> application =
-        Application::Create(base::FilePath::FromUTF8Unsafe(app_path),
-                            Manifest::INTERNAL,
-                            *manifest,
-                            id,
-                            &error);
-    if (!application) {
-      LOG(ERROR) << "Load appliation error: " << error;
-      break;
-    }
+bool ApplicationStore::QueryApplications(
+    const ApplicationQuery& query,
+    std::vector<ApplicationSummary>* results) const {
+  InitDBIfNeeded();
+  return db_store_->QueryApplications(query, results);
+}
 
-    if (!Insert(application)) {
-      LOG(ERROR) << "An error occurred while"
-                    "initializing the application data.";
-      break;
-    }
+scoped_refptr<const Application> ApplicationStore::LoadApplication(
+    const std::string& application_id) const {
+  const base::DictionaryValue* value =
+      db_store_->GetApplicationValue(application_id);
+  if (!value)
+    return NULL;
+
+  const base::DictionaryValue* manifest;
+  std::string app_path;
+  if (!value->GetString(ApplicationStore::kApplicationPath, &app_path) ||
+      !value->GetDictionary(ApplicationStore::kManifestPath, &manifest)) {
+    LOG(ERROR) << "Invalid information stored for application "
+               << application_id;
+    return NULL;
+  }
+
+  std::string error;
+  scoped_refptr<Application> application =
+      Application::Create(base::FilePath::FromUTF8Unsafe(app_path),
+                          Manifest::INTERNAL,
+                          *manifest,
+                          application_id,
+                          &error);
+  if (!application) {
+    LOG(ERROR) << "Load appliation error: " << error;
+    return NULL;
+  }
+
+  if (!Insert(application)) {
+    LOG(ERROR) << "An error occurred while"
+                  "initializing the application data.";
+    return NULL;
   }
+  return application;
 }
 
-bool ApplicationStore::Insert(scoped_refptr<const Application> application) {
+bool ApplicationStore::Insert(
+    scoped_refptr<const Application> application) const {
   return applications_->insert(
       std::pair<std::string, scoped_refptr<const Application> >(
           application->ID(), application)).second;
 }
 
+void ApplicationStore::InitDBIfNeeded() const {
+  if (db_initialized_)
+    return;
+  // Not retried on failure, the changes would fail the same way.
+  db_initialized_ = true;
+  db_store_->InitDB();
+}
+
 void ApplicationStore::OnDBValueChanged(const std::string& key,
                                         const base::Value* value) {
 }
 
 void ApplicationStore::OnInitializationCompleted(bool succeeded) {
-  if (succeeded)
-    InitApplications(db_store_->GetApplications());
+  // Applications are created on demand, see LoadApplication().
+  if (!succeeded)
+    LOG(ERROR) << "Unable to load the installed applications.";
 }
 
 }  // namespace application
@@ -7,19 +7,20 @@
 
 #include <map>
 #include <string>
+#include <vector>
 
+#include "base/files/file_path.h"
 #include "base/memory/ref_counted.h"
 #include "xwalk/application/common/application.h"
 #include "xwalk/application/common/db_store_sqlite_impl.h"
 
-namespace xwalk {
-class Runtime;
-class RuntimeContext;
-}
-
 namespace xwalk {
 namespace application {
 
+// Keeps track of the installed applications. The database is loaded the
+// first time it's needed, and then only the lightweight records are read: an
+// Application is created the first time it is requested. Launching a single
+// application only reads that application, see GetLaunchDescriptor().
 class ApplicationStore: public DBStore::Observer {
  public:
   typedef DBStoreSqliteImpl DBStoreImpl;
@@ -33,11 +34,24 @@ class ApplicationStore: public DBStore::Observer {
   static const char kApplicationPath[];
   static const char kInstallTime[];
 
-  explicit ApplicationStore(xwalk::RuntimeContext* runtime_context);
+  // |data_path| is the directory of the applications database.
+  explicit ApplicationStore(const base::FilePath& data_path);
   virtual ~ApplicationStore();
 
   bool AddApplication(scoped_refptr<const Application> application);
 
+  // Adds |applications| in a single database transaction, which saves a sync
+  // per application. Sets each entry of |added| to whether the application
+  // is in the store afterwards. Returns false if any of them could not be
+  // added. If the transaction fails none of the new ones is added.
+  bool AddApplications(
+      const std::vector<scoped_refptr<const Application> >& applications,
+      std::vector<bool>* added);
+
+  // Replaces the stored manifest of the installed application with the one
+  // of |application|, keeping its install time.
+  bool UpdateApplication(scoped_refptr<const Application> application);
+
   bool RemoveApplication(const std::string& id);
 
   bool Contains(const std::string& app_id) const;
@@ -45,18 +59,33 @@ class ApplicationStore: public DBStore::Observer {
   scoped_refptr<const Application> GetApplicationByID(
       const std::string& application_id) const;
 
+  // Gets the launch descriptor stored when the application was installed,
+  // without loading the database.
+  bool GetLaunchDescriptor(const std::string& application_id,
+                           LaunchDescriptor* descriptor) const;
+
+  // Creates all the installed applications not requested yet.
   ApplicationMap* GetInstalledApplications() const;
 
+  // Selects installed applications using the database indexes, without
+  // creating them. Prefer it to GetInstalledApplications() when only the
+  // name, version or install time of the applications is needed.
+  bool QueryApplications(const ApplicationQuery& query,
+                         std::vector<ApplicationSummary>* results) const;
+
   // Implement the DBStore::Observer.
   virtual void OnDBValueChanged(const std::string& key,
                                 const base::Value* value) OVERRIDE;
   virtual void OnInitializationCompleted(bool succeeded) OVERRIDE;
 
  private:
-  void InitApplications(const base::DictionaryValue* value);
-  bool Insert(scoped_refptr<const Application> application);
-  xwalk::RuntimeContext* runtime_context_;
+  scoped_refptr<const Application> LoadApplication(
+      const std::string& application_id) const;
+  bool Insert(scoped_refptr<const Application> application) const;
+  void InitDBIfNeeded() const;
   scoped_ptr<DBStoreImpl> db_store_;
+  mutable bool db_initialized_;
+  // The applications created so far.
   scoped_ptr<ApplicationMap> applications_;
   DISALLOW_COPY_AND_ASSIGN(ApplicationStore);
 };
@@ -0,0 +1,79 @@
+// Copyright (c) 2013 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "xwalk/application/browser/application_store.h"
+
+#include "base/files/scoped_temp_dir.h"
+#include "base/strings/stringprintf.h"
+#include "base/time/time.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "xwalk/application/common/db_store_sqlite_impl.h"
+#include "xwalk/test/base/xwalk_test_utils.h"
+
+using xwalk_test_utils::PrintPerfResult;
+
+namespace xwalk {
+namespace application {
+
+namespace {
+
+const int kInstalledApplicationCount = 500;
+
+std::string GetApplicationID(int index) {
+  return base::StringPrintf("app%d", index);
+}
+
+}  // namespace
+
+class ApplicationStorePerfTest : public testing::Test {
+ protected:
+  virtual void SetUp() OVERRIDE {
+    ASSERT_TRUE(temp_dir_.CreateUniqueTempDir());
+    DBStoreSqliteImpl db_store(temp_dir_.path());
+    ASSERT_TRUE(db_store.InitDB());
+    db_store.BeginBatch();
+    for (int i = 0; i < kInstalledApplicationCount; ++i) {
+      base::DictionaryValue* manifest = new base::DictionaryValue;
+      manifest->SetString("name", GetApplicationID(i));
+      manifest->SetString("version", "1.0.0");
+      manifest->SetString("description",
+                          "An application installed by the benchmark.");
+      manifest->SetString("app.main.source", "main.html");
+      base::DictionaryValue* value = new base::DictionaryValue;
+      value->SetString(ApplicationStore::kApplicationPath,
+                       temp_dir_.path().AppendASCII(GetApplicationID(i))
+                           .AsUTF8Unsafe());
+      value->Set(ApplicationStore::kManifestPath, manifest);
+      value->SetDouble(ApplicationStore::kInstallTime, 0);
+      db_store.SetValue(GetApplicationID(i), value);
+    }
+    ASSERT_TRUE(db_store.EndBatch());
+  }
+
+  base::ScopedTempDir temp_dir_;
+};
+
+// Measures a cold start to launch one application, which only creates that
+// application, against creating all the installed ones.
+TEST_F(ApplicationStorePerfTest, ColdStart) {
+  base::TimeTicks start = base::TimeTicks::Now();
+  scoped_ptr<ApplicationStore> store(new ApplicationStore(temp_dir_.path()));
+  ASSERT_TRUE(store->GetApplicationByID(GetApplicationID(0)));
+  base::TimeDelta one_application = base::TimeTicks::Now() - start;
+
+  start = base::TimeTicks::Now();
+  store.reset(new ApplicationStore(temp_dir_.path()));
+  ASSERT_EQ(kInstalledApplicationCount,
+            static_cast<int>(store->GetInstalledApplications()->size()));
+  base::TimeDelta all_applications = base::TimeTicks::Now() - start;
+
+  std::string trace = base::StringPrintf("%d_apps", kInstalledApplicationCount);
+  PrintPerfResult("application_store_cold_start_one_app", trace,
+                  one_application.InMillisecondsF(), "ms");
+  PrintPerfResult("application_store_cold_start_all_apps", trace,
+                  all_applications.InMillisecondsF(), "ms");
+}
+
+}  // namespace application
+}  // namespace xwalk
@@ -0,0 +1,109 @@
+// Copyright (c) 2013 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "xwalk/application/browser/application_store.h"
+
+#include <string>
+#include <vector>
+
+#include "base/files/scoped_temp_dir.h"
+#include "base/strings/stringprintf.h"
+#include "base/values.h"
+#include "sql/connection.h"
+#include "sql/test/scoped_error_ignorer.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "third_party/sqlite/sqlite3.h"
+#include "xwalk/application/common/application_manifest_constants.h"
+#include "xwalk/application/common/id_util.h"
+
+namespace keys = xwalk::application_manifest_keys;
+
+namespace xwalk {
+namespace application {
+
+namespace {
+
+scoped_refptr<const Application> CreateApplication(const std::string& name) {
+  base::DictionaryValue manifest;
+  manifest.SetString(keys::kNameKey, name);
+  manifest.SetString(keys::kVersionKey, "1.0");
+  std::string error;
+  scoped_refptr<const Application> application = Application::Create(
+      base::FilePath(), Manifest::COMMAND_LINE, manifest, GenerateId(name),
+      &error);
+  EXPECT_TRUE(application.get()) << error;
+  return application;
+}
+
+}  // namespace
+
+class ApplicationStoreTest : public testing::Test {
+ protected:
+  virtual void SetUp() OVERRIDE {
+    ASSERT_TRUE(temp_dir_.CreateUniqueTempDir());
+    store_.reset(new ApplicationStore(temp_dir_.path()));
+  }
+
+  base::ScopedTempDir temp_dir_;
+  scoped_ptr<ApplicationStore> store_;
+};
+
+TEST_F(ApplicationStoreTest, AddApplications) {
+  std::vector<scoped_refptr<const Application> > applications;
+  applications.push_back(CreateApplication("first"));
+  applications.push_back(CreateApplication("second"));
+  ASSERT_TRUE(store_->AddApplication(applications[0]));
+
+  std::vector<bool> added;
+  EXPECT_TRUE(store_->AddApplications(applications, &added));
+  ASSERT_EQ(2u, added.size());
+  EXPECT_TRUE(added[0]);
+  EXPECT_TRUE(added[1]);
+
+  store_.reset(new ApplicationStore(temp_dir_.path()));
+  EXPECT_TRUE(store_->Contains(applications[0]->ID()));
+  EXPECT_TRUE(store_->Contains(applications[1]->ID()));
+}
+
+TEST_F(ApplicationStoreTest, FailedAddApplicationsAddsNone) {
+  std::vector<scoped_refptr<const Application> > applications;
+  applications.push_back(CreateApplication("stored"));
+  applications.push_back(CreateApplication("good"));
+  applications.push_back(CreateApplication("bad"));
+  ASSERT_TRUE(store_->AddApplication(applications[0]));
+
+  // The insertion of the last application fails in the middle of the batch.
+  {
+    sql::Connection db;
+    ASSERT_TRUE(db.Open(temp_dir_.path().Append(
+        ApplicationStore::DBStoreImpl::kDBFileName)));
+    ASSERT_TRUE(db.Execute(base::StringPrintf(
+        "CREATE TRIGGER fail_insert BEFORE INSERT ON applications "
+        "WHEN NEW.id = '%s' BEGIN SELECT RAISE(ABORT, 'fail'); END",
+        applications[2]->ID().c_str()).c_str()));
+  }
+
+  std::vector<bool> added;
+  {
+    sql::ScopedErrorIgnorer ignore_errors;
+    ignore_errors.IgnoreError(SQLITE_CONSTRAINT);
+    EXPECT_FALSE(store_->AddApplications(applications, &added));
+    EXPECT_TRUE(ignore_errors.CheckIgnoredErrors());
+  }
+  ASSERT_EQ(3u, added.size());
+  EXPECT_TRUE(added[0]);
+  EXPECT_FALSE(added[1]);
+  EXPECT_FALSE(added[2]);
+  EXPECT_TRUE(store_->Contains(applications[0]->ID()));
+  EXPECT_FALSE(store_->Contains(applications[1]->ID()));
+  EXPECT_FALSE(store_->Contains(applications[2]->ID()));
+
+  store_.reset(new ApplicationStore(temp_dir_.path()));
+  EXPECT_TRUE(store_->Contains(applications[0]->ID()));
+  EXPECT_FALSE(store_->Contains(applications[1]->ID()));
+  EXPECT_FALSE(store_->Contains(applications[2]->ID()));
+}
+
+}  // namespace application
+}  // namespace xwalk
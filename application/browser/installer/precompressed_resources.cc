@@ -0,0 +1,103 @@
+// Copyright (c) 2013 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "xwalk/application/browser/installer/precompressed_resources.h"
+
+#include <string.h>
+
+#include "base/file_util.h"
+#include "base/files/file_enumerator.h"
+#include "base/logging.h"
+#include "third_party/zlib/zlib.h"
+#include "xwalk/application/common/constants.h"
+
+namespace xwalk {
+namespace application {
+
+namespace {
+
+// The copy is only worth it if it's at most this percentage of the file.
+const int64 kMaxCompressedRatio = 80;
+
+// The files worth compressing, the images and media are compressed already.
+const base::FilePath::CharType* const kCompressibleExtensions[] = {
+  FILE_PATH_LITERAL(".css"),
+  FILE_PATH_LITERAL(".htm"),
+  FILE_PATH_LITERAL(".html"),
+  FILE_PATH_LITERAL(".js"),
+  FILE_PATH_LITERAL(".json"),
+  FILE_PATH_LITERAL(".svg"),
+  FILE_PATH_LITERAL(".txt"),
+  FILE_PATH_LITERAL(".xml"),
+};
+
+bool IsCompressible(const base::FilePath& path) {
+  for (size_t i = 0; i < arraysize(kCompressibleExtensions); ++i) {
+    if (path.MatchesExtension(kCompressibleExtensions[i]))
+      return true;
+  }
+  return false;
+}
+
+}  // namespace
+
+bool GzipString(const std::string& data, std::string* compressed) {
+  z_stream stream;
+  memset(&stream, 0, sizeof(stream));
+  // Adding 16 to the window bits writes a gzip header and trailer.
+  if (deflateInit2(&stream, Z_BEST_COMPRESSION, Z_DEFLATED, MAX_WBITS + 16,
+                   8, Z_DEFAULT_STRATEGY) != Z_OK)
+    return false;
+
+  compressed->resize(deflateBound(&stream, data.size()));
+  stream.next_in =
+      reinterpret_cast<Bytef*>(const_cast<char*>(data.data()));
+  stream.avail_in = data.size();
+  stream.next_out = reinterpret_cast<Bytef*>(&(*compressed)[0]);
+  stream.avail_out = compressed->size();
+  int result = deflate(&stream, Z_FINISH);
+  compressed->resize(stream.total_out);
+  deflateEnd(&stream);
+  return result == Z_STREAM_END;
+}
+
+bool WriteCompressedResources(const base::FilePath& app_dir,
+                              int* files_compressed,
+                              int64* bytes_saved) {
+  base::FileEnumerator files(app_dir, true, base::FileEnumerator::FILES);
+  for (base::FilePath path = files.Next(); !path.empty(); path = files.Next()) {
+    base::FileEnumerator::FileInfo info = files.GetInfo();
+    // The smaller files are served from memory, not from their copies.
+    if (info.GetSize() <= kMaxMemoryCachedResourceSize ||
+        !IsCompressible(path))
+      continue;
+
+    std::string data;
+    std::string compressed;
+    if (!file_util::ReadFileToString(path, &data) ||
+        !GzipString(data, &compressed)) {
+      LOG(ERROR) << "Unable to compress " << path.value();
+      return false;
+    }
+    if (static_cast<int64>(compressed.size()) * 100 >
+        static_cast<int64>(data.size()) * kMaxCompressedRatio)
+      continue;
+
+    const base::FilePath compressed_path =
+        path.AddExtension(kCompressedResourceExtension);
+    if (file_util::WriteFile(compressed_path, compressed.data(),
+                             compressed.size()) !=
+        static_cast<int>(compressed.size())) {
+      LOG(ERROR) << "Unable to write " << compressed_path.value();
+      base::DeleteFile(compressed_path, false);
+      return false;
+    }
+    ++*files_compressed;
+    *bytes_saved += data.size() - compressed.size();
+  }
+  return true;
+}
+
+}  // namespace application
+}  // namespace xwalk
@@ -0,0 +1,33 @@
+// Copyright (c) 2013 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef XWALK_APPLICATION_BROWSER_INSTALLER_PRECOMPRESSED_RESOURCES_H_
+#define XWALK_APPLICATION_BROWSER_INSTALLER_PRECOMPRESSED_RESOURCES_H_
+
+#include <string>
+
+#include "base/basictypes.h"
+#include "base/files/file_path.h"
+
+namespace xwalk {
+namespace application {
+
+// Writes a gzip compressed copy next to the text resource files of |app_dir|
+// which compress well, named after the file with kCompressedResourceExtension
+// added. The app:// protocol serves these copies instead of the files, which
+// cuts the bytes read from the storage. The files small enough to be kept in
+// memory, see kMaxMemoryCachedResourceSize, aren't compressed since the copy
+// wouldn't be used. Adds the number of copies written to
+// |files_compressed| and the bytes they don't read to |bytes_saved|.
+bool WriteCompressedResources(const base::FilePath& app_dir,
+                              int* files_compressed,
+                              int64* bytes_saved);
+
+// Compresses |data| in the gzip format into |compressed|.
+bool GzipString(const std::string& data, std::string* compressed);
+
+}  // namespace application
+}  // namespace xwalk
+
+#endif  // XWALK_APPLICATION_BROWSER_INSTALLER_PRECOMPRESSED_RESOURCES_H_
@@ -0,0 +1,67 @@
+// Copyright (c) 2013 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "xwalk/application/browser/installer/precompressed_resources.h"
+
+#include <string>
+
+#include "base/file_util.h"
+#include "base/files/scoped_temp_dir.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "xwalk/application/common/constants.h"
+
+namespace xwalk {
+namespace application {
+
+namespace {
+
+void WriteFile(const base::FilePath& path, const std::string& content) {
+  EXPECT_EQ(static_cast<int>(content.size()),
+            file_util::WriteFile(path, content.data(), content.size()));
+}
+
+}  // namespace
+
+TEST(PrecompressedResourcesTest, WriteCompressedResources) {
+  base::ScopedTempDir temp_dir;
+  ASSERT_TRUE(temp_dir.CreateUniqueTempDir());
+  const base::FilePath app_dir = temp_dir.path();
+  const base::FilePath lib_dir = app_dir.AppendASCII("lib");
+  ASSERT_TRUE(file_util::CreateDirectory(lib_dir));
+
+  std::string script;
+  while (static_cast<int64>(script.size()) <= kMaxMemoryCachedResourceSize)
+    script.append("framework.register(function() { return 0; });\n");
+  WriteFile(lib_dir.AppendASCII("framework.js"), script);
+  // Small enough to be served from memory.
+  WriteFile(app_dir.AppendASCII("index.html"), "<html></html>");
+  WriteFile(app_dir.AppendASCII("app.js"), script.substr(
+      0, static_cast<size_t>(kMaxMemoryCachedResourceSize)));
+  // Not a text resource.
+  WriteFile(app_dir.AppendASCII("icon.png"), script);
+
+  int files_compressed = 0;
+  int64 bytes_saved = 0;
+  ASSERT_TRUE(WriteCompressedResources(app_dir, &files_compressed,
+                                       &bytes_saved));
+  EXPECT_EQ(1, files_compressed);
+  EXPECT_GT(bytes_saved, 0);
+
+  std::string compressed;
+  ASSERT_TRUE(file_util::ReadFileToString(
+      lib_dir.AppendASCII("framework.js.gz"), &compressed));
+  EXPECT_EQ(static_cast<int64>(script.size() - compressed.size()),
+            bytes_saved);
+  // The gzip magic number.
+  ASSERT_GT(compressed.size(), 2u);
+  EXPECT_EQ('\x1f', compressed[0]);
+  EXPECT_EQ('\x8b', compressed[1]);
+
+  EXPECT_FALSE(base::PathExists(app_dir.AppendASCII("index.html.gz")));
+  EXPECT_FALSE(base::PathExists(app_dir.AppendASCII("app.js.gz")));
+  EXPECT_FALSE(base::PathExists(app_dir.AppendASCII("icon.png.gz")));
+}
+
+}  // namespace application
+}  // namespace xwalk
@@ -0,0 +1,170 @@
+// Copyright (c) 2013 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "xwalk/application/browser/installer/shared_resource_store.h"
+
+#if defined(OS_POSIX)
+#include <errno.h>
+#include <stdio.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <string>
+
+#include "base/file_util.h"
+#include "base/files/file_enumerator.h"
+#include "base/logging.h"
+#include "base/memory/scoped_handle.h"
+#include "base/memory/scoped_ptr.h"
+#include "base/strings/string_number_conversions.h"
+#include "base/strings/string_util.h"
+#include "crypto/secure_hash.h"
+#include "crypto/sha2.h"
+
+namespace xwalk {
+namespace application {
+
+namespace {
+
+const size_t kReadBufferSize = 64 * 1024;
+
+// Added to the name of a file while it's replaced by a link.
+const base::FilePath::CharType kLinkingExtension[] =
+    FILE_PATH_LITERAL("sharing");
+
+bool HashFile(const base::FilePath& path, std::string* hash) {
+  ScopedStdioHandle file(file_util::OpenFile(path, "rb"));
+  if (!file.get())
+    return false;
+
+  scoped_ptr<crypto::SecureHash> sha256(
+      crypto::SecureHash::Create(crypto::SecureHash::SHA256));
+  char buffer[kReadBufferSize];
+  size_t read;
+  while ((read = fread(buffer, 1, sizeof(buffer), file.get())) > 0)
+    sha256->Update(buffer, read);
+  if (ferror(file.get()))
+    return false;
+
+  uint8 digest[crypto::kSHA256Length];
+  sha256->Finish(digest, sizeof(digest));
+  *hash = StringToLowerASCII(base::HexEncode(digest, sizeof(digest)));
+  return true;
+}
+
+}  // namespace
+
+SharedResourceStore::Report::Report()
+    : files(0),
+      links(0),
+      bytes_saved(0) {
+}
+
+SharedResourceStore::SharedResourceStore(const base::FilePath& dir)
+    : dir_(dir) {
+}
+
+SharedResourceStore::~SharedResourceStore() {
+}
+
+// static
+bool SharedResourceStore::IsSupported() {
+#if defined(OS_POSIX)
+  return true;
+#else
+  return false;
+#endif
+}
+
+bool SharedResourceStore::ShareFiles(const base::FilePath& app_dir,
+                                     int64* bytes_saved) {
+#if defined(OS_POSIX)
+  base::FileEnumerator files(app_dir, true, base::FileEnumerator::FILES);
+  for (base::FilePath path = files.Next(); !path.empty();
+       path = files.Next()) {
+    struct stat file_stat;
+    if (lstat(path.value().c_str(), &file_stat) != 0 ||
+        !S_ISREG(file_stat.st_mode))
+      continue;
+
+    std::string hash;
+    if (!HashFile(path, &hash)) {
+      LOG(ERROR) << "Can't read " << path.value();
+      return false;
+    }
+
+    // The first file with this content becomes the stored one.
+    const base::FilePath stored_path = dir_.AppendASCII(hash);
+    if (link(path.value().c_str(), stored_path.value().c_str()) == 0)
+      continue;
+    if (errno != EEXIST) {
+      PLOG(ERROR) << "Can't store " << path.value();
+      return false;
+    }
+
+    struct stat stored_stat;
+    if (stat(stored_path.value().c_str(), &stored_stat) != 0)
+      return false;
+    if (stored_stat.st_dev == file_stat.st_dev &&
+        stored_stat.st_ino == file_stat.st_ino)
+      continue;
+
+    // The link is renamed over the file, so the file is replaced atomically.
+    // The copy is kept if the stored file can't have more links.
+    const base::FilePath linking_path = path.AddExtension(kLinkingExtension);
+    if (link(stored_path.value().c_str(), linking_path.value().c_str()) != 0)
+      continue;
+    if (rename(linking_path.value().c_str(), path.value().c_str()) != 0) {
+      PLOG(ERROR) << "Can't replace " << path.value();
+      unlink(linking_path.value().c_str());
+      return false;
+    }
+    *bytes_saved += file_stat.st_size;
+  }
+  return true;
+#else
+  return false;
+#endif
+}
+
+void SharedResourceStore::DeleteUnusedFiles() {
+#if defined(OS_POSIX)
+  base::FileEnumerator files(dir_, false, base::FileEnumerator::FILES);
+  for (base::FilePath path = files.Next(); !path.empty();
+       path = files.Next()) {
+    struct stat file_stat;
+    if (stat(path.value().c_str(), &file_stat) == 0 &&
+        file_stat.st_nlink <= 1)
+      base::DeleteFile(path, false);
+  }
+#endif
+}
+
+bool SharedResourceStore::GetReport(Report* report) const {
+#if defined(OS_POSIX)
+  base::FileEnumerator files(dir_, false, base::FileEnumerator::FILES);
+  for (base::FilePath path = files.Next(); !path.empty();
+       path = files.Next()) {
+    struct stat file_stat;
+    if (stat(path.value().c_str(), &file_stat) != 0)
+      return false;
+    // One of the links is the stored file itself, a file without others is
+    // not used anymore.
+    if (file_stat.st_nlink <= 1)
+      continue;
+    int64 links = file_stat.st_nlink - 1;
+    ++report->files;
+    report->links += links;
+    if (links > 1)
+      report->bytes_saved += (links - 1) * file_stat.st_size;
+  }
+  return true;
+#else
+  return false;
+#endif
+}
+
+}  // namespace application
+}  // namespace xwalk
@@ -0,0 +1,62 @@
+// Copyright (c) 2013 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef XWALK_APPLICATION_BROWSER_INSTALLER_SHARED_RESOURCE_STORE_H_
+#define XWALK_APPLICATION_BROWSER_INSTALLER_SHARED_RESOURCE_STORE_H_
+
+#include "base/basictypes.h"
+#include "base/files/file_path.h"
+
+namespace xwalk {
+namespace application {
+
+// Holds the files of the installed applications by the SHA-256 of their
+// content, so the files bundled by several applications, like JavaScript
+// frameworks, are stored and cached in memory only once. The files of an
+// application directory are replaced by hard links to the stored files, so
+// they must not be modified in place afterwards.
+class SharedResourceStore {
+ public:
+  struct Report {
+    Report();
+
+    // The stored files some application directory links to. The unused
+    // ones, see DeleteUnusedFiles(), aren't counted.
+    int64 files;
+    // The links to the stored files from the application directories.
+    int64 links;
+    // The bytes the copies of the stored files would take.
+    int64 bytes_saved;
+  };
+
+  // |dir| must be in the same file system as the application directories.
+  explicit SharedResourceStore(const base::FilePath& dir);
+  ~SharedResourceStore();
+
+  // Whether files can be shared on this platform, which needs hard links.
+  // Where they can't, ShareFiles() and GetReport() fail and
+  // DeleteUnusedFiles() does nothing.
+  static bool IsSupported();
+
+  // Replaces the files of |app_dir| by links to the stored files with the
+  // same content, and stores the ones not stored yet. Adds the bytes not
+  // taken by copies anymore to |bytes_saved|. It can be called for several
+  // directories at the same time.
+  bool ShareFiles(const base::FilePath& app_dir, int64* bytes_saved);
+
+  // Deletes the stored files no application directory links to anymore.
+  void DeleteUnusedFiles();
+
+  bool GetReport(Report* report) const;
+
+ private:
+  base::FilePath dir_;
+
+  DISALLOW_COPY_AND_ASSIGN(SharedResourceStore);
+};
+
+}  // namespace application
+}  // namespace xwalk
+
+#endif  // XWALK_APPLICATION_BROWSER_INSTALLER_SHARED_RESOURCE_STORE_H_
@@ -0,0 +1,111 @@
+// Copyright (c) 2013 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "xwalk/application/browser/installer/shared_resource_store.h"
+
+#include <string.h>
+
+#include <string>
+
+#include "base/file_util.h"
+#include "base/files/scoped_temp_dir.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace xwalk {
+namespace application {
+
+#if defined(OS_POSIX)
+class SharedResourceStoreTest : public testing::Test {
+ protected:
+  virtual void SetUp() OVERRIDE {
+    ASSERT_TRUE(temp_dir_.CreateUniqueTempDir());
+    store_dir_ = temp_dir_.path().AppendASCII("shared");
+    ASSERT_TRUE(file_util::CreateDirectory(store_dir_));
+  }
+
+  base::FilePath CreateAppDir(const std::string& name,
+                              const std::string& unique_content) {
+    base::FilePath dir = temp_dir_.path().AppendASCII(name);
+    base::FilePath lib_dir = dir.AppendASCII("lib");
+    EXPECT_TRUE(file_util::CreateDirectory(lib_dir));
+    WriteFile(lib_dir.AppendASCII("framework.js"), kFrameworkContent);
+    WriteFile(dir.AppendASCII("index.html"), unique_content);
+    return dir;
+  }
+
+  void WriteFile(const base::FilePath& path, const std::string& content) {
+    EXPECT_EQ(static_cast<int>(content.size()),
+              file_util::WriteFile(path, content.data(), content.size()));
+  }
+
+  static const char kFrameworkContent[];
+
+  base::ScopedTempDir temp_dir_;
+  base::FilePath store_dir_;
+};
+
+const char SharedResourceStoreTest::kFrameworkContent[] =
+    "var framework = {};";
+
+TEST_F(SharedResourceStoreTest, ShareFiles) {
+  SharedResourceStore store(store_dir_);
+  base::FilePath app1 = CreateAppDir("app1", "<html>1</html>");
+  base::FilePath app2 = CreateAppDir("app2", "<html>2</html>");
+
+  int64 bytes_saved = 0;
+  ASSERT_TRUE(store.ShareFiles(app1, &bytes_saved));
+  EXPECT_EQ(0, bytes_saved);
+  ASSERT_TRUE(store.ShareFiles(app2, &bytes_saved));
+  const int64 framework_size = strlen(kFrameworkContent);
+  EXPECT_EQ(framework_size, bytes_saved);
+
+  // Sharing again doesn't change anything.
+  bytes_saved = 0;
+  ASSERT_TRUE(store.ShareFiles(app2, &bytes_saved));
+  EXPECT_EQ(0, bytes_saved);
+
+  std::string content;
+  ASSERT_TRUE(file_util::ReadFileToString(
+      app2.AppendASCII("lib").AppendASCII("framework.js"), &content));
+  EXPECT_EQ(kFrameworkContent, content);
+
+  SharedResourceStore::Report report;
+  ASSERT_TRUE(store.GetReport(&report));
+  EXPECT_EQ(3, report.files);
+  EXPECT_EQ(4, report.links);
+  EXPECT_EQ(framework_size, report.bytes_saved);
+}
+
+TEST_F(SharedResourceStoreTest, DeleteUnusedFiles) {
+  SharedResourceStore store(store_dir_);
+  base::FilePath app1 = CreateAppDir("app1", "<html>1</html>");
+  base::FilePath app2 = CreateAppDir("app2", "<html>2</html>");
+  int64 bytes_saved = 0;
+  ASSERT_TRUE(store.ShareFiles(app1, &bytes_saved));
+  ASSERT_TRUE(store.ShareFiles(app2, &bytes_saved));
+
+  // The unused files aren't reported, even before they are deleted.
+  ASSERT_TRUE(base::DeleteFile(app1, true));
+  SharedResourceStore::Report report;
+  ASSERT_TRUE(store.GetReport(&report));
+  EXPECT_EQ(2, report.files);
+  EXPECT_EQ(2, report.links);
+  EXPECT_EQ(0, report.bytes_saved);
+
+  // The shared file is kept for the remaining application.
+  store.DeleteUnusedFiles();
+  report = SharedResourceStore::Report();
+  ASSERT_TRUE(store.GetReport(&report));
+  EXPECT_EQ(2, report.files);
+  EXPECT_EQ(2, report.links);
+  EXPECT_EQ(0, report.bytes_saved);
+
+  ASSERT_TRUE(base::DeleteFile(app2, true));
+  store.DeleteUnusedFiles();
+  EXPECT_TRUE(file_util::IsDirectoryEmpty(store_dir_));
+}
+#endif  // defined(OS_POSIX)
+
+}  // namespace application
+}  // namespace xwalk
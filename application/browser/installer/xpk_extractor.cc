@@ -4,16 +4,216 @@
 
 #include "xwalk/application/browser/installer/xpk_extractor.h"
 
+#include <string.h>
+
+#include <vector>
+
+#if defined(OS_POSIX)
+#include <unistd.h>
+#elif defined(OS_WIN)
+#include <windows.h>
+#endif
+
 #include "base/file_util.h"
+#include "base/files/file_enumerator.h"
 #include "base/logging.h"
+#include "base/memory/scoped_handle.h"
 #include "base/path_service.h"
+#include "base/threading/simple_thread.h"
 #include "third_party/zlib/google/zip.h"
+#include "third_party/zlib/google/zip_internal.h"
+#include "third_party/zlib/google/zip_reader.h"
+#include "third_party/zlib/zlib.h"
+#include "xwalk/application/common/constants.h"
 
 namespace xwalk {
 namespace application {
 
-const base::FilePath::CharType kApplicationFileExtension[] =
-    FILE_PATH_LITERAL(".xpk");
+namespace {
+
+// The staging directories are named ".staging.<target>.<random>", so the
+// directory they replace is known if the replacement is interrupted.
+const base::FilePath::CharType kStagingDirPrefix[] =
+    FILE_PATH_LITERAL(".staging.");
+
+const base::FilePath::CharType kReplacedDirExtension[] =
+    FILE_PATH_LITERAL(".old");
+
+class SignatureVerifier : public base::DelegateSimpleThread::Delegate {
+ public:
+  explicit SignatureVerifier(const XPKPackage* package)
+      : package_(package),
+        verified_(false) {
+  }
+
+  virtual void Run() OVERRIDE {
+    verified_ = package_->Verify();
+  }
+
+  bool verified() const { return verified_; }
+
+ private:
+  const XPKPackage* package_;
+  bool verified_;
+
+  DISALLOW_COPY_AND_ASSIGN(SignatureVerifier);
+};
+
+// Returns whether the current entry of |zip_file|, of |size| bytes, has the
+// same content as the file |path|. The entry is inflated and compared byte by
+// byte, but nothing is written.
+bool EntryMatchesFile(unzFile zip_file, int64 size,
+                      const base::FilePath& path) {
+  int64 file_size;
+  if (!file_util::GetFileSize(path, &file_size) || file_size != size)
+    return false;
+
+  ScopedStdioHandle file(file_util::OpenFile(path, "rb"));
+  if (!file.get() || unzOpenCurrentFile(zip_file) != UNZ_OK)
+    return false;
+
+  bool matches = true;
+  char entry_buffer[zip::internal::kZipBufSize];
+  char file_buffer[zip::internal::kZipBufSize];
+  while (matches) {
+    int read = unzReadCurrentFile(zip_file, entry_buffer,
+                                  sizeof(entry_buffer));
+    if (read == 0)
+      break;
+    if (read < 0 ||
+        fread(file_buffer, 1, read, file.get()) != static_cast<size_t>(read) ||
+        memcmp(entry_buffer, file_buffer, read) != 0)
+      matches = false;
+  }
+  // Both must end at the same point, and closing the entry checks the CRC-32
+  // of what was inflated.
+  if (matches && fgetc(file.get()) != EOF)
+    matches = false;
+  if (unzCloseCurrentFile(zip_file) != UNZ_OK)
+    matches = false;
+  return matches;
+}
+
+// Makes |to| another link to the file |from|, or a copy of it when the file
+// system doesn't support hard links.
+bool LinkFile(const base::FilePath& from, const base::FilePath& to) {
+#if defined(OS_POSIX)
+  if (link(from.value().c_str(), to.value().c_str()) == 0)
+    return true;
+#elif defined(OS_WIN)
+  if (::CreateHardLink(to.value().c_str(), from.value().c_str(), NULL))
+    return true;
+#endif
+  return base::CopyFile(from, to);
+}
+
+// Extracts the current entry of |zip_file| to the file |path|.
+bool ExtractCurrentEntry(unzFile zip_file, const base::FilePath& path) {
+  if (unzOpenCurrentFile(zip_file) != UNZ_OK)
+    return false;
+
+  ScopedStdioHandle file(file_util::OpenFile(path, "wb"));
+  bool succeeded = file.get() != NULL;
+  char buffer[zip::internal::kZipBufSize];
+  while (succeeded) {
+    int read = unzReadCurrentFile(zip_file, buffer, sizeof(buffer));
+    if (read == 0)
+      break;
+    if (read < 0 ||
+        fwrite(buffer, 1, read, file.get()) != static_cast<size_t>(read))
+      succeeded = false;
+  }
+
+  // Closing the entry also checks the CRC-32 of what was read.
+  if (unzCloseCurrentFile(zip_file) != UNZ_OK)
+    succeeded = false;
+  return succeeded;
+}
+
+// Unzips |zip_path| to |dir| like zip::Unzip(), except that the entries whose
+// content is the same as the file at the same path in |base_dir| aren't
+// written, that file is linked into |dir| instead.
+bool UnzipDelta(const base::FilePath& zip_path,
+                const base::FilePath& base_dir,
+                const base::FilePath& dir,
+                XPKExtractor::UpdateStats* stats) {
+  unzFile zip_file = zip::internal::OpenForUnzipping(zip_path.AsUTF8Unsafe());
+  if (!zip_file)
+    return false;
+
+  bool succeeded = true;
+  for (int result = unzGoToFirstFile(zip_file);
+       succeeded && result != UNZ_END_OF_LIST_OF_FILE;
+       result = unzGoToNextFile(zip_file)) {
+    char name[zip::internal::kZipMaxPath];
+    unz_file_info info;
+    if (result != UNZ_OK ||
+        unzGetCurrentFileInfo(zip_file, &info, name, sizeof(name),
+                              NULL, 0, NULL, 0) != UNZ_OK) {
+      succeeded = false;
+      break;
+    }
+
+    // A longer name would be truncated, without a terminating null.
+    if (info.size_filename >= sizeof(name)) {
+      LOG(ERROR) << "Invalid entry name in the package.";
+      succeeded = false;
+      break;
+    }
+
+    // The entries are validated like zip::Unzip() does.
+    zip::ZipReader::EntryInfo entry_info(name, info);
+    const base::FilePath& entry = entry_info.file_path();
+    if (entry.empty() || entry_info.is_unsafe()) {
+      LOG(ERROR) << "Invalid entry in the package: " << name;
+      succeeded = false;
+      break;
+    }
+
+    base::FilePath path = dir.Append(entry);
+    if (entry_info.is_directory()) {
+      succeeded = file_util::CreateDirectory(path);
+      continue;
+    }
+
+    if (!file_util::CreateDirectory(path.DirName())) {
+      succeeded = false;
+      break;
+    }
+
+    base::FilePath base_path = base_dir.Append(entry);
+    if (EntryMatchesFile(zip_file, entry_info.original_size(), base_path) &&
+        LinkFile(base_path, path)) {
+      ++stats->files_linked;
+    } else {
+      succeeded = ExtractCurrentEntry(zip_file, path);
+      if (succeeded)
+        ++stats->files_written;
+    }
+  }
+  unzClose(zip_file);
+  if (!succeeded)
+    return false;
+
+  base::FileEnumerator base_files(base_dir, true,
+                                  base::FileEnumerator::FILES);
+  for (base::FilePath base_path = base_files.Next(); !base_path.empty();
+       base_path = base_files.Next()) {
+    base::FilePath path = dir;
+    if (base_dir.AppendRelativePath(base_path, &path) &&
+        !base::PathExists(path))
+      ++stats->files_removed;
+  }
+  return true;
+}
+
+}  // namespace
+
+XPKExtractor::UpdateStats::UpdateStats()
+    : files_written(0),
+      files_linked(0),
+      files_removed(0) {
+}
 
 XPKExtractor::XPKExtractor() {
 }
@@ -53,15 +253,177 @@ bool XPKExtractor::Extract(base::FilePath* target_path) {
     return false;
   }
 
-  if (!zip::Unzip(source_path_, temp_dir_.path())) {
-    LOG(ERROR) << "An error occurred during package extraction";
+  if (!VerifyAndUnzip(temp_dir_.path(), base::FilePath(), NULL))
     return false;
-  }
 
   *target_path = temp_dir_.path();
   return true;
 }
 
+bool XPKExtractor::ExtractTo(const base::FilePath& target_dir) {
+  if (!xpk_package_.get() ||
+      !xpk_package_->IsOk()) {
+    LOG(ERROR) << "XPK file is broken.";
+    return false;
+  }
+
+  // Staging in the same directory keeps the final renames in the same file
+  // system, so they don't copy the files again.
+  base::FilePath staging_dir;
+  if (!CreateStagingDir(target_dir, &staging_dir)) {
+    LOG(ERROR) << "Can't create a staging directory for extracting the "
+                  "package content.";
+    return false;
+  }
+
+  if (!VerifyAndUnzip(staging_dir, base::FilePath(), NULL)) {
+    base::DeleteFile(staging_dir, true);
+    return false;
+  }
+
+  return ReplaceTargetDir(staging_dir, target_dir);
+}
+
+bool XPKExtractor::UpdateTo(const base::FilePath& target_dir,
+                            UpdateStats* stats) {
+  if (!xpk_package_.get() ||
+      !xpk_package_->IsOk()) {
+    LOG(ERROR) << "XPK file is broken.";
+    return false;
+  }
+
+  if (!base::DirectoryExists(target_dir)) {
+    LOG(ERROR) << "No previous version to update in " << target_dir.value();
+    return false;
+  }
+
+  // The unchanged files are linked from |target_dir|, so the staging
+  // directory must be in the same file system.
+  base::FilePath staging_dir;
+  if (!CreateStagingDir(target_dir, &staging_dir)) {
+    LOG(ERROR) << "Can't create a staging directory for extracting the "
+                  "package content.";
+    return false;
+  }
+
+  if (!VerifyAndUnzip(staging_dir, target_dir, stats)) {
+    base::DeleteFile(staging_dir, true);
+    return false;
+  }
+
+  return ReplaceTargetDir(staging_dir, target_dir);
+}
+
+// static
+void XPKExtractor::RecoverInterruptedReplaces(const base::FilePath& dir) {
+  const base::FilePath::StringType prefix(kStagingDirPrefix);
+  // The previous contents are handled first, so the staging directory they
+  // were replaced for is still there if it's needed.
+  std::vector<base::FilePath> staging_dirs;
+  base::FileEnumerator enumerator(dir, false,
+                                  base::FileEnumerator::DIRECTORIES);
+  for (base::FilePath path = enumerator.Next(); !path.empty();
+       path = enumerator.Next()) {
+    const base::FilePath::StringType name = path.BaseName().value();
+    if (name.compare(0, prefix.size(), prefix) != 0)
+      continue;
+    if (path.Extension() != kReplacedDirExtension) {
+      staging_dirs.push_back(path);
+      continue;
+    }
+
+    // ".staging.<target>.<random>.old" is the previous content of <target>.
+    // If <target> is missing, the replacement stopped between the two
+    // renames of ReplaceTargetDir(): the previous content is restored, since
+    // the caller never learned that the new one was in place.
+    const base::FilePath::StringType staging_name =
+        path.RemoveExtension().BaseName().value();
+    size_t random_separator = staging_name.rfind('.');
+    if (random_separator == base::FilePath::StringType::npos ||
+        random_separator <= prefix.size()) {
+      base::DeleteFile(path, true);
+      continue;
+    }
+    const base::FilePath target_dir = dir.Append(staging_name.substr(
+        prefix.size(), random_separator - prefix.size()));
+    if (base::PathExists(target_dir)) {
+      base::DeleteFile(path, true);
+    } else if (base::Move(path, target_dir)) {
+      LOG(WARNING) << "Restored " << target_dir.value()
+                   << " after an interrupted update.";
+    } else {
+      LOG(ERROR) << "Can't restore " << target_dir.value();
+    }
+  }
+
+  // The staging directories left are from interrupted extractions.
+  for (size_t i = 0; i < staging_dirs.size(); ++i)
+    base::DeleteFile(staging_dirs[i], true);
+}
+
+bool XPKExtractor::CreateStagingDir(const base::FilePath& target_dir,
+                                    base::FilePath* staging_dir) {
+  base::FilePath::StringType prefix(kStagingDirPrefix);
+  prefix.append(target_dir.BaseName().value());
+  prefix.append(FILE_PATH_LITERAL("."));
+  return file_util::CreateTemporaryDirInDir(target_dir.DirName(), prefix,
+                                            staging_dir);
+}
+
+bool XPKExtractor::ReplaceTargetDir(const base::FilePath& staging_dir,
+                                    const base::FilePath& target_dir) {
+  // The previous content is moved away rather than deleted first, so it can
+  // be restored if the new one can't be moved in place. If the process dies
+  // between the two renames, RecoverInterruptedReplaces() restores it.
+  base::FilePath replaced_dir;
+  if (base::DirectoryExists(target_dir)) {
+    replaced_dir = staging_dir.AddExtension(kReplacedDirExtension);
+    if (!base::Move(target_dir, replaced_dir)) {
+      LOG(ERROR) << "Can't replace " << target_dir.value();
+      base::DeleteFile(staging_dir, true);
+      return false;
+    }
+  }
+
+  if (!base::Move(staging_dir, target_dir)) {
+    LOG(ERROR) << "Can't move the package content to " << target_dir.value();
+    if (!replaced_dir.empty())
+      base::Move(replaced_dir, target_dir);
+    base::DeleteFile(staging_dir, true);
+    return false;
+  }
+
+  if (!replaced_dir.empty())
+    base::DeleteFile(replaced_dir, true);
+  return true;
+}
+
+bool XPKExtractor::VerifyAndUnzip(const base::FilePath& dir,
+                                  const base::FilePath& base_dir,
+                                  UpdateStats* stats) {
+  // The verifier reads the mapped package while the same pages are unzipped,
+  // so the package is read from the storage only once and hashing overlaps
+  // with inflating.
+  SignatureVerifier verifier(xpk_package_.get());
+  base::DelegateSimpleThread verifier_thread(&verifier, "XPKVerifier");
+  verifier_thread.Start();
+  bool unzipped = base_dir.empty() ?
+      zip::Unzip(source_path_, dir) :
+      UnzipDelta(source_path_, base_dir, dir, stats);
+  verifier_thread.Join();
+
+  if (!verifier.verified()) {
+    LOG(ERROR) << "XPK file signature is invalid.";
+    return false;
+  }
+
+  if (!unzipped) {
+    LOG(ERROR) << "An error occurred during package extraction";
+    return false;
+  }
+  return true;
+}
+
 // Create a temporary directory to decompress the XPK package.
 // As the package information might already exists under data_path,
 // it's safer to extract the XPK file into a temporary directory first.
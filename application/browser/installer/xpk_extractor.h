@@ -17,18 +17,62 @@ namespace application {
 class XPKExtractor
     : public base::RefCountedThreadSafe<XPKExtractor> {
  public:
+  // The work done by UpdateTo().
+  struct UpdateStats {
+    UpdateStats();
+
+    // The files extracted because they're new or their content changed.
+    int files_written;
+    // The files unchanged from the previous version, which are linked.
+    int files_linked;
+    // The files of the previous version not in the package anymore.
+    int files_removed;
+  };
+
   XPKExtractor();
   static scoped_refptr<XPKExtractor> Create(const base::FilePath& source_path);
   // The function will unzip the XPK file and return the target path where
   // to decompress by the parameter |target_path|.
   bool Extract(base::FilePath* target_path);
+  // Extracts the XPK file to |target_dir|, replacing it if it exists. The
+  // package is unzipped to a staging directory next to |target_dir| while its
+  // signature is verified, and renamed to |target_dir| only if both succeed.
+  // A previous |target_dir| is renamed away first, so the replacement takes
+  // two renames, see RecoverInterruptedReplaces().
+  bool ExtractTo(const base::FilePath& target_dir);
+  // Updates |target_dir|, which holds a previous version of the package, to
+  // the content of the XPK file. Only the files whose content differs from
+  // the ones in |target_dir| are written, the others are hard linked from
+  // |target_dir| into the staging directory. The staging directory then
+  // replaces |target_dir| like in ExtractTo(), so |target_dir| is never
+  // modified in place.
+  bool UpdateTo(const base::FilePath& target_dir, UpdateStats* stats);
   std::string GetPackageID() const;
 
+  // Cleans up after the ExtractTo() and UpdateTo() calls interrupted in
+  // |dir| by a crash: a previous version renamed away and not replaced is
+  // restored, and the staging directories left are deleted. Must be called
+  // before the directories in |dir| are used, and not while another process
+  // extracts packages to it.
+  static void RecoverInterruptedReplaces(const base::FilePath& dir);
+
  private:
   friend class base::RefCountedThreadSafe<XPKExtractor>;
   ~XPKExtractor();
   explicit XPKExtractor(const base::FilePath& source_path);
   bool CreateTempDirectory();
+  // Unzips the XPK file to |dir| and verifies its signature at the same time.
+  // If |base_dir| isn't empty, the files unchanged from the ones in it are
+  // linked instead of extracted, and |stats| is filled.
+  bool VerifyAndUnzip(const base::FilePath& dir,
+                      const base::FilePath& base_dir,
+                      UpdateStats* stats);
+  // Creates the staging directory for |target_dir|, next to it.
+  static bool CreateStagingDir(const base::FilePath& target_dir,
+                               base::FilePath* staging_dir);
+  // Moves |staging_dir| to |target_dir|, replacing it if it exists.
+  bool ReplaceTargetDir(const base::FilePath& staging_dir,
+                        const base::FilePath& target_dir);
 
   base::FilePath source_path_;
   // Temporary directory for unpacking.
@@ -5,6 +5,7 @@
 #include "xwalk/application/browser/installer/xpk_extractor.h"
 
 #include "base/file_util.h"
+#include "base/files/file_enumerator.h"
 #include "base/files/scoped_temp_dir.h"
 #include "base/path_service.h"
 #include "testing/gtest/include/gtest/gtest.h"
@@ -28,10 +29,12 @@ class XPKExtractorTest : public testing::Test {
         .AppendASCII(xpk_name);
     ASSERT_TRUE(base::PathExists(xpk_path)) << xpk_path.value();
 
+    xpk_path_ = xpk_path;
     extractor_ = XPKExtractor::Create(xpk_path);
   }
 
  protected:
+  base::FilePath xpk_path_;
   base::ScopedTempDir temp_dir_;
   scoped_refptr<XPKExtractor> extractor_;
 };
@@ -69,6 +72,165 @@ TEST_F(XPKExtractorTest, BadXPKPackageExtension) {
   EXPECT_TRUE(extractor_ == NULL);
 }
 
+TEST_F(XPKExtractorTest, ExtractTo) {
+  SetupXPKExtractor("good.xpk");
+  ASSERT_TRUE(temp_dir_.CreateUniqueTempDir());
+  base::FilePath target = temp_dir_.path().AppendASCII("app");
+  EXPECT_TRUE(extractor_->ExtractTo(target));
+  EXPECT_TRUE(base::DirectoryExists(target));
+
+  // The previous content is replaced.
+  base::FilePath stale_file = target.AppendASCII("stale");
+  ASSERT_EQ(0, file_util::WriteFile(stale_file, "", 0));
+  EXPECT_TRUE(extractor_->ExtractTo(target));
+  EXPECT_TRUE(base::DirectoryExists(target));
+  EXPECT_FALSE(base::PathExists(stale_file));
+}
+
+TEST_F(XPKExtractorTest, ExtractToBadSignature) {
+  SetupXPKExtractor("bad_signature.xpk");
+  ASSERT_TRUE(temp_dir_.CreateUniqueTempDir());
+  base::FilePath target = temp_dir_.path().AppendASCII("app");
+  ASSERT_TRUE(file_util::CreateDirectory(target));
+  EXPECT_FALSE(extractor_->ExtractTo(target));
+
+  // The target is left untouched and the staging directory is removed.
+  EXPECT_TRUE(base::DirectoryExists(target));
+  EXPECT_TRUE(file_util::IsDirectoryEmpty(target));
+  base::FileEnumerator entries(temp_dir_.path(), false,
+      base::FileEnumerator::FILES | base::FileEnumerator::DIRECTORIES);
+  EXPECT_EQ(target, entries.Next());
+  EXPECT_TRUE(entries.Next().empty());
+}
+
+TEST_F(XPKExtractorTest, UpdateTo) {
+  SetupXPKExtractor("good.xpk");
+  ASSERT_TRUE(temp_dir_.CreateUniqueTempDir());
+  base::FilePath target = temp_dir_.path().AppendASCII("app");
+  XPKExtractor::UpdateStats stats;
+  EXPECT_FALSE(extractor_->UpdateTo(target, &stats));
+  ASSERT_TRUE(extractor_->ExtractTo(target));
+
+  std::string manifest;
+  std::string index;
+  ASSERT_TRUE(file_util::ReadFileToString(target.AppendASCII("manifest.json"),
+                                          &manifest));
+  ASSERT_TRUE(file_util::ReadFileToString(target.AppendASCII("index.html"),
+                                          &index));
+
+  // Only the changed file is written and the removed one is unlinked.
+  std::string changed("changed");
+  ASSERT_EQ(static_cast<int>(changed.size()), file_util::WriteFile(
+      target.AppendASCII("index.html"), changed.data(), changed.size()));
+  base::FilePath stale_file = target.AppendASCII("stale");
+  ASSERT_EQ(0, file_util::WriteFile(stale_file, "", 0));
+  EXPECT_TRUE(extractor_->UpdateTo(target, &stats));
+  EXPECT_EQ(1, stats.files_written);
+  EXPECT_EQ(1, stats.files_linked);
+  EXPECT_EQ(1, stats.files_removed);
+  EXPECT_FALSE(base::PathExists(stale_file));
+
+  std::string updated;
+  ASSERT_TRUE(file_util::ReadFileToString(target.AppendASCII("manifest.json"),
+                                          &updated));
+  EXPECT_EQ(manifest, updated);
+  ASSERT_TRUE(file_util::ReadFileToString(target.AppendASCII("index.html"),
+                                          &updated));
+  EXPECT_EQ(index, updated);
+
+  // A file of the same size is compared by content.
+  ASSERT_FALSE(index.empty());
+  std::string same_size(index);
+  same_size[same_size.size() / 2] ^= 1;
+  ASSERT_EQ(static_cast<int>(same_size.size()), file_util::WriteFile(
+      target.AppendASCII("index.html"), same_size.data(), same_size.size()));
+  stats = XPKExtractor::UpdateStats();
+  EXPECT_TRUE(extractor_->UpdateTo(target, &stats));
+  EXPECT_EQ(1, stats.files_written);
+  EXPECT_EQ(1, stats.files_linked);
+  EXPECT_EQ(0, stats.files_removed);
+  ASSERT_TRUE(file_util::ReadFileToString(target.AppendASCII("index.html"),
+                                          &updated));
+  EXPECT_EQ(index, updated);
+
+  // No staging directory is left.
+  base::FileEnumerator entries(temp_dir_.path(), false,
+      base::FileEnumerator::FILES | base::FileEnumerator::DIRECTORIES);
+  EXPECT_EQ(target, entries.Next());
+  EXPECT_TRUE(entries.Next().empty());
+}
+
+TEST_F(XPKExtractorTest, UpdateToBadSignature) {
+  SetupXPKExtractor("good.xpk");
+  ASSERT_TRUE(temp_dir_.CreateUniqueTempDir());
+  base::FilePath target = temp_dir_.path().AppendASCII("app");
+  ASSERT_TRUE(extractor_->ExtractTo(target));
+
+  // The previous version is left untouched.
+  SetupXPKExtractor("bad_signature.xpk");
+  XPKExtractor::UpdateStats stats;
+  EXPECT_FALSE(extractor_->UpdateTo(target, &stats));
+  EXPECT_TRUE(base::PathExists(target.AppendASCII("manifest.json")));
+}
+
+TEST_F(XPKExtractorTest, RecoverInterruptedUpdate) {
+  SetupXPKExtractor("good.xpk");
+  ASSERT_TRUE(temp_dir_.CreateUniqueTempDir());
+  base::FilePath target = temp_dir_.path().AppendASCII("app");
+  base::FilePath staging = temp_dir_.path().AppendASCII(".staging.app.ab12CD");
+  ASSERT_TRUE(extractor_->ExtractTo(staging));
+  ASSERT_TRUE(extractor_->ExtractTo(target));
+
+  // The process died after the previous version was renamed away, before
+  // the staging directory was renamed in place.
+  base::FilePath replaced = staging.AddExtension(FILE_PATH_LITERAL(".old"));
+  ASSERT_TRUE(base::Move(target, replaced));
+  XPKExtractor::RecoverInterruptedReplaces(temp_dir_.path());
+
+  EXPECT_TRUE(base::PathExists(target.AppendASCII("manifest.json")));
+  base::FileEnumerator entries(temp_dir_.path(), false,
+      base::FileEnumerator::FILES | base::FileEnumerator::DIRECTORIES);
+  EXPECT_EQ(target, entries.Next());
+  EXPECT_TRUE(entries.Next().empty());
+}
+
+TEST_F(XPKExtractorTest, RecoverCompletedUpdate) {
+  SetupXPKExtractor("good.xpk");
+  ASSERT_TRUE(temp_dir_.CreateUniqueTempDir());
+  base::FilePath target = temp_dir_.path().AppendASCII("app");
+  base::FilePath replaced =
+      temp_dir_.path().AppendASCII(".staging.app.ab12CD.old");
+  ASSERT_TRUE(extractor_->ExtractTo(target));
+  ASSERT_TRUE(file_util::CreateDirectory(replaced));
+  base::FilePath staging = temp_dir_.path().AppendASCII(".staging.app.ef34GH");
+  ASSERT_TRUE(file_util::CreateDirectory(staging));
+
+  // The process died before the previous version was deleted, and while
+  // another update was staged: only the installed version is kept.
+  XPKExtractor::RecoverInterruptedReplaces(temp_dir_.path());
+
+  EXPECT_TRUE(base::PathExists(target.AppendASCII("manifest.json")));
+  base::FileEnumerator entries(temp_dir_.path(), false,
+      base::FileEnumerator::FILES | base::FileEnumerator::DIRECTORIES);
+  EXPECT_EQ(target, entries.Next());
+  EXPECT_TRUE(entries.Next().empty());
+}
+
+TEST_F(XPKExtractorTest, ReadID) {
+  SetupXPKExtractor("good.xpk");
+  EXPECT_EQ(extractor_->GetPackageID(), XPKPackage::ReadID(xpk_path_));
+
+  // The id is read without verifying the package.
+  SetupXPKExtractor("bad_signature.xpk");
+  EXPECT_FALSE(XPKPackage::ReadID(xpk_path_).empty());
+  EXPECT_EQ(extractor_->GetPackageID(), XPKPackage::ReadID(xpk_path_));
+
+  SetupXPKExtractor("bad_magic.xpk");
+  EXPECT_TRUE(XPKPackage::ReadID(xpk_path_).empty());
+  SetupXPKExtractor("no_magic_header.xpk");
+  EXPECT_TRUE(XPKPackage::ReadID(xpk_path_).empty());
+}
+
 TEST_F(XPKExtractorTest, BadUnzipFile) {
   SetupXPKExtractor("bad_zip.xpk");
   base::FilePath path;
@@ -4,7 +4,13 @@
 
 #include "xwalk/application/browser/installer/xpk_package.h"
 
+#include <string.h>
+
+#include <algorithm>
+
 #include "base/file_util.h"
+#include "base/logging.h"
+#include "base/memory/scoped_handle.h"
 #include "crypto/signature_verifier.h"
 #include "xwalk/application/common/id_util.h"
 
@@ -16,6 +22,10 @@ const uint8 kSignatureAlgorithm[15] = {
   0xf7, 0x0d, 0x01, 0x01, 0x05, 0x05, 0x00
 };
 
+// The mapped zip file is passed to the verifier in slices of this size, since
+// it takes int lengths.
+const size_t kVerifySliceSize = 1 << 20;
+
 const char XPKPackage::kXPKPackageHeaderMagic[] = "CrWk";
 
 XPKPackage::XPKPackage() {
@@ -27,20 +37,13 @@ XPKPackage::~XPKPackage() {
 // static
 scoped_ptr<XPKPackage> XPKPackage::Create(const base::FilePath& path) {
   if (!base::PathExists(path))
-    scoped_ptr<XPKPackage>();
-  scoped_ptr<ScopedStdioHandle> file(
-      new ScopedStdioHandle(file_util::OpenFile(path, "rb")));
-  Header header;
-  size_t len = fread(&header, 1, sizeof(header), file->get());
-  if (len < sizeof(header))
     return scoped_ptr<XPKPackage>();
-  if (!strncmp(XPKPackage::kXPKPackageHeaderMagic,
-               header.magic,
-               sizeof(header.magic)) &&
-      header.key_size > 0 &&
-      header.key_size <= XPKPackage::kMaxPublicKeySize &&
-      header.signature_size > 0 &&
-      header.signature_size <= XPKPackage::kMaxSignatureKeySize) {
+  scoped_ptr<base::MemoryMappedFile> file(new base::MemoryMappedFile);
+  if (!file->Initialize(path) || file->length() < sizeof(Header))
+    return scoped_ptr<XPKPackage>();
+  Header header;
+  memcpy(&header, file->data(), sizeof(header));
+  if (IsHeaderValid(header)) {
     scoped_ptr<XPKPackage> package(new XPKPackage(header, file.release()));
     if (package->IsOk())
       return package.Pass();
@@ -48,38 +51,58 @@ scoped_ptr<XPKPackage> XPKPackage::Create(const base::FilePath& path) {
   return scoped_ptr<XPKPackage>();
 }
 
-XPKPackage::XPKPackage(Header header, ScopedStdioHandle* file)
+// static
+std::string XPKPackage::ReadID(const base::FilePath& path) {
+  ScopedStdioHandle file(file_util::OpenFile(path, "rb"));
+  if (!file.get())
+    return std::string();
+
+  Header header;
+  if (fread(&header, 1, sizeof(header), file.get()) < sizeof(header) ||
+      !IsHeaderValid(header))
+    return std::string();
+
+  std::string public_key(header.key_size, '\0');
+  if (fread(&public_key[0], 1, header.key_size, file.get()) < header.key_size)
+    return std::string();
+  return GenerateId(public_key);
+}
+
+// static
+bool XPKPackage::IsHeaderValid(const Header& header) {
+  return !strncmp(XPKPackage::kXPKPackageHeaderMagic,
+                  header.magic,
+                  sizeof(header.magic)) &&
+      header.key_size > 0 &&
+      header.key_size <= XPKPackage::kMaxPublicKeySize &&
+      header.signature_size > 0 &&
+      header.signature_size <= XPKPackage::kMaxSignatureKeySize;
+}
+
+XPKPackage::XPKPackage(Header header, base::MemoryMappedFile* file)
     : header_(header),
       file_(file),
       is_ok_(true) {
   zip_addr_ = sizeof(header) + header.key_size + header.signature_size;
-  fseek(file_->get(), sizeof(header), SEEK_SET);
-  key_.resize(header_.key_size);
-  size_t len = fread(
-      &key_.front(), sizeof(uint8), header_.key_size, file_->get());
-  if (len < header_.key_size)
-    is_ok_ = false;
-
-  signature_.resize(header_.signature_size);
-  len = fread(&signature_.front(),
-              sizeof(uint8),
-              header_.signature_size,
-              file_->get());
-  if (len < header_.signature_size)
+  if (file_->length() < zip_addr_) {
     is_ok_ = false;
+    return;
+  }
 
-  if (!Validate())
-    is_ok_ = false;
+  const uint8* data = file_->data() + sizeof(header);
+  key_.assign(data, data + header_.key_size);
+  data += header_.key_size;
+  signature_.assign(data, data + header_.signature_size);
 
   std::string public_key =
       std::string(reinterpret_cast<char*>(&key_.front()), key_.size());
   id_ = GenerateId(public_key);
 }
 
-bool XPKPackage::Validate() {
-// Set the file read position to the beginning of compressed resource file,
-// which is behind the magic header, public key and signature key.
-  fseek(file_->get(), zip_addr_, SEEK_SET);
+bool XPKPackage::Verify() const {
+  if (!is_ok_)
+    return false;
+
   crypto::SignatureVerifier verifier;
   if (!verifier.VerifyInit(kSignatureAlgorithm,
                            sizeof(kSignatureAlgorithm),
@@ -88,14 +111,18 @@ bool XPKPackage::Validate() {
                            &key_.front(),
                            key_.size()))
     return false;
-  unsigned char buf[1 << 12];
-  size_t len = 0;
-  while ((len = fread(buf, 1, sizeof(buf), file_->get())) > 0)
-    verifier.VerifyUpdate(buf, len);
-  if (!verifier.VerifyFinal())
-    return false;
 
-  return true;
+  // The compressed resource file is behind the magic header, public key and
+  // signature key.
+  const uint8* data = file_->data() + zip_addr_;
+  size_t remaining = file_->length() - zip_addr_;
+  while (remaining > 0) {
+    size_t len = std::min(remaining, kVerifySliceSize);
+    verifier.VerifyUpdate(data, len);
+    data += len;
+    remaining -= len;
+  }
+  return verifier.VerifyFinal();
 }
 
 }  // namespace application
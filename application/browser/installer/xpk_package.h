@@ -9,7 +9,7 @@
 #include <vector>
 
 #include "base/files/file_path.h"
-#include "base/memory/scoped_handle.h"
+#include "base/files/memory_mapped_file.h"
 #include "base/memory/scoped_ptr.h"
 
 namespace xwalk {
@@ -29,21 +29,31 @@ class XPKPackage {
   };
   XPKPackage();
   ~XPKPackage();
+  // Maps the package at |path| and reads its header, without verifying the
+  // signature yet, see Verify().
   static scoped_ptr<XPKPackage> Create(const base::FilePath& path);
-  // Validate the xpk file
+  // Returns the id of the package at |path|, or an empty string if its header
+  // is invalid. Only the header and the public key are read, the package is
+  // neither mapped nor verified.
+  static std::string ReadID(const base::FilePath& path);
+  // Whether the header of the xpk file is valid.
   bool IsOk() const { return is_ok_; }
   const std::string& Id() const { return id_; }
 
+  // Verifies the signature of the zip file. It only reads the mapped package,
+  // so it can run in another thread while the zip file is extracted.
+  bool Verify() const;
+
  private:
-  XPKPackage(Header header, ScopedStdioHandle* file);
-  bool Validate();
+  XPKPackage(Header header, base::MemoryMappedFile* file);
+  static bool IsHeaderValid(const Header& header);
 
   Header header_;
-  scoped_ptr<ScopedStdioHandle> file_;
+  scoped_ptr<base::MemoryMappedFile> file_;
   std::vector<uint8> signature_;
   std::vector<uint8> key_;
   // It's the beginning address of the zip file
-  int zip_addr_;
+  size_t zip_addr_;
   bool is_ok_;
   std::string id_;
 };
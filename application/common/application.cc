@@ -96,6 +96,13 @@ GURL Application::GetBaseURLFromApplicationId(
               content::kStandardSchemeSeparator + application_id + "/");
 }
 
+// static
+std::string Application::GetLocalizedName(const std::string& name) {
+  string16 localized_name = UTF8ToUTF16(name);
+  base::i18n::AdjustStringForLocaleDirection(&localized_name);
+  return UTF16ToUTF8(localized_name);
+}
+
 Application::ManifestData* Application::GetManifestData(const std::string& key)
     const {
   DCHECK(finished_parsing_manifest_ || thread_checker_.CalledOnValidThread());
@@ -208,14 +215,13 @@ bool Application::Init(string16* error) {
 
 bool Application::LoadName(string16* error) {
   DCHECK(error);
-  string16 localized_name;
-  if (!manifest_->GetString(keys::kNameKey, &localized_name)) {
+  std::string name;
+  if (!manifest_->GetString(keys::kNameKey, &name)) {
     *error = ASCIIToUTF16(errors::kInvalidName);
     return false;
   }
-  non_localized_name_ = UTF16ToUTF8(localized_name);
-  base::i18n::AdjustStringForLocaleDirection(&localized_name);
-  name_ = UTF16ToUTF8(localized_name);
+  non_localized_name_ = name;
+  name_ = GetLocalizedName(name);
   return true;
 }
 
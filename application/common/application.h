@@ -81,6 +81,10 @@ class Application : public base::RefCountedThreadSafe<Application> {
   // Returns the base application url for a given |application_id|.
   static GURL GetBaseURLFromApplicationId(const std::string& application_id);
 
+  // Returns what Name() is for an application whose manifest name is |name|,
+  // adjusted for the direction of the current locale.
+  static std::string GetLocalizedName(const std::string& name);
+
   // Get the manifest data associated with the key, or NULL if there is none.
   // Can only be called after InitValue is finished.
   ManifestData* GetManifestData(const std::string& key) const;
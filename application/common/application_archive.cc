@@ -0,0 +1,256 @@
+// Copyright (c) 2013 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "xwalk/application/common/application_archive.h"
+
+#include <string.h>
+
+#include <algorithm>
+
+#include "base/logging.h"
+
+namespace xwalk {
+namespace application {
+
+namespace {
+
+// The zip records read, see the .ZIP File Format Specification.
+const uint32 kEndOfCentralDirectorySignature = 0x06054b50;
+const size_t kEndOfCentralDirectorySize = 22;
+// The comment at the end of a zip file is at most this long.
+const size_t kMaxCommentSize = 0xffff;
+const uint32 kCentralDirectoryHeaderSignature = 0x02014b50;
+const size_t kCentralDirectoryHeaderSize = 46;
+const uint32 kLocalHeaderSignature = 0x04034b50;
+const size_t kLocalHeaderSize = 30;
+
+const uint16 kEncryptedFlag = 1;
+const uint16 kStoredMethod = 0;
+const uint16 kDeflatedMethod = 8;
+
+uint16 ReadUInt16(const uint8* data) {
+  return data[0] | (data[1] << 8);
+}
+
+uint32 ReadUInt32(const uint8* data) {
+  return data[0] | (data[1] << 8) | (data[2] << 16) |
+         (static_cast<uint32>(data[3]) << 24);
+}
+
+}  // namespace
+
+ApplicationArchive::EntryReader::EntryReader(ApplicationArchive* archive,
+                                             const uint8* data,
+                                             size_t compressed_size,
+                                             size_t size,
+                                             bool deflated)
+    : archive_(archive),
+      data_(data),
+      compressed_size_(compressed_size),
+      size_(size),
+      deflated_(deflated),
+      offset_(0),
+      stream_initialized_(false),
+      stream_ended_(false) {
+  memset(&stream_, 0, sizeof(stream_));
+}
+
+ApplicationArchive::EntryReader::~EntryReader() {
+  if (stream_initialized_)
+    inflateEnd(&stream_);
+}
+
+int ApplicationArchive::EntryReader::Read(char* buffer, int size) {
+  DCHECK_GE(size, 0);
+  if (!deflated_) {
+    size_t read = std::min(size_ - offset_, static_cast<size_t>(size));
+    memcpy(buffer, data_ + offset_, read);
+    offset_ += read;
+    return static_cast<int>(read);
+  }
+
+  if (!stream_initialized_) {
+    // The entries hold raw deflate data, without zlib header.
+    if (inflateInit2(&stream_, -MAX_WBITS) != Z_OK)
+      return -1;
+    stream_initialized_ = true;
+    stream_.next_in = const_cast<Bytef*>(data_);
+    stream_.avail_in = static_cast<uInt>(compressed_size_);
+  }
+
+  if (stream_ended_ || size == 0)
+    return 0;
+
+  // Never inflates past the declared size. Once it's reached the stream must
+  // end without more output, so a corrupted or malicious entry fails instead
+  // of producing more data than announced.
+  size_t remaining = size_ - stream_.total_out;
+  char extra_byte;
+  uInt output_size = static_cast<uInt>(
+      std::min(remaining, static_cast<size_t>(size)));
+  if (remaining == 0) {
+    buffer = &extra_byte;
+    output_size = 1;
+  }
+
+  stream_.next_out = reinterpret_cast<Bytef*>(buffer);
+  stream_.avail_out = output_size;
+  // The whole input is available, so inflate() only stops when the output
+  // buffer is full, at the end of the stream, or on errors.
+  while (stream_.avail_out == output_size) {
+    int result = inflate(&stream_, Z_NO_FLUSH);
+    if (result == Z_STREAM_END) {
+      stream_ended_ = true;
+      break;
+    }
+    if (result != Z_OK)
+      return -1;
+  }
+
+  if (stream_.total_out > size_ ||
+      (stream_ended_ && stream_.total_out != size_))
+    return -1;
+  return static_cast<int>(output_size - stream_.avail_out);
+}
+
+ApplicationArchive::ApplicationArchive(const base::FilePath& path)
+    : path_(path),
+      opened_(false),
+      valid_(false),
+      zip_offset_(0) {
+}
+
+ApplicationArchive::~ApplicationArchive() {
+}
+
+bool ApplicationArchive::Open() {
+  base::AutoLock lock(lock_);
+  if (opened_)
+    return valid_;
+
+  opened_ = true;
+  file_.reset(new base::MemoryMappedFile);
+  if (!file_->Initialize(path_) || !Index()) {
+    LOG(ERROR) << "Invalid application package: " << path_.value();
+    entries_.clear();
+    file_.reset();
+    return false;
+  }
+  valid_ = true;
+  return true;
+}
+
+scoped_refptr<ApplicationArchive::EntryReader> ApplicationArchive::OpenEntry(
+    const std::string& name) {
+  if (!Open())
+    return NULL;
+
+  EntryMap::const_iterator it = entries_.find(name);
+  if (it == entries_.end())
+    return NULL;
+
+  // The local header may have a different extra field than the central
+  // directory one, so the data offset is only known from it.
+  const Entry& entry = it->second;
+  const uint8* data = file_->data();
+  size_t length = file_->length();
+  size_t header = zip_offset_ + entry.local_header_offset;
+  if (header > length || length - header < kLocalHeaderSize ||
+      ReadUInt32(data + header) != kLocalHeaderSignature)
+    return NULL;
+  size_t data_offset = header + kLocalHeaderSize +
+      ReadUInt16(data + header + 26) + ReadUInt16(data + header + 28);
+  if (data_offset > length || length - data_offset < entry.compressed_size)
+    return NULL;
+
+  return new EntryReader(this, data + data_offset, entry.compressed_size,
+                         entry.size, entry.deflated);
+}
+
+bool ApplicationArchive::ReadEntry(const std::string& name,
+                                   std::string* data) {
+  scoped_refptr<EntryReader> reader = OpenEntry(name);
+  if (!reader)
+    return false;
+
+  data->resize(static_cast<size_t>(reader->size()));
+  size_t offset = 0;
+  while (offset < data->size()) {
+    int read = reader->Read(&(*data)[offset],
+                            static_cast<int>(data->size() - offset));
+    if (read <= 0)
+      return false;
+    offset += read;
+  }
+  // The entry must not have more content than its declared size.
+  char extra_byte;
+  return reader->Read(&extra_byte, 1) == 0;
+}
+
+bool ApplicationArchive::Index() {
+  const uint8* data = file_->data();
+  size_t length = file_->length();
+  if (length < kEndOfCentralDirectorySize)
+    return false;
+
+  // The end of central directory record is before the zip file comment.
+  size_t end_record = length - kEndOfCentralDirectorySize;
+  size_t min_end_record =
+      end_record > kMaxCommentSize ? end_record - kMaxCommentSize : 0;
+  while (ReadUInt32(data + end_record) != kEndOfCentralDirectorySignature) {
+    if (end_record == min_end_record)
+      return false;
+    --end_record;
+  }
+
+  size_t entry_count = ReadUInt16(data + end_record + 10);
+  size_t directory_size = ReadUInt32(data + end_record + 12);
+  size_t directory_offset = ReadUInt32(data + end_record + 16);
+  if (directory_size > end_record ||
+      directory_offset > end_record - directory_size)
+    return false;
+
+  // The offsets are relative to the beginning of the zip file, which is
+  // after the package header.
+  zip_offset_ = end_record - directory_size - directory_offset;
+  const uint8* header = data + zip_offset_ + directory_offset;
+  const uint8* directory_end = header + directory_size;
+  for (size_t i = 0; i < entry_count; ++i) {
+    if (directory_end - header <
+            static_cast<ptrdiff_t>(kCentralDirectoryHeaderSize) ||
+        ReadUInt32(header) != kCentralDirectoryHeaderSignature)
+      return false;
+
+    uint16 flags = ReadUInt16(header + 8);
+    uint16 method = ReadUInt16(header + 10);
+    Entry entry;
+    entry.compressed_size = ReadUInt32(header + 20);
+    entry.size = ReadUInt32(header + 24);
+    size_t name_size = ReadUInt16(header + 28);
+    size_t record_size = kCentralDirectoryHeaderSize + name_size +
+        ReadUInt16(header + 30) + ReadUInt16(header + 32);
+    entry.local_header_offset = ReadUInt32(header + 42);
+    if (directory_end - header < static_cast<ptrdiff_t>(record_size))
+      return false;
+
+    std::string name(reinterpret_cast<const char*>(header) +
+                         kCentralDirectoryHeaderSize,
+                     name_size);
+    header += record_size;
+
+    // Directories aren't served, and neither are the files that can't be.
+    if (name.empty() || name[name.size() - 1] == '/' ||
+        (flags & kEncryptedFlag) ||
+        (method != kStoredMethod && method != kDeflatedMethod))
+      continue;
+    if (method == kStoredMethod && entry.compressed_size != entry.size)
+      return false;
+    entry.deflated = method == kDeflatedMethod;
+    entries_[name] = entry;
+  }
+  return true;
+}
+
+}  // namespace application
+}  // namespace xwalk
@@ -0,0 +1,119 @@
+// Copyright (c) 2013 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef XWALK_APPLICATION_COMMON_APPLICATION_ARCHIVE_H_
+#define XWALK_APPLICATION_COMMON_APPLICATION_ARCHIVE_H_
+
+#include <map>
+#include <string>
+
+#include "base/files/file_path.h"
+#include "base/files/memory_mapped_file.h"
+#include "base/memory/ref_counted.h"
+#include "base/memory/scoped_ptr.h"
+#include "base/synchronization/lock.h"
+#include "third_party/zlib/zlib.h"
+
+namespace xwalk {
+namespace application {
+
+// Reads the files of an application package in place, without extracting
+// it. The package is memory mapped and the zip central directory is indexed
+// when it's opened, so finding a file doesn't scan the package. Stored files
+// are copied straight from the mapping and deflated ones are inflated as a
+// stream. The package may start with a header, like the XPK ones.
+class ApplicationArchive
+    : public base::RefCountedThreadSafe<ApplicationArchive> {
+ public:
+  // Reads the content of a file of the archive. It must only be used from
+  // one thread at a time.
+  class EntryReader : public base::RefCountedThreadSafe<EntryReader> {
+   public:
+    // Reads up to |size| bytes to |buffer|. Returns the number of bytes read,
+    // 0 at the end of the file, or -1 if the file is corrupted. A compressed
+    // file whose content is longer than its declared size is corrupted, and
+    // is never inflated past that size.
+    int Read(char* buffer, int size);
+
+    // The size of the file content.
+    int64 size() const { return size_; }
+
+   private:
+    friend class ApplicationArchive;
+    friend class base::RefCountedThreadSafe<EntryReader>;
+
+    EntryReader(ApplicationArchive* archive,
+                const uint8* data,
+                size_t compressed_size,
+                size_t size,
+                bool deflated);
+    ~EntryReader();
+
+    // Keeps the mapping of |data_| alive.
+    scoped_refptr<ApplicationArchive> archive_;
+    const uint8* data_;
+    size_t compressed_size_;
+    size_t size_;
+    bool deflated_;
+    // The bytes of a stored file read so far.
+    size_t offset_;
+    z_stream stream_;
+    bool stream_initialized_;
+    bool stream_ended_;
+
+    DISALLOW_COPY_AND_ASSIGN(EntryReader);
+  };
+
+  explicit ApplicationArchive(const base::FilePath& path);
+
+  const base::FilePath& path() const { return path_; }
+
+  // Maps the package and indexes it the first time it's called, then only
+  // returns whether it succeeded. It can be called from any thread.
+  bool Open();
+
+  // Returns a reader for the file |name|, a path relative to the package
+  // root with '/' separators, or NULL if there's no such file. Opens the
+  // package if needed.
+  scoped_refptr<EntryReader> OpenEntry(const std::string& name);
+
+  // Reads the whole content of the file |name| to |data|.
+  bool ReadEntry(const std::string& name, std::string* data);
+
+ private:
+  friend class base::RefCountedThreadSafe<ApplicationArchive>;
+
+  struct Entry {
+    // Offset of the local header, from the beginning of the zip file.
+    size_t local_header_offset;
+    size_t compressed_size;
+    size_t size;
+    bool deflated;
+  };
+  typedef std::map<std::string, Entry> EntryMap;
+
+  ~ApplicationArchive();
+
+  // Indexes the central directory of the mapped package.
+  bool Index();
+
+  base::FilePath path_;
+
+  base::Lock lock_;
+  bool opened_;
+  bool valid_;
+
+  // The members below are only written by the first Open().
+  scoped_ptr<base::MemoryMappedFile> file_;
+  // The offset of the zip file in the package, after the package header.
+  size_t zip_offset_;
+  EntryMap entries_;
+
+  DISALLOW_COPY_AND_ASSIGN(ApplicationArchive);
+};
+
+}  // namespace application
+}  // namespace xwalk
+
+#endif  // XWALK_APPLICATION_COMMON_APPLICATION_ARCHIVE_H_
@@ -0,0 +1,111 @@
+// Copyright (c) 2013 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "xwalk/application/common/application_archive.h"
+
+#include <string.h>
+
+#include "base/file_util.h"
+#include "base/files/scoped_temp_dir.h"
+#include "base/path_service.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "xwalk/application/common/application.h"
+#include "xwalk/application/common/application_file_util.h"
+
+namespace xwalk {
+namespace application {
+
+class ApplicationArchiveTest : public testing::Test {
+ protected:
+  base::FilePath GetPackagePath(const std::string& name) {
+    base::FilePath path;
+    PathService::Get(base::DIR_SOURCE_ROOT, &path);
+    return path.AppendASCII("xwalk")
+        .AppendASCII("application")
+        .AppendASCII("test")
+        .AppendASCII("unpacker")
+        .AppendASCII(name);
+  }
+};
+
+TEST_F(ApplicationArchiveTest, ReadEntry) {
+  scoped_refptr<ApplicationArchive> archive(
+      new ApplicationArchive(GetPackagePath("good.xpk")));
+  ASSERT_TRUE(archive->Open());
+
+  std::string manifest;
+  ASSERT_TRUE(archive->ReadEntry("manifest.json", &manifest));
+  EXPECT_EQ('{', manifest[0]);
+  EXPECT_FALSE(archive->OpenEntry("missing.html"));
+
+  // Reading in small chunks streams the same content.
+  scoped_refptr<ApplicationArchive::EntryReader> reader =
+      archive->OpenEntry("manifest.json");
+  ASSERT_TRUE(reader);
+  EXPECT_EQ(static_cast<int64>(manifest.size()), reader->size());
+  std::string streamed;
+  char buffer[7];
+  int read;
+  while ((read = reader->Read(buffer, sizeof(buffer))) > 0)
+    streamed.append(buffer, read);
+  EXPECT_EQ(0, read);
+  EXPECT_EQ(manifest, streamed);
+}
+
+TEST_F(ApplicationArchiveTest, EntryLargerThanDeclared) {
+  // Declares manifest.json one byte shorter than its content in the central
+  // directory of a copy of good.xpk.
+  std::string package;
+  ASSERT_TRUE(base::ReadFileToString(GetPackagePath("good.xpk"), &package));
+  const char kHeaderSignature[] = "PK\x01\x02";
+  const char kName[] = "manifest.json";
+  const size_t kNameOffset = 46;
+  size_t header = package.find(kHeaderSignature);
+  while (header != std::string::npos &&
+         package.compare(header + kNameOffset, strlen(kName), kName) != 0)
+    header = package.find(kHeaderSignature, header + 1);
+  ASSERT_NE(std::string::npos, header);
+  uint8* size = reinterpret_cast<uint8*>(&package[header + 24]);
+  ASSERT_NE(0, size[0]);
+  --size[0];
+
+  base::ScopedTempDir temp_dir;
+  ASSERT_TRUE(temp_dir.CreateUniqueTempDir());
+  base::FilePath path = temp_dir.path().AppendASCII("larger.xpk");
+  ASSERT_EQ(static_cast<int>(package.size()),
+            file_util::WriteFile(path, package.data(), package.size()));
+
+  scoped_refptr<ApplicationArchive> archive(new ApplicationArchive(path));
+  ASSERT_TRUE(archive->Open());
+  std::string manifest;
+  EXPECT_FALSE(archive->ReadEntry("manifest.json", &manifest));
+
+  // The reader stops at the declared size, then reports the extra content.
+  scoped_refptr<ApplicationArchive::EntryReader> reader =
+      archive->OpenEntry("manifest.json");
+  ASSERT_TRUE(reader);
+  int buffer_size = static_cast<int>(reader->size()) + 1;
+  std::string content(buffer_size, '\0');
+  EXPECT_EQ(reader->size(), reader->Read(&content[0], buffer_size));
+  EXPECT_EQ(-1, reader->Read(&content[0], buffer_size));
+}
+
+TEST_F(ApplicationArchiveTest, InvalidArchive) {
+  scoped_refptr<ApplicationArchive> archive(
+      new ApplicationArchive(GetPackagePath("bad_zip.xpk")));
+  EXPECT_FALSE(archive->Open());
+  EXPECT_FALSE(archive->OpenEntry("manifest.json"));
+}
+
+TEST_F(ApplicationArchiveTest, LoadPackedApplication) {
+  std::string error;
+  base::FilePath path = GetPackagePath("good.xpk");
+  scoped_refptr<Application> application = LoadPackedApplication(
+      path, std::string(), Manifest::COMMAND_LINE, &error);
+  ASSERT_TRUE(application) << error;
+  EXPECT_EQ(path, application->Path());
+}
+
+}  // namespace application
+}  // namespace xwalk
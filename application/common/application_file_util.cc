@@ -11,6 +11,7 @@
 #include "base/files/file_path.h"
 #include "base/files/scoped_temp_dir.h"
 #include "base/json/json_file_value_serializer.h"
+#include "base/json/json_string_value_serializer.h"
 #include "base/logging.h"
 #include "base/metrics/histogram.h"
 #include "base/path_service.h"
@@ -18,6 +19,7 @@
 #include "base/strings/utf_string_conversions.h"
 #include "base/threading/thread_restrictions.h"
 #include "xwalk/application/common/application.h"
+#include "xwalk/application/common/application_archive.h"
 #include "xwalk/application/common/constants.h"
 #include "xwalk/application/common/manifest.h"
 #include "xwalk/application/common/application_manifest_constants.h"
@@ -59,6 +61,43 @@ scoped_refptr<Application> LoadApplication(
   return application;
 }
 
+scoped_refptr<Application> LoadPackedApplication(
+    const base::FilePath& package_path,
+    const std::string& application_id,
+    Manifest::SourceType source_type,
+    std::string* error) {
+  scoped_refptr<ApplicationArchive> archive(
+      new ApplicationArchive(package_path));
+  std::string manifest_data;
+  if (!archive->ReadEntry(base::FilePath(kManifestFilename).AsUTF8Unsafe(),
+                          &manifest_data)) {
+    *error = base::StringPrintf("%s",
+                                errors::kManifestUnreadable);
+    return NULL;
+  }
+
+  JSONStringValueSerializer serializer(manifest_data);
+  scoped_ptr<Value> root(serializer.Deserialize(NULL, error));
+  if (!root.get()) {
+    *error = base::StringPrintf("%s  %s",
+                                errors::kManifestParseError,
+                                error->c_str());
+    return NULL;
+  }
+
+  if (!root->IsType(Value::TYPE_DICTIONARY)) {
+    *error = base::StringPrintf("%s",
+                                errors::kManifestUnreadable);
+    return NULL;
+  }
+
+  return Application::Create(package_path,
+                             source_type,
+                             *static_cast<DictionaryValue*>(root.get()),
+                             application_id,
+                             error);
+}
+
 DictionaryValue* LoadManifest(const base::FilePath& application_path,
                               std::string* error) {
   base::FilePath manifest_path =
@@ -39,6 +39,15 @@ scoped_refptr<Application> LoadApplication(
     Manifest::SourceType source_type,
     std::string* error);
 
+// Loads an application from the package |package_path| without extracting it,
+// see ApplicationArchive. Returns NULL on failure, with a description of the
+// error in |error|.
+scoped_refptr<Application> LoadPackedApplication(
+    const base::FilePath& package_path,
+    const std::string& application_id,
+    Manifest::SourceType source_type,
+    std::string* error);
+
 // Loads an application manifest from the specified directory. Returns NULL
 // on failure, with a description of the error in |error|.
 base::DictionaryValue* LoadManifest(const base::FilePath& application_root,
@@ -17,6 +17,7 @@ namespace application_manifest_keys {
   extern const char kLaunchWebURLKey[];
   extern const char kManifestVersionKey[];
   extern const char kNameKey[];
+  extern const char kPermissionsKey[];
   extern const char kVersionKey[];
   extern const char kWebURLsKey[];
 }  // namespace application_manifest_keys
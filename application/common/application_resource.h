@@ -59,6 +59,7 @@ class ApplicationResource {
   const std::string& application_id() const { return application_id_; }
   const base::FilePath& application_root() const { return application_root_; }
   const base::FilePath& relative_path() const { return relative_path_; }
+  bool follow_symlinks_anywhere() const { return follow_symlinks_anywhere_; }
 
   bool empty() const { return application_root().empty(); }
 
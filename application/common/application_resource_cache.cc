@@ -0,0 +1,131 @@
+// Copyright (c) 2013 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "xwalk/application/common/application_resource_cache.h"
+
+#include "base/file_util.h"
+#include "base/platform_file.h"
+#include "xwalk/application/common/application_resource.h"
+
+namespace xwalk {
+namespace application {
+
+// A few applications with a few hundreds of resources each fit, for well
+// under a megabyte.
+const size_t ApplicationResourceCache::kMaxCachedFiles = 2048;
+
+ApplicationResourceCache::ResolvedFile::ResolvedFile()
+    : has_file_info(false),
+      size(0) {
+}
+
+ApplicationResourceCache::ResolvedFile::~ResolvedFile() {
+}
+
+ApplicationResourceCache::ApplicationResourceCache()
+    : files_(kMaxCachedFiles) {
+}
+
+ApplicationResourceCache::ApplicationResourceCache(size_t max_cached_files)
+    : files_(max_cached_files) {
+}
+
+ApplicationResourceCache::~ApplicationResourceCache() {
+}
+
+// static
+ApplicationResourceCache* ApplicationResourceCache::GetInstance() {
+  return Singleton<ApplicationResourceCache>::get();
+}
+
+// static
+ApplicationResourceCache::ResourceKey ApplicationResourceCache::GetKey(
+    const ApplicationResource& resource) {
+  return ResourceKey(resource.application_id(),
+                     std::make_pair(resource.relative_path(),
+                                    resource.follow_symlinks_anywhere()));
+}
+
+bool ApplicationResourceCache::Get(const ApplicationResource& resource,
+                                   ResolvedFile* file) {
+  if (resource.empty() || resource.relative_path().empty())
+    return false;
+
+  base::AutoLock lock(lock_);
+  FileCache::iterator it = files_.Get(GetKey(resource));
+  if (it == files_.end())
+    return false;
+  if (it->second.application_root != resource.application_root()) {
+    files_.Erase(it);
+    return false;
+  }
+
+  *file = it->second.file;
+  return true;
+}
+
+void ApplicationResourceCache::Set(const ApplicationResource& resource,
+                                   const ResolvedFile& file) {
+  if (resource.empty() || resource.relative_path().empty() ||
+      file.file_path.empty())
+    return;
+
+  CachedFile cached_file;
+  cached_file.application_root = resource.application_root();
+  cached_file.file = file;
+  base::AutoLock lock(lock_);
+  files_.Put(GetKey(resource), cached_file);
+}
+
+void ApplicationResourceCache::Invalidate(const std::string& application_id) {
+  base::AutoLock lock(lock_);
+  InvalidateFiles(application_id);
+  roots_.erase(application_id);
+}
+
+void ApplicationResourceCache::InvalidateIfChanged(
+    const std::string& application_id,
+    const base::FilePath& application_root) {
+  // A root which can't be stat'ed, like one being replaced, is recorded as
+  // such, so the files are invalidated again once it's back.
+  base::PlatformFileInfo root_info;
+  if (!file_util::GetFileInfo(application_root, &root_info))
+    root_info = base::PlatformFileInfo();
+
+  base::AutoLock lock(lock_);
+  RootMap::iterator it = roots_.find(application_id);
+  if (it != roots_.end() && it->second.path == application_root &&
+      it->second.last_modified == root_info.last_modified &&
+      it->second.creation_time == root_info.creation_time)
+    return;
+
+  // The files cached before the root was first seen, like the preloaded
+  // ones, are from the current root.
+  if (it != roots_.end())
+    InvalidateFiles(application_id);
+  RootInfo& root = roots_[application_id];
+  root.path = application_root;
+  root.last_modified = root_info.last_modified;
+  root.creation_time = root_info.creation_time;
+}
+
+size_t ApplicationResourceCache::size() const {
+  base::AutoLock lock(lock_);
+  return files_.size();
+}
+
+void ApplicationResourceCache::InvalidateFiles(
+    const std::string& application_id) {
+  lock_.AssertAcquired();
+  FileCache::iterator it = files_.begin();
+  while (it != files_.end()) {
+    if (it->first.first == application_id)
+      it = files_.Erase(it);
+    else
+      ++it;
+  }
+}
+
+}  // namespace application
+}  // namespace xwalk
@@ -0,0 +1,117 @@
+// Copyright (c) 2013 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef XWALK_APPLICATION_COMMON_APPLICATION_RESOURCE_CACHE_H_
+#define XWALK_APPLICATION_COMMON_APPLICATION_RESOURCE_CACHE_H_
+
+#include <map>
+#include <string>
+#include <utility>
+
+#include "base/basictypes.h"
+#include "base/containers/mru_cache.h"
+#include "base/files/file_path.h"
+#include "base/memory/singleton.h"
+#include "base/synchronization/lock.h"
+#include "base/time/time.h"
+
+namespace xwalk {
+namespace application {
+
+class ApplicationResource;
+
+// Caches the files the application resources resolve to, see
+// ApplicationResource::GetFilePath(), so a resource loaded again isn't
+// resolved on the file system again. Only the resources found are cached,
+// for the symlink policy they were resolved with, and only the most recently
+// used ones are kept. It can be used from any thread.
+//
+// Updating or uninstalling an application invalidates its files in the
+// process doing it. The process serving the application, which may be
+// another one, invalidates them when the root directory of the application
+// changes, see InvalidateIfChanged().
+class ApplicationResourceCache {
+ public:
+  // What's known of the file a resource resolves to.
+  struct ResolvedFile {
+    ResolvedFile();
+    ~ResolvedFile();
+
+    base::FilePath file_path;
+    // Whether |size|, |last_modified| and |compressed_file_path| were read
+    // along with the path.
+    bool has_file_info;
+    int64 size;
+    base::Time last_modified;
+    // The gzip compressed copy of the file, if any.
+    base::FilePath compressed_file_path;
+  };
+
+  // The number of files kept by the cache of the process.
+  static const size_t kMaxCachedFiles;
+
+  // Keeps up to |max_cached_files| files.
+  explicit ApplicationResourceCache(size_t max_cached_files);
+  ~ApplicationResourceCache();
+
+  static ApplicationResourceCache* GetInstance();
+
+  // Returns false if the file of |resource| isn't cached.
+  bool Get(const ApplicationResource& resource, ResolvedFile* file);
+
+  // Caches |file| as the file of |resource|, evicting the least recently used
+  // file if the cache is full.
+  void Set(const ApplicationResource& resource, const ResolvedFile& file);
+
+  // Forgets the files of the resources of |application_id|.
+  void Invalidate(const std::string& application_id);
+
+  // Forgets the files of the resources of |application_id| if its
+  // |application_root| was replaced or modified since the previous call, as
+  // an update replaces it. It stats |application_root|, so it must be called
+  // from a thread allowing IO.
+  void InvalidateIfChanged(const std::string& application_id,
+                           const base::FilePath& application_root);
+
+  size_t size() const;
+
+ private:
+  friend struct DefaultSingletonTraits<ApplicationResourceCache>;
+
+  // The application ID, the relative path of a resource, and whether it may
+  // be a symlink to anywhere.
+  typedef std::pair<std::string, std::pair<base::FilePath, bool> >
+      ResourceKey;
+  struct CachedFile {
+    // The files resolved from another root are stale.
+    base::FilePath application_root;
+    ResolvedFile file;
+  };
+  typedef base::MRUCache<ResourceKey, CachedFile> FileCache;
+  // What identifies the version of the root directory of an application.
+  struct RootInfo {
+    base::FilePath path;
+    base::Time last_modified;
+    base::Time creation_time;
+  };
+  typedef std::map<std::string, RootInfo> RootMap;
+
+  ApplicationResourceCache();
+
+  static ResourceKey GetKey(const ApplicationResource& resource);
+
+  // Called with |lock_| held.
+  void InvalidateFiles(const std::string& application_id);
+
+  mutable base::Lock lock_;
+  FileCache files_;
+  RootMap roots_;
+
+  DISALLOW_COPY_AND_ASSIGN(ApplicationResourceCache);
+};
+
+}  // namespace application
+}  // namespace xwalk
+
+#endif  // XWALK_APPLICATION_COMMON_APPLICATION_RESOURCE_CACHE_H_
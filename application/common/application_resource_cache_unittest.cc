@@ -0,0 +1,113 @@
+// Copyright (c) 2013 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "xwalk/application/common/application_resource_cache.h"
+
+#include "base/file_util.h"
+#include "base/files/scoped_temp_dir.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "xwalk/application/common/application_resource.h"
+
+namespace xwalk {
+namespace application {
+
+TEST(ApplicationResourceCacheTest, GetAndInvalidate) {
+  ApplicationResourceCache* cache = ApplicationResourceCache::GetInstance();
+  const base::FilePath root(FILE_PATH_LITERAL("root"));
+  const base::FilePath relative_path(FILE_PATH_LITERAL("index.html"));
+  ApplicationResource resource("app", root, relative_path);
+  ApplicationResourceCache::ResolvedFile file;
+  file.file_path = root.Append(relative_path);
+  file.has_file_info = true;
+  file.size = 42;
+  file.last_modified = base::Time::FromDoubleT(1000);
+
+  ApplicationResourceCache::ResolvedFile cached_file;
+  EXPECT_FALSE(cache->Get(resource, &cached_file));
+  cache->Set(resource, file);
+  ASSERT_TRUE(cache->Get(resource, &cached_file));
+  EXPECT_EQ(file.file_path, cached_file.file_path);
+  EXPECT_TRUE(cached_file.has_file_info);
+  EXPECT_EQ(file.size, cached_file.size);
+  EXPECT_EQ(file.last_modified, cached_file.last_modified);
+
+  // The path resolved with another symlink policy or root isn't used.
+  ApplicationResource symlink_resource("app", root, relative_path);
+  symlink_resource.set_follow_symlinks_anywhere();
+  EXPECT_FALSE(cache->Get(symlink_resource, &cached_file));
+  ApplicationResource moved_resource(
+      "app", base::FilePath(FILE_PATH_LITERAL("moved")), relative_path);
+  EXPECT_FALSE(cache->Get(moved_resource, &cached_file));
+
+  cache->Invalidate("app");
+  EXPECT_FALSE(cache->Get(resource, &cached_file));
+}
+
+TEST(ApplicationResourceCacheTest, EvictsLeastRecentlyUsed) {
+  ApplicationResourceCache cache(2);
+  const base::FilePath root(FILE_PATH_LITERAL("root"));
+  ApplicationResource first("app", root,
+                            base::FilePath(FILE_PATH_LITERAL("first.html")));
+  ApplicationResource second("app", root,
+                             base::FilePath(FILE_PATH_LITERAL("second.html")));
+  ApplicationResource third("other", root,
+                            base::FilePath(FILE_PATH_LITERAL("third.html")));
+  ApplicationResourceCache::ResolvedFile file;
+  file.file_path = root.Append(first.relative_path());
+  cache.Set(first, file);
+  file.file_path = root.Append(second.relative_path());
+  cache.Set(second, file);
+
+  // Getting the first file makes the second one the least recently used.
+  ApplicationResourceCache::ResolvedFile cached_file;
+  EXPECT_TRUE(cache.Get(first, &cached_file));
+  file.file_path = root.Append(third.relative_path());
+  cache.Set(third, file);
+  EXPECT_EQ(2u, cache.size());
+  EXPECT_TRUE(cache.Get(first, &cached_file));
+  EXPECT_FALSE(cache.Get(second, &cached_file));
+  EXPECT_TRUE(cache.Get(third, &cached_file));
+
+  // Only the files of the invalidated application are forgotten.
+  cache.Invalidate("app");
+  EXPECT_EQ(1u, cache.size());
+  EXPECT_TRUE(cache.Get(third, &cached_file));
+}
+
+TEST(ApplicationResourceCacheTest, InvalidateIfChanged) {
+  base::ScopedTempDir temp_dir;
+  ASSERT_TRUE(temp_dir.CreateUniqueTempDir());
+  const base::FilePath root = temp_dir.path();
+  ApplicationResourceCache cache(2);
+  ApplicationResource resource("app", root,
+                               base::FilePath(FILE_PATH_LITERAL("index.html")));
+  ApplicationResourceCache::ResolvedFile file;
+  file.file_path = root.Append(resource.relative_path());
+  cache.Set(resource, file);
+
+  // The files cached before the root is first seen are kept.
+  ApplicationResourceCache::ResolvedFile cached_file;
+  cache.InvalidateIfChanged("app", root);
+  EXPECT_TRUE(cache.Get(resource, &cached_file));
+  cache.InvalidateIfChanged("app", root);
+  EXPECT_TRUE(cache.Get(resource, &cached_file));
+
+  // The root was modified, like by an update.
+  const base::Time modified = base::Time::FromDoubleT(1000);
+  ASSERT_TRUE(file_util::TouchFile(root, modified, modified));
+  cache.InvalidateIfChanged("app", root);
+  EXPECT_FALSE(cache.Get(resource, &cached_file));
+
+  cache.Set(resource, file);
+  cache.InvalidateIfChanged("app", root);
+  EXPECT_TRUE(cache.Get(resource, &cached_file));
+
+  // The root is gone, like after an uninstall.
+  ASSERT_TRUE(temp_dir.Delete());
+  cache.InvalidateIfChanged("app", root);
+  EXPECT_FALSE(cache.Get(resource, &cached_file));
+}
+
+}  // namespace application
+}  // namespace xwalk
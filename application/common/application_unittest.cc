@@ -3,7 +3,9 @@
 // found in the LICENSE file.
 
 #include "base/file_util.h"
+#include "base/i18n/rtl.h"
 #include "base/path_service.h"
+#include "base/values.h"
 #include "xwalk/application/common/application.h"
 #include "xwalk/application/common/application_file_util.h"
 #include "xwalk/application/common/application_manifest_constants.h"
@@ -34,5 +36,26 @@ TEST(ApplicationTest, IsIDValid) {
   EXPECT_FALSE(Application::IsIDValid("abcdefghijklmnopabcdefghijklmno0"));
 }
 
+TEST(ApplicationTest, GetLocalizedName) {
+  base::DictionaryValue manifest;
+  manifest.SetString(application_manifest_keys::kNameKey, "name");
+  manifest.SetString(application_manifest_keys::kVersionKey, "1.0");
+
+  // The name is only changed in right-to-left locales.
+  const std::string original_locale = base::i18n::GetConfiguredLocale();
+  base::i18n::SetICUDefaultLocale("he");
+  std::string error;
+  scoped_refptr<Application> application = Application::Create(
+      base::FilePath(), Manifest::COMMAND_LINE, manifest, GenerateId("name"),
+      &error);
+  std::string localized_name = Application::GetLocalizedName("name");
+  base::i18n::SetICUDefaultLocale(original_locale);
+
+  ASSERT_TRUE(application.get()) << error;
+  EXPECT_NE("name", localized_name);
+  EXPECT_EQ(application->Name(), localized_name);
+  EXPECT_EQ("name", application->NonLocalizedName());
+}
+
 }  // namespace application
 }  // namespace xwalk
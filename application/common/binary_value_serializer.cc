@@ -0,0 +1,230 @@
+// Copyright (c) 2013 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "xwalk/application/common/binary_value_serializer.h"
+
+#include <string.h>
+
+#include "base/logging.h"
+#include "base/memory/scoped_ptr.h"
+#include "base/pickle.h"
+
+namespace xwalk {
+namespace application {
+
+namespace {
+
+// Written before the value, so the format can evolve.
+const int kFormatVersion = 1;
+
+// Guards against stack overflows when reading corrupted data.
+const int kMaxDepth = 100;
+
+bool WriteValue(const base::Value& value, int depth, Pickle* pickle) {
+  if (depth > kMaxDepth)
+    return false;
+
+  pickle->WriteInt(value.GetType());
+  switch (value.GetType()) {
+    case base::Value::TYPE_NULL:
+      return true;
+    case base::Value::TYPE_BOOLEAN: {
+      bool v;
+      value.GetAsBoolean(&v);
+      return pickle->WriteBool(v);
+    }
+    case base::Value::TYPE_INTEGER: {
+      int v;
+      value.GetAsInteger(&v);
+      return pickle->WriteInt(v);
+    }
+    case base::Value::TYPE_DOUBLE: {
+      double v;
+      value.GetAsDouble(&v);
+      return pickle->WriteBytes(&v, sizeof(v));
+    }
+    case base::Value::TYPE_STRING: {
+      std::string v;
+      value.GetAsString(&v);
+      return pickle->WriteString(v);
+    }
+    case base::Value::TYPE_BINARY: {
+      const base::BinaryValue& binary =
+          static_cast<const base::BinaryValue&>(value);
+      return pickle->WriteData(binary.GetBuffer(),
+                               static_cast<int>(binary.GetSize()));
+    }
+    case base::Value::TYPE_DICTIONARY: {
+      const base::DictionaryValue& dict =
+          static_cast<const base::DictionaryValue&>(value);
+      if (!pickle->WriteInt(static_cast<int>(dict.size())))
+        return false;
+      for (base::DictionaryValue::Iterator it(dict); !it.IsAtEnd();
+           it.Advance()) {
+        if (!pickle->WriteString(it.key()) ||
+            !WriteValue(it.value(), depth + 1, pickle))
+          return false;
+      }
+      return true;
+    }
+    case base::Value::TYPE_LIST: {
+      const base::ListValue& list = static_cast<const base::ListValue&>(value);
+      if (!pickle->WriteInt(static_cast<int>(list.GetSize())))
+        return false;
+      for (base::ListValue::const_iterator it = list.begin();
+           it != list.end(); ++it) {
+        if (!WriteValue(**it, depth + 1, pickle))
+          return false;
+      }
+      return true;
+    }
+  }
+  NOTREACHED();
+  return false;
+}
+
+base::Value* ReadValue(PickleIterator* iter, int depth) {
+  int type;
+  if (depth > kMaxDepth || !iter->ReadInt(&type))
+    return NULL;
+
+  switch (type) {
+    case base::Value::TYPE_NULL:
+      return base::Value::CreateNullValue();
+    case base::Value::TYPE_BOOLEAN: {
+      bool v;
+      if (!iter->ReadBool(&v))
+        return NULL;
+      return new base::FundamentalValue(v);
+    }
+    case base::Value::TYPE_INTEGER: {
+      int v;
+      if (!iter->ReadInt(&v))
+        return NULL;
+      return new base::FundamentalValue(v);
+    }
+    case base::Value::TYPE_DOUBLE: {
+      const char* bytes;
+      double v;
+      if (!iter->ReadBytes(&bytes, sizeof(v)))
+        return NULL;
+      memcpy(&v, bytes, sizeof(v));
+      return new base::FundamentalValue(v);
+    }
+    case base::Value::TYPE_STRING: {
+      std::string v;
+      if (!iter->ReadString(&v))
+        return NULL;
+      return new base::StringValue(v);
+    }
+    case base::Value::TYPE_BINARY: {
+      const char* data;
+      int length;
+      if (!iter->ReadData(&data, &length))
+        return NULL;
+      return base::BinaryValue::CreateWithCopiedBuffer(data, length);
+    }
+    case base::Value::TYPE_DICTIONARY: {
+      int size;
+      if (!iter->ReadInt(&size) || size < 0)
+        return NULL;
+      scoped_ptr<base::DictionaryValue> dict(new base::DictionaryValue);
+      for (int i = 0; i < size; ++i) {
+        std::string key;
+        if (!iter->ReadString(&key))
+          return NULL;
+        base::Value* child = ReadValue(iter, depth + 1);
+        if (!child)
+          return NULL;
+        dict->SetWithoutPathExpansion(key, child);
+      }
+      return dict.release();
+    }
+    case base::Value::TYPE_LIST: {
+      int size;
+      if (!iter->ReadInt(&size) || size < 0)
+        return NULL;
+      scoped_ptr<base::ListValue> list(new base::ListValue);
+      for (int i = 0; i < size; ++i) {
+        base::Value* child = ReadValue(iter, depth + 1);
+        if (!child)
+          return NULL;
+        list->Append(child);
+      }
+      return list.release();
+    }
+  }
+  return NULL;
+}
+
+}  // namespace
+
+BinaryValueSerializer::BinaryValueSerializer(std::string* data)
+    : data_(data),
+      input_(data) {
+}
+
+BinaryValueSerializer::BinaryValueSerializer(const std::string& data)
+    : data_(NULL),
+      input_(&data) {
+}
+
+BinaryValueSerializer::~BinaryValueSerializer() {
+}
+
+bool BinaryValueSerializer::Serialize(const base::Value& root) {
+  if (!data_) {
+    NOTREACHED() << "The serializer only reads its data.";
+    return false;
+  }
+
+  Pickle pickle;
+  pickle.WriteInt(kFormatVersion);
+  if (!WriteValue(root, 0, &pickle))
+    return false;
+
+  data_->assign(static_cast<const char*>(pickle.data()), pickle.size());
+  return true;
+}
+
+base::Value* BinaryValueSerializer::Deserialize(int* error_code,
+                                                std::string* error_str) {
+  // Pickle rejects data whose header doesn't match its size, leaving it
+  // without any data.
+  Pickle pickle(input_->data(), static_cast<int>(input_->size()));
+  PickleIterator iter(pickle);
+
+  int version;
+  if (!pickle.data() || !iter.ReadInt(&version)) {
+    if (error_code)
+      *error_code = BINARY_BAD_FORMAT;
+    if (error_str)
+      *error_str = "Invalid binary value header.";
+    return NULL;
+  }
+
+  if (version != kFormatVersion) {
+    if (error_code)
+      *error_code = BINARY_UNSUPPORTED_VERSION;
+    if (error_str)
+      *error_str = "Unsupported binary value version.";
+    return NULL;
+  }
+
+  base::Value* value = ReadValue(&iter, 0);
+  if (!value) {
+    if (error_code)
+      *error_code = BINARY_BAD_FORMAT;
+    if (error_str)
+      *error_str = "Invalid binary value.";
+    return NULL;
+  }
+
+  if (error_code)
+    *error_code = BINARY_NO_ERROR;
+  return value;
+}
+
+}  // namespace application
+}  // namespace xwalk
@@ -0,0 +1,52 @@
+// Copyright (c) 2013 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef XWALK_APPLICATION_COMMON_BINARY_VALUE_SERIALIZER_H_
+#define XWALK_APPLICATION_COMMON_BINARY_VALUE_SERIALIZER_H_
+
+#include <string>
+
+#include "base/basictypes.h"
+#include "base/compiler_specific.h"
+#include "base/values.h"
+
+namespace xwalk {
+namespace application {
+
+// Serializes base::Value trees in a compact binary format based on Pickle.
+// Unlike JSON, reading it back requires no tokenizing and no number or
+// string unescaping, so it is used to store the manifests in DBStore.
+class BinaryValueSerializer : public base::ValueSerializer {
+ public:
+  enum ErrorCode {
+    BINARY_NO_ERROR = 0,
+    BINARY_BAD_FORMAT,
+    BINARY_UNSUPPORTED_VERSION,
+  };
+
+  // |data| is written by Serialize() and read by Deserialize(). The caller
+  // retains ownership of it.
+  explicit BinaryValueSerializer(std::string* data);
+  // Only reads |data|, which must outlive the serializer, without copying
+  // it. Serialize() fails.
+  explicit BinaryValueSerializer(const std::string& data);
+  virtual ~BinaryValueSerializer();
+
+  // base::ValueSerializer implementation.
+  virtual bool Serialize(const base::Value& root) OVERRIDE;
+  virtual base::Value* Deserialize(int* error_code,
+                                   std::string* error_str) OVERRIDE;
+
+ private:
+  // NULL if the serializer only reads |input_|.
+  std::string* data_;
+  const std::string* input_;
+
+  DISALLOW_COPY_AND_ASSIGN(BinaryValueSerializer);
+};
+
+}  // namespace application
+}  // namespace xwalk
+
+#endif  // XWALK_APPLICATION_COMMON_BINARY_VALUE_SERIALIZER_H_
@@ -0,0 +1,71 @@
+// Copyright (c) 2013 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "xwalk/application/common/binary_value_serializer.h"
+
+#include "base/memory/scoped_ptr.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace xwalk {
+namespace application {
+
+TEST(BinaryValueSerializerTest, RoundTrip) {
+  base::DictionaryValue original;
+  original.SetString("name", "test");
+  original.SetString("app.main.source", "main.html");
+  original.SetInteger("int", 42);
+  original.SetDouble("double", 3.25);
+  original.SetBoolean("bool", true);
+  original.Set("null", base::Value::CreateNullValue());
+  original.SetWithoutPathExpansion("dotted.key",
+                                   new base::StringValue("value"));
+  const char binary_data[] = { 0, 1, 2, 3 };
+  original.Set("binary", base::BinaryValue::CreateWithCopiedBuffer(
+      binary_data, sizeof(binary_data)));
+  base::ListValue* list = new base::ListValue;
+  list->AppendString("contacts");
+  list->AppendInteger(1);
+  list->Append(new base::DictionaryValue);
+  original.Set("list", list);
+
+  std::string data;
+  BinaryValueSerializer serializer(&data);
+  ASSERT_TRUE(serializer.Serialize(original));
+
+  int error_code;
+  std::string error;
+  scoped_ptr<base::Value> value(serializer.Deserialize(&error_code, &error));
+  ASSERT_TRUE(value);
+  EXPECT_EQ(BinaryValueSerializer::BINARY_NO_ERROR, error_code);
+  EXPECT_TRUE(original.Equals(value.get()));
+
+  // The data can be read without being writable.
+  const std::string& const_data = data;
+  BinaryValueSerializer reader(const_data);
+  value.reset(reader.Deserialize(&error_code, &error));
+  ASSERT_TRUE(value);
+  EXPECT_TRUE(original.Equals(value.get()));
+}
+
+TEST(BinaryValueSerializerTest, InvalidData) {
+  base::DictionaryValue original;
+  original.SetString("name", "test");
+  std::string data;
+  BinaryValueSerializer serializer(&data);
+  ASSERT_TRUE(serializer.Serialize(original));
+
+  // Truncated data.
+  data.resize(data.size() - 2);
+  int error_code;
+  std::string error;
+  EXPECT_EQ(NULL, serializer.Deserialize(&error_code, &error));
+  EXPECT_EQ(BinaryValueSerializer::BINARY_BAD_FORMAT, error_code);
+
+  // JSON, as stored in older DBs.
+  data = "{\"name\": \"test\"}";
+  EXPECT_EQ(NULL, serializer.Deserialize(&error_code, &error));
+}
+
+}  // namespace application
+}  // namespace xwalk
@@ -15,6 +15,11 @@ const base::FilePath::CharType kMessagesFilename[] =
     FILE_PATH_LITERAL("messages.json");
 const char kGeneratedMainDocumentFilename[] =
     "_generated_main_document.html";
+const base::FilePath::CharType kApplicationFileExtension[] =
+    FILE_PATH_LITERAL(".xpk");
+const base::FilePath::CharType kCompressedResourceExtension[] =
+    FILE_PATH_LITERAL(".gz");
+const int64 kMaxMemoryCachedResourceSize = 64 * 1024;
 
 }  // namespace application
 }  // namespace xwalk
@@ -5,6 +5,7 @@
 #ifndef XWALK_APPLICATION_COMMON_CONSTANTS_H_
 #define XWALK_APPLICATION_COMMON_CONSTANTS_H_
 
+#include "base/basictypes.h"
 #include "base/files/file_path.h"
 
 namespace xwalk {
@@ -22,6 +23,17 @@ extern const base::FilePath::CharType kMessagesFilename[];
 // The filename to use for main document generated from app.main.scripts.
 extern const char kGeneratedMainDocumentFilename[];
 
+// The extension of application packages.
+extern const base::FilePath::CharType kApplicationFileExtension[];
+
+// The extension added to the name of a resource file for its gzip compressed
+// copy.
+extern const base::FilePath::CharType kCompressedResourceExtension[];
+
+// The resource files up to this size are kept in memory while an application
+// runs, their compressed copies aren't used.
+extern const int64 kMaxMemoryCachedResourceSize;
+
 }  // namespace application
 }  // namespace xwalk
 
@@ -4,14 +4,71 @@
 
 #include "xwalk/application/common/db_store.h"
 
+#include "base/logging.h"
+#include "xwalk/application/browser/application_store.h"
+
 namespace xwalk {
 namespace application {
 
+ApplicationQuery::ApplicationQuery()
+    : sort_key(SORT_BY_ID),
+      descending(false),
+      offset(0),
+      limit(-1) {
+}
+
+ApplicationQuery::~ApplicationQuery() {
+}
+
+ApplicationSummary::ApplicationSummary() {
+}
+
+ApplicationSummary::~ApplicationSummary() {
+}
+
 DBStore::DBStore(base::FilePath path) : data_path_(path) {
 }
 
 DBStore::~DBStore() {
 }
 
+const base::DictionaryValue* DBStore::GetApplications() {
+  while (!raw_manifests_.empty())
+    ParseManifest(raw_manifests_.begin()->first);
+  return db_.get();
+}
+
+const base::DictionaryValue* DBStore::GetApplicationValue(
+    const std::string& id) {
+  if (!HasApplication(id))
+    return NULL;
+
+  ParseManifest(id);
+  const base::DictionaryValue* value = NULL;
+  db_->GetDictionaryWithoutPathExpansion(id, &value);
+  return value;
+}
+
+bool DBStore::HasApplication(const std::string& id) const {
+  return db_ && db_->HasKey(id);
+}
+
+void DBStore::ParseManifest(const std::string& id) {
+  std::map<std::string, std::string>::iterator it = raw_manifests_.find(id);
+  if (it == raw_manifests_.end())
+    return;
+
+  base::Value* manifest = DeserializeManifest(it->second);
+  raw_manifests_.erase(it);
+
+  base::DictionaryValue* value;
+  if (!manifest || !db_->GetDictionaryWithoutPathExpansion(id, &value)) {
+    LOG(ERROR) << "Unable to load the manifest of application " << id;
+    delete manifest;
+    return;
+  }
+  value->Set(ApplicationStore::kManifestPath, manifest);
+}
+
 }  // namespace application
 }  // namespace xwalk
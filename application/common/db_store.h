@@ -5,16 +5,61 @@
 #ifndef XWALK_APPLICATION_COMMON_DB_STORE_H_
 #define XWALK_APPLICATION_COMMON_DB_STORE_H_
 
+#include <map>
 #include <string>
+#include <vector>
 
 #include "base/memory/scoped_ptr.h"
 #include "base/observer_list.h"
 #include "base/time/time.h"
 #include "xwalk/application/common/application.h"
+#include "xwalk/application/common/launch_descriptor.h"
 
 namespace xwalk {
 namespace application {
 
+// Selects installed applications by the properties indexed in the database,
+// see DBStore::QueryApplications(). Empty or null fields don't filter.
+struct ApplicationQuery {
+  enum SortKey {
+    SORT_BY_ID = 0,
+    SORT_BY_NAME,
+    SORT_BY_VERSION,
+    SORT_BY_INSTALL_TIME,
+  };
+
+  ApplicationQuery();
+  ~ApplicationQuery();
+
+  // Matched against the name in the manifest, see
+  // Application::NonLocalizedName().
+  std::string name;
+  std::string version;
+  // Only the applications requesting this permission in their manifest.
+  std::string permission;
+  base::Time installed_after;
+  base::Time installed_before;
+
+  SortKey sort_key;
+  bool descending;
+  // Used for paging, a negative limit means all the remaining applications.
+  int offset;
+  int limit;
+};
+
+// The indexed properties of an installed application, available without
+// parsing its manifest.
+struct ApplicationSummary {
+  ApplicationSummary();
+  ~ApplicationSummary();
+
+  std::string id;
+  // The same as Application::Name(), localized from the indexed name.
+  std::string name;
+  std::string version;
+  base::Time install_time;
+};
+
 class DBStore {
  public:
   // Observer interface for monitoring DBStore.
@@ -34,7 +79,32 @@ class DBStore {
   virtual bool Insert(const Application* application,
                       const base::Time install_time) = 0;
   virtual bool Remove(const std::string& key) = 0;
-  const base::DictionaryValue* GetApplications() const { return db_.get(); }
+
+  // Returns the values of all applications, parsing the manifests not parsed
+  // yet. Prefer GetApplicationValue() when only some applications are needed.
+  const base::DictionaryValue* GetApplications();
+
+  // Returns the value of the application |id|, parsing its manifest if it was
+  // not parsed yet, or NULL if there's no such application.
+  const base::DictionaryValue* GetApplicationValue(const std::string& id);
+
+  bool HasApplication(const std::string& id) const;
+
+  // Fills |results| with the applications selected by |query|, in the order
+  // it requests. Returns false on error.
+  virtual bool QueryApplications(
+      const ApplicationQuery& query,
+      std::vector<ApplicationSummary>* results) = 0;
+
+  // Reads the application |id| without loading the others, so it can be got
+  // by GetApplicationValue() before InitDB(). Returns false if there's no
+  // such application.
+  virtual bool PreloadApplication(const std::string& id) = 0;
+
+  // Reads the launch descriptor stored for the application |id|, which
+  // doesn't need InitDB(). Returns false if there's no valid descriptor.
+  virtual bool GetLaunchDescriptor(const std::string& id,
+                                   LaunchDescriptor* descriptor) = 0;
 
   void AddObserver(DBStore::Observer* observer) {
     observers_.AddObserver(observer);
@@ -51,8 +121,28 @@ class DBStore {
   // each observer.
   virtual void SetValue(const std::string& key, base::Value* value) = 0;
 
+  // The changes made between BeginBatch() and EndBatch() are written to the
+  // database together, saving a sync per change. Batches can be nested, the
+  // changes are written when the outermost batch ends, and only then are the
+  // observers notified. EndBatch() returns false if the changes could not be
+  // written, in which case none of them is kept. A store must not be
+  // destroyed in the middle of a batch.
+  virtual void BeginBatch() = 0;
+  virtual bool EndBatch() = 0;
+
  protected:
+  // Returns the manifest serialized in |raw_manifest|, or NULL on error.
+  virtual base::Value* DeserializeManifest(
+      const std::string& raw_manifest) = 0;
+
+  // Moves the manifest of |id| from |raw_manifests_| to |db_|.
+  void ParseManifest(const std::string& id);
+
   scoped_ptr<base::DictionaryValue> db_;
+  // Manifests read from the database but not parsed yet, by application id.
+  // Parsing every manifest when the database is loaded would slow down the
+  // startup proportionally to the number of installed applications.
+  std::map<std::string, std::string> raw_manifests_;
   base::FilePath data_path_;
   ObserverList<DBStore::Observer, true> observers_;
 };
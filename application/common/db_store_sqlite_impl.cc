@@ -4,12 +4,21 @@
 
 #include "xwalk/application/common/db_store_sqlite_impl.h"
 
+#include <algorithm>
+#include <map>
+#include <vector>
+
 #include "base/file_util.h"
 #include "base/json/json_file_value_serializer.h"
-#include "base/json/json_string_value_serializer.h"
+#include "base/json/json_reader.h"
 #include "sql/statement.h"
 #include "sql/transaction.h"
 #include "xwalk/application/browser/application_store.h"
+#include "xwalk/application/common/application_manifest_constants.h"
+#include "xwalk/application/common/binary_value_serializer.h"
+#include "xwalk/application/common/launch_descriptor.h"
+
+namespace keys = xwalk::application_manifest_keys;
 
 namespace xwalk {
 namespace application {
@@ -19,7 +28,13 @@ const base::FilePath::CharType DBStoreSqliteImpl::kDBFileName[] =
 
 // Switching the JSON format DB(version 0) to SQLite backend version 1,
 // should migrate all data from JSON DB to SQLite applications table.
-static const int kVersionNumber = 1;
+// Version 2 stores the manifests with BinaryValueSerializer instead of JSON,
+// older versions can't read them.
+// Version 3 adds the indexed name, version and permissions of applications,
+// which older versions would not keep up to date.
+// Version 4 adds the launch descriptor of applications.
+static const int kVersionNumber = 4;
+static const int kCompatibleVersionNumber = 4;
 
 namespace {
 
@@ -39,26 +54,97 @@ inline const std::string GetInstallTimePath(const std::string& application_id) {
   return application_id + "." + ApplicationStore::kInstallTime;
 }
 
+// Encodes |manifest| in the format stored in the manifest column.
+bool SerializeManifest(const base::Value& manifest, std::string* data) {
+  BinaryValueSerializer serializer(data);
+  return serializer.Serialize(manifest);
+}
+
+// Gets the properties of |manifest| copied to their own columns, so
+// applications can be queried without deserializing their manifests.
+void GetIndexedProperties(const base::Value& manifest,
+                          std::string* name,
+                          std::string* version,
+                          std::vector<std::string>* permissions) {
+  const base::DictionaryValue* dict;
+  if (!manifest.GetAsDictionary(&dict))
+    return;
+
+  dict->GetString(keys::kNameKey, name);
+  dict->GetString(keys::kVersionKey, version);
+  const base::ListValue* list;
+  if (dict->GetList(keys::kPermissionsKey, &list)) {
+    for (size_t i = 0; i < list->GetSize(); ++i) {
+      std::string permission;
+      if (list->GetString(i, &permission))
+        permissions->push_back(permission);
+    }
+  }
+}
+
+const char* GetSortColumn(ApplicationQuery::SortKey sort_key) {
+  switch (sort_key) {
+    case ApplicationQuery::SORT_BY_NAME:
+      return "name";
+    case ApplicationQuery::SORT_BY_VERSION:
+      return "version";
+    case ApplicationQuery::SORT_BY_INSTALL_TIME:
+      return "install_time";
+    case ApplicationQuery::SORT_BY_ID:
+    default:
+      return "id";
+  }
+}
+
 // Initializes the applications table, returning true on success.
 bool InitApplicationsTable(sql::Connection* db) {
   // The table is named "applications", the primary key is "id".
   if (!db->DoesTableExist("applications")) {
     if (!db->Execute("CREATE TABLE applications ("
                      "id TEXT NOT NULL UNIQUE PRIMARY KEY,"
-                     "manifest TEXT NOT NULL,"
+                     "manifest BLOB NOT NULL,"
                      "path TEXT NOT NULL,"
-                     "install_time REAL)"))
+                     "install_time REAL,"
+                     "name TEXT,"
+                     "version TEXT,"
+                     "entry_url TEXT,"
+                     "main_document_type INTEGER,"
+                     "window_mode INTEGER)"))
+      return false;
+  }
+
+  // The permissions requested by each application, one per row.
+  if (!db->DoesTableExist("permissions")) {
+    if (!db->Execute("CREATE TABLE permissions ("
+                     "id TEXT NOT NULL,"
+                     "permission TEXT NOT NULL,"
+                     "PRIMARY KEY (id, permission))"))
       return false;
   }
 
   return true;
 }
 
+// Creates the indexes used by DBStoreSqliteImpl::QueryApplications(). Must
+// be called once the applications table is in the current version.
+bool InitIndexes(sql::Connection* db) {
+  return db->Execute("CREATE INDEX IF NOT EXISTS applications_name_index "
+                     "ON applications (name)") &&
+         db->Execute("CREATE INDEX IF NOT EXISTS applications_version_index "
+                     "ON applications (version)") &&
+         db->Execute("CREATE INDEX IF NOT EXISTS "
+                     "applications_install_time_index "
+                     "ON applications (install_time)") &&
+         db->Execute("CREATE INDEX IF NOT EXISTS permissions_permission_index "
+                     "ON permissions (permission)");
+}
+
 }  // namespace
 
 DBStoreSqliteImpl::DBStoreSqliteImpl(const base::FilePath& path)
     : DBStore(path),
-      db_initialized_(false) {
+      db_initialized_(false),
+      batch_nesting_(0) {
   // Ensure the parent directory for database file is created before reading
   // from it.
   if (!base::PathExists(path) && !file_util::CreateDirectory(path))
@@ -72,42 +158,96 @@ DBStoreSqliteImpl::DBStoreSqliteImpl(const base::FilePath& path)
     return;
   }
 
-  sql::Transaction transaction(sqlite_db_.get());
-  transaction.Begin();
+  // With write-ahead logging a commit appends to the log instead of
+  // rewriting the database pages, and only checkpoints need a full sync.
+  if (!sqlite_db_->Execute("PRAGMA journal_mode=WAL") ||
+      !sqlite_db_->Execute("PRAGMA synchronous=NORMAL"))
+    LOG(WARNING) << "Unable to enable write-ahead logging for applications DB.";
 
-  if (!meta_table_.Init(sqlite_db_.get(), kVersionNumber, kVersionNumber) ||
-      meta_table_.GetVersionNumber() != kVersionNumber) {
-    LOG(ERROR) << "Unable to init the META table.";
+  // A failed migration is rolled back with the rest, and the DB isn't used
+  // rather than used in a version this code doesn't handle.
+  base::FilePath v0_file = path.Append(FILE_PATH_LITERAL("applications_db"));
+  bool migrate_v0 = base::PathExists(v0_file) && !does_db_exist;
+  bool initialized = false;
+  {
+    sql::Transaction transaction(sqlite_db_.get());
+    initialized = transaction.Begin() &&
+        InitTables(migrate_v0 ? v0_file : base::FilePath()) &&
+        transaction.Commit();
+  }
+  if (!initialized) {
+    LOG(ERROR) << "An error occured when initializing the SQLite DB.";
+    meta_table_.Reset();
+    sqlite_db_.reset();
     return;
   }
 
+  // After migrated to SQLite, delete the old JSON DB file is safe,
+  // since all information has been migrated and it will not be used anymore.
+  if (migrate_v0 && !base::DeleteFile(v0_file, false))
+    LOG(ERROR) << "Unalbe to delete old JSON DB file.";
+
+  sqlite_db_->Preload();
+}
+
+bool DBStoreSqliteImpl::InitTables(const base::FilePath& v0_file) {
+  if (!meta_table_.Init(sqlite_db_.get(), kVersionNumber,
+                        kCompatibleVersionNumber)) {
+    LOG(ERROR) << "Unable to init the META table.";
+    return false;
+  }
+
+  if (meta_table_.GetCompatibleVersionNumber() > kVersionNumber) {
+    LOG(ERROR) << "Applications DB is too new.";
+    return false;
+  }
+
   if (!InitApplicationsTable(sqlite_db_.get())) {
     LOG(ERROR) << "Unable to open applications table.";
-    sqlite_db_.reset();
-    return;
+    return false;
   }
 
-  base::FilePath v0_file = path.Append(FILE_PATH_LITERAL("applications_db"));
-  if (base::PathExists(v0_file) &&
-      !does_db_exist) {
-    if (!UpgradeToVersion1(v0_file)) {
-      LOG(ERROR) << "Unable to migrate database from JSON format to SQLite.";
-      return;
-    }
-    // After migrated to SQLite, delete the old JSON DB file is safe,
-    // since all information has been migrated and it will not be used anymore.
-    if (!base::DeleteFile(v0_file, false)) {
-      LOG(ERROR) << "Unalbe to delete old JSON DB file.";
-      return;
+  if (!v0_file.empty() && !UpgradeToVersion1(v0_file)) {
+    LOG(ERROR) << "Unable to migrate database from JSON format to SQLite.";
+    return false;
+  }
+
+  if (meta_table_.GetVersionNumber() == 1 && !UpgradeToVersion2()) {
+    LOG(ERROR) << "Unable to migrate the manifests to the binary format.";
+    return false;
+  }
+
+  // The upgrades from version 2 only add columns derived from the manifests,
+  // which are then filled at once.
+  bool fill_manifest_columns = meta_table_.GetVersionNumber() == 2;
+  if (meta_table_.GetVersionNumber() == 2 && !UpgradeToVersion3()) {
+    LOG(ERROR) << "Unable to index the installed applications.";
+    return false;
+  }
+
+  if (meta_table_.GetVersionNumber() == 3) {
+    fill_manifest_columns = true;
+    if (!UpgradeToVersion4()) {
+      LOG(ERROR) << "Unable to add the launch descriptors.";
+      return false;
     }
   }
 
-  if (!transaction.Commit()) {
-    LOG(ERROR) << "An error occured when initializing the SQLite DB.";
-    return;
+  if (fill_manifest_columns && !FillManifestColumns()) {
+    LOG(ERROR) << "Unable to fill the columns derived from the manifests.";
+    return false;
   }
 
-  sqlite_db_->Preload();
+  if (meta_table_.GetVersionNumber() != kVersionNumber) {
+    LOG(ERROR) << "Unsupported applications DB version.";
+    return false;
+  }
+
+  if (!InitIndexes(sqlite_db_.get())) {
+    LOG(ERROR) << "Unable to create the applications DB indexes.";
+    return false;
+  }
+  return true;
 }
 
 bool DBStoreSqliteImpl::UpgradeToVersion1(const base::FilePath& v0_file) {
@@ -130,16 +270,146 @@ bool DBStoreSqliteImpl::UpgradeToVersion1(const base::FilePath& v0_file) {
     if (!SetApplication(it.key(), value.get()))
       return false;
   }
-  meta_table_.SetVersionNumber(1);
+  // SetApplication() already writes the manifests in the current format.
+  meta_table_.SetVersionNumber(kVersionNumber);
+
+  return true;
+}
+
+bool DBStoreSqliteImpl::UpgradeToVersion2() {
+  std::map<std::string, std::string> manifests;
+  {
+    sql::Statement smt(sqlite_db_->GetUniqueStatement(
+        "SELECT id, manifest FROM applications"));
+    if (!smt.is_valid())
+      return false;
+    while (smt.Step())
+      manifests[smt.ColumnString(0)] = smt.ColumnString(1);
+  }
+
+  sql::Statement smt(sqlite_db_->GetUniqueStatement(
+      "UPDATE applications SET manifest = ? WHERE id = ?"));
+  if (!smt.is_valid())
+    return false;
+
+  for (std::map<std::string, std::string>::const_iterator it =
+           manifests.begin(); it != manifests.end(); ++it) {
+    int error_code;
+    std::string error_msg;
+    scoped_ptr<base::Value> manifest(base::JSONReader::ReadAndReturnError(
+        it->second, base::JSON_PARSE_RFC, &error_code, &error_msg));
+    std::string data;
+    if (!manifest || !SerializeManifest(*manifest, &data)) {
+      LOG(ERROR) << "Unable to migrate the manifest of " << it->first
+                 << ": " << error_msg;
+      return false;
+    }
+
+    smt.Reset(true);
+    smt.BindBlob(0, data.data(), data.size());
+    smt.BindString(1, it->first);
+    if (!smt.Run())
+      return false;
+  }
+
+  meta_table_.SetVersionNumber(2);
+  meta_table_.SetCompatibleVersionNumber(2);
+  return true;
+}
+
+bool DBStoreSqliteImpl::UpgradeToVersion3() {
+  if (!sqlite_db_->Execute("ALTER TABLE applications ADD COLUMN name TEXT") ||
+      !sqlite_db_->Execute("ALTER TABLE applications ADD COLUMN version TEXT"))
+    return false;
+
+  meta_table_.SetVersionNumber(3);
+  meta_table_.SetCompatibleVersionNumber(3);
+  return true;
+}
+
+bool DBStoreSqliteImpl::UpgradeToVersion4() {
+  if (!sqlite_db_->Execute(
+          "ALTER TABLE applications ADD COLUMN entry_url TEXT") ||
+      !sqlite_db_->Execute(
+          "ALTER TABLE applications ADD COLUMN main_document_type INTEGER") ||
+      !sqlite_db_->Execute(
+          "ALTER TABLE applications ADD COLUMN window_mode INTEGER"))
+    return false;
+
+  meta_table_.SetVersionNumber(4);
+  meta_table_.SetCompatibleVersionNumber(4);
+  return true;
+}
+
+bool DBStoreSqliteImpl::FillManifestColumns() {
+  std::map<std::string, std::string> manifests;
+  {
+    sql::Statement smt(sqlite_db_->GetUniqueStatement(
+        "SELECT id, manifest FROM applications"));
+    if (!smt.is_valid())
+      return false;
+    while (smt.Step())
+      smt.ColumnBlobAsString(1, &manifests[smt.ColumnString(0)]);
+  }
 
+  for (std::map<std::string, std::string>::const_iterator it =
+           manifests.begin(); it != manifests.end(); ++it) {
+    scoped_ptr<base::Value> manifest(DeserializeManifest(it->second));
+    if (!manifest || !UpdateManifestColumns(it->first, *manifest))
+      return false;
+  }
   return true;
 }
 
 DBStoreSqliteImpl::~DBStoreSqliteImpl() {
+  DCHECK_EQ(0, batch_nesting_);
+  if (batch_transaction_) {
+    LOG(WARNING) << "Rolling back unfinished batch of DB changes.";
+    batch_transaction_->Rollback();
+    batch_transaction_.reset();
+  }
   if (sqlite_db_.get())
     sqlite_db_.reset();
 }
 
+void DBStoreSqliteImpl::BeginBatch() {
+  if (batch_nesting_++ > 0 || !sqlite_db_)
+    return;
+
+  batch_transaction_.reset(new sql::Transaction(sqlite_db_.get()));
+  if (!batch_transaction_->Begin()) {
+    LOG(ERROR) << "Unable to begin a batch of DB changes.";
+    batch_transaction_.reset();
+  }
+}
+
+bool DBStoreSqliteImpl::EndBatch() {
+  DCHECK_GT(batch_nesting_, 0);
+  if (batch_nesting_ == 0 || --batch_nesting_ > 0)
+    return true;
+
+  if (!batch_transaction_)
+    return false;
+
+  bool committed = batch_transaction_->Commit();
+  batch_transaction_.reset();
+  std::vector<std::string> changed_keys;
+  changed_keys.swap(batch_changed_keys_);
+  if (!committed) {
+    LOG(ERROR) << "Unable to commit a batch of DB changes.";
+    // The cache already has the changes which were rolled back.
+    db_initialized_ = UpdateDBCache();
+    return false;
+  }
+
+  for (size_t i = 0; i < changed_keys.size(); ++i) {
+    const base::Value* value = NULL;
+    db_->Get(changed_keys[i], &value);
+    ReportValueChanged(changed_keys[i], value);
+  }
+  return true;
+}
+
 bool DBStoreSqliteImpl::InitDB() {
   db_initialized_ = UpdateDBCache();
 
@@ -151,39 +421,93 @@ bool DBStoreSqliteImpl::InitDB() {
 
 bool DBStoreSqliteImpl::UpdateDBCache() {
   if (sqlite_db_.get() && sqlite_db_->is_open()) {
-    // Read all installed appliations information to db memory cache.
+    // Read all installed appliations information to db memory cache. The
+    // manifests are kept serialized until they are needed, see
+    // DBStore::GetApplicationValue().
     db_.reset(new base::DictionaryValue);
+    raw_manifests_.clear();
     sql::Statement smt(sqlite_db_->GetUniqueStatement(
         "SELECT id, manifest, path, install_time FROM applications"));
     if (smt.is_valid()) {
-      std::string error_msg;
-      while (smt.Step()) {
-        std::string application_id = smt.ColumnString(0);
-
-        int error_code;
-        std::string manifest_str = smt.ColumnString(1);
-        JSONStringValueSerializer serializer(&manifest_str);
-        base::Value* manifest = serializer.Deserialize(&error_code, &error_msg);
-        if (manifest == NULL) {
-          LOG(ERROR) << "An error occured when deserializing the manifest, "
-                        "the error message is: "
-                     << error_msg;
-          return false;
-        }
-        std::string path = smt.ColumnString(2);
-        double install_time = smt.ColumnDouble(3);
-        base::DictionaryValue* value = new base::DictionaryValue;
-        value->Set(ApplicationStore::kManifestPath, manifest);
-        value->SetString(ApplicationStore::kApplicationPath, path);
-        value->SetDouble(ApplicationStore::kInstallTime, install_time);
-        db_->Set(application_id, value);
-      }
+      while (smt.Step())
+        CacheApplication(&smt);
       return true;
     }
   }
   return false;
 }
 
+void DBStoreSqliteImpl::CacheApplication(sql::Statement* smt) {
+  std::string application_id = smt->ColumnString(0);
+  smt->ColumnBlobAsString(1, &raw_manifests_[application_id]);
+  std::string path = smt->ColumnString(2);
+  double install_time = smt->ColumnDouble(3);
+  base::DictionaryValue* value = new base::DictionaryValue;
+  value->SetString(ApplicationStore::kApplicationPath, path);
+  value->SetDouble(ApplicationStore::kInstallTime, install_time);
+  db_->SetWithoutPathExpansion(application_id, value);
+}
+
+bool DBStoreSqliteImpl::PreloadApplication(const std::string& id) {
+  if (db_initialized_)
+    return HasApplication(id);
+  if (!sqlite_db_ || !sqlite_db_->is_open())
+    return false;
+
+  if (!db_)
+    db_.reset(new base::DictionaryValue);
+  if (HasApplication(id))
+    return true;
+
+  sql::Statement smt(sqlite_db_->GetCachedStatement(SQL_FROM_HERE,
+      "SELECT id, manifest, path, install_time FROM applications "
+      "WHERE id = ?"));
+  smt.BindString(0, id);
+  if (!smt.Step())
+    return false;
+
+  CacheApplication(&smt);
+  return true;
+}
+
+bool DBStoreSqliteImpl::GetLaunchDescriptor(const std::string& id,
+                                            LaunchDescriptor* descriptor) {
+  if (!sqlite_db_ || !sqlite_db_->is_open())
+    return false;
+
+  sql::Statement smt(sqlite_db_->GetCachedStatement(SQL_FROM_HERE,
+      "SELECT entry_url, main_document_type, window_mode FROM applications "
+      "WHERE id = ?"));
+  smt.BindString(0, id);
+  if (!smt.Step())
+    return false;
+
+  GURL entry_url(smt.ColumnString(0));
+  if (!entry_url.is_valid())
+    return false;
+
+  descriptor->entry_url = entry_url;
+  descriptor->main_document_type =
+      static_cast<LaunchDescriptor::MainDocumentType>(smt.ColumnInt(1));
+  descriptor->window_mode =
+      static_cast<LaunchDescriptor::WindowMode>(smt.ColumnInt(2));
+  return true;
+}
+
+base::Value* DBStoreSqliteImpl::DeserializeManifest(
+    const std::string& raw_manifest) {
+  BinaryValueSerializer serializer(raw_manifest);
+  int error_code;
+  std::string error_msg;
+  base::Value* manifest = serializer.Deserialize(&error_code, &error_msg);
+  if (!manifest) {
+    LOG(ERROR) << "An error occured when deserializing the manifest, "
+                  "the error message is: "
+               << error_msg;
+  }
+  return manifest;
+}
+
 bool DBStoreSqliteImpl::Insert(const Application* application,
                                const base::Time install_time) {
   if (!db_initialized_)
@@ -212,6 +536,7 @@ bool DBStoreSqliteImpl::Remove(const std::string& key) {
     return false;
   }
 
+  raw_manifests_.erase(key);
   if (!db_->Remove(key, NULL)) {
     LOG(ERROR) << "Cannot remove the record " << key
                << " from database cache.";
@@ -229,6 +554,9 @@ void DBStoreSqliteImpl::SetValue(const std::string& key, base::Value* value) {
   size_t delimiter_position = current_path.find('.');
   std::string application_id(current_path, 0, delimiter_position);
 
+  // The old value is compared with the new one below, so it must be parsed.
+  ParseManifest(application_id);
+
   scoped_ptr<base::Value> new_value(value);
   base::Value* old_value = NULL;
   db_->Get(key, &old_value);
@@ -253,11 +581,10 @@ bool DBStoreSqliteImpl::SetApplication(
   }
 
   std::string manifest;
-  JSONStringValueSerializer serializer(&manifest);
   base::Value* manifest_value;
   if (!static_cast<base::DictionaryValue*>(value)->Get(
           ApplicationStore::kManifestPath, &manifest_value) ||
-      !serializer.Serialize(*manifest_value)) {
+      !SerializeManifest(*manifest_value, &manifest)) {
     LOG(ERROR) << "An error occured when serializing the manifest value.";
     return false;
   }
@@ -280,14 +607,14 @@ bool DBStoreSqliteImpl::SetApplication(
   if (!transaction.Begin())
     return false;
 
-  sql::Statement smt(sqlite_db_->GetUniqueStatement(
+  sql::Statement smt(sqlite_db_->GetCachedStatement(SQL_FROM_HERE,
       "INSERT INTO applications (manifest, path, install_time, id) "
       "VALUES (?,?,?,?)"));
   if (!smt.is_valid()) {
     LOG(ERROR) << "Unable to insert application info into DB.";
     return false;
   }
-  smt.BindString(0, manifest);
+  smt.BindBlob(0, manifest.data(), manifest.size());
   smt.BindString(1, path);
   smt.BindDouble(2, install_time);
   smt.BindString(3, id);
@@ -296,6 +623,9 @@ bool DBStoreSqliteImpl::SetApplication(
     return false;
   }
 
+  if (!UpdateManifestColumns(id, *manifest_value))
+    return false;
+
   return transaction.Commit();
 }
 
@@ -307,11 +637,10 @@ bool DBStoreSqliteImpl::UpdateApplication(
   }
 
   std::string manifest;
-  JSONStringValueSerializer serializer(&manifest);
   base::Value* manifest_value;
   if (!static_cast<base::DictionaryValue*>(value)->Get(
           ApplicationStore::kManifestPath, &manifest_value) ||
-      !serializer.Serialize(*manifest_value)) {
+      !SerializeManifest(*manifest_value, &manifest)) {
     LOG(ERROR) << "An error occured when serializing the manifest value.";
     return false;
   }
@@ -334,14 +663,14 @@ bool DBStoreSqliteImpl::UpdateApplication(
   if (!transaction.Begin())
     return false;
 
-  sql::Statement smt(sqlite_db_->GetUniqueStatement(
+  sql::Statement smt(sqlite_db_->GetCachedStatement(SQL_FROM_HERE,
       "UPDATE applications SET manifest = ?, path = ?, "
       "install_time = ? WHERE id = ?"));
   if (!smt.is_valid()) {
     LOG(ERROR) << "Unable to update application info in DB.";
     return false;
   }
-  smt.BindString(0, manifest);
+  smt.BindBlob(0, manifest.data(), manifest.size());
   smt.BindString(1, path);
   smt.BindDouble(2, install_time);
   smt.BindString(3, id);
@@ -350,6 +679,9 @@ bool DBStoreSqliteImpl::UpdateApplication(
     return false;
   }
 
+  if (!UpdateManifestColumns(id, *manifest_value))
+    return false;
+
   return transaction.Commit();
 }
 
@@ -358,7 +690,7 @@ bool DBStoreSqliteImpl::DeleteApplication(const std::string& id) {
   if (!transaction.Begin())
     return false;
 
-  sql::Statement smt(sqlite_db_->GetUniqueStatement(
+  sql::Statement smt(sqlite_db_->GetCachedStatement(SQL_FROM_HERE,
       "DELETE FROM applications WHERE id = ?"));
   smt.BindString(0, id);
   if (!smt.Run()) {
@@ -367,9 +699,128 @@ bool DBStoreSqliteImpl::DeleteApplication(const std::string& id) {
     return false;
   }
 
+  sql::Statement permissions_smt(sqlite_db_->GetCachedStatement(SQL_FROM_HERE,
+      "DELETE FROM permissions WHERE id = ?"));
+  permissions_smt.BindString(0, id);
+  if (!permissions_smt.Run()) {
+    LOG(ERROR) << "Could not delete application permissions from DB.";
+    return false;
+  }
+
   return transaction.Commit();
 }
 
+bool DBStoreSqliteImpl::UpdateManifestColumns(
+    const std::string& id, const base::Value& manifest) {
+  std::string name;
+  std::string version;
+  std::vector<std::string> permissions;
+  GetIndexedProperties(manifest, &name, &version, &permissions);
+
+  // Applications without entry point are stored, but can't be launched from
+  // their descriptor.
+  LaunchDescriptor descriptor;
+  const base::DictionaryValue* dict;
+  if (manifest.GetAsDictionary(&dict))
+    LaunchDescriptor::FromManifest(id, *dict, &descriptor);
+
+  sql::Statement smt(sqlite_db_->GetCachedStatement(SQL_FROM_HERE,
+      "UPDATE applications SET name = ?, version = ?, entry_url = ?, "
+      "main_document_type = ?, window_mode = ? WHERE id = ?"));
+  smt.BindString(0, name);
+  smt.BindString(1, version);
+  smt.BindString(2, descriptor.entry_url.spec());
+  smt.BindInt(3, descriptor.main_document_type);
+  smt.BindInt(4, descriptor.window_mode);
+  smt.BindString(5, id);
+  if (!smt.Run()) {
+    LOG(ERROR) << "Could not update application manifest columns in DB.";
+    return false;
+  }
+
+  sql::Statement delete_smt(sqlite_db_->GetCachedStatement(SQL_FROM_HERE,
+      "DELETE FROM permissions WHERE id = ?"));
+  delete_smt.BindString(0, id);
+  if (!delete_smt.Run()) {
+    LOG(ERROR) << "Could not delete application permissions from DB.";
+    return false;
+  }
+
+  sql::Statement insert_smt(sqlite_db_->GetCachedStatement(SQL_FROM_HERE,
+      "INSERT OR IGNORE INTO permissions (id, permission) VALUES (?,?)"));
+  for (size_t i = 0; i < permissions.size(); ++i) {
+    insert_smt.Reset(true);
+    insert_smt.BindString(0, id);
+    insert_smt.BindString(1, permissions[i]);
+    if (!insert_smt.Run()) {
+      LOG(ERROR) << "Could not insert application permissions into DB.";
+      return false;
+    }
+  }
+  return true;
+}
+
+bool DBStoreSqliteImpl::QueryApplications(
+    const ApplicationQuery& query,
+    std::vector<ApplicationSummary>* results) {
+  if (!db_initialized_)
+    return false;
+
+  // Only the conditions are built from the query, the values are bound.
+  std::string sql("SELECT id, name, version, install_time FROM applications");
+  std::vector<std::string> conditions;
+  if (!query.name.empty())
+    conditions.push_back("name = ?");
+  if (!query.version.empty())
+    conditions.push_back("version = ?");
+  if (!query.permission.empty())
+    conditions.push_back(
+        "id IN (SELECT id FROM permissions WHERE permission = ?)");
+  if (!query.installed_after.is_null())
+    conditions.push_back("install_time >= ?");
+  if (!query.installed_before.is_null())
+    conditions.push_back("install_time < ?");
+  for (size_t i = 0; i < conditions.size(); ++i)
+    sql += (i == 0 ? " WHERE " : " AND ") + conditions[i];
+
+  const char* order = query.descending ? " DESC" : " ASC";
+  sql += std::string(" ORDER BY ") + GetSortColumn(query.sort_key) + order;
+  // Sorting by id last makes the pages stable.
+  if (query.sort_key != ApplicationQuery::SORT_BY_ID)
+    sql += std::string(", id") + order;
+  sql += " LIMIT ? OFFSET ?";
+
+  sql::Statement smt(sqlite_db_->GetUniqueStatement(sql.c_str()));
+  if (!smt.is_valid()) {
+    LOG(ERROR) << "Unable to query the applications DB.";
+    return false;
+  }
+
+  int index = 0;
+  if (!query.name.empty())
+    smt.BindString(index++, query.name);
+  if (!query.version.empty())
+    smt.BindString(index++, query.version);
+  if (!query.permission.empty())
+    smt.BindString(index++, query.permission);
+  if (!query.installed_after.is_null())
+    smt.BindDouble(index++, query.installed_after.ToDoubleT());
+  if (!query.installed_before.is_null())
+    smt.BindDouble(index++, query.installed_before.ToDoubleT());
+  smt.BindInt(index++, query.limit);
+  smt.BindInt(index++, query.offset);
+
+  while (smt.Step()) {
+    ApplicationSummary summary;
+    summary.id = smt.ColumnString(0);
+    summary.name = Application::GetLocalizedName(smt.ColumnString(1));
+    summary.version = smt.ColumnString(2);
+    summary.install_time = base::Time::FromDoubleT(smt.ColumnDouble(3));
+    results->push_back(summary);
+  }
+  return smt.Succeeded();
+}
+
 bool DBStoreSqliteImpl::SetManifestValue(
     const std::string& id, base::Value* value) {
   if (!value) {
@@ -378,8 +829,7 @@ bool DBStoreSqliteImpl::SetManifestValue(
   }
 
   std::string manifest;
-  JSONStringValueSerializer serializer(&manifest);
-  if (!serializer.Serialize(*value)) {
+  if (!SerializeManifest(*value, &manifest)) {
     LOG(ERROR) << "An error occured when serializing the manifest value.";
     return false;
   }
@@ -388,13 +838,13 @@ bool DBStoreSqliteImpl::SetManifestValue(
   if (!transaction.Begin())
     return false;
 
-  sql::Statement smt(sqlite_db_->GetUniqueStatement(
+  sql::Statement smt(sqlite_db_->GetCachedStatement(SQL_FROM_HERE,
       "UPDATE applications SET manifest = ? WHERE id = ?"));
   if (!smt.is_valid()) {
     LOG(ERROR) << "Unable to update manifest in db.";
     return false;
   }
-  smt.BindString(0, manifest);
+  smt.BindBlob(0, manifest.data(), manifest.size());
   smt.BindString(1, id);
   if (!smt.Run()) {
     LOG(ERROR) << "Could not update application manifest "
@@ -402,6 +852,9 @@ bool DBStoreSqliteImpl::SetManifestValue(
     return false;
   }
 
+  if (!UpdateManifestColumns(id, *value))
+    return false;
+
   return transaction.Commit();
 }
 
@@ -423,7 +876,7 @@ bool DBStoreSqliteImpl::SetInstallTimeValue(
   if (!transaction.Begin())
     return false;
 
-  sql::Statement smt(sqlite_db_->GetUniqueStatement(
+  sql::Statement smt(sqlite_db_->GetCachedStatement(SQL_FROM_HERE,
       "UPDATE applications SET install_time = ? WHERE id = ?"));
   if (!smt.is_valid()) {
     LOG(ERROR) << "Unable to update install_time in db.";
@@ -457,7 +910,7 @@ bool DBStoreSqliteImpl::SetApplicationPathValue(
   if (!transaction.Begin())
     return false;
 
-  sql::Statement smt(sqlite_db_->GetUniqueStatement(
+  sql::Statement smt(sqlite_db_->GetCachedStatement(SQL_FROM_HERE,
       "UPDATE applications SET path = ? WHERE id = ?"));
   if (!smt.is_valid()) {
     LOG(ERROR) << "Unable to update path in db.";
@@ -509,6 +962,12 @@ bool DBStoreSqliteImpl::Commit(const std::string& id,
 
 void DBStoreSqliteImpl::ReportValueChanged(const std::string& key,
                                            const base::Value* value) {
+  if (batch_transaction_) {
+    if (std::find(batch_changed_keys_.begin(), batch_changed_keys_.end(),
+                  key) == batch_changed_keys_.end())
+      batch_changed_keys_.push_back(key);
+    return;
+  }
   FOR_EACH_OBSERVER(
       DBStore::Observer, observers_, OnDBValueChanged(key, value));
 }
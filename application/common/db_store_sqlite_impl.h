@@ -6,10 +6,13 @@
 #define XWALK_APPLICATION_COMMON_DB_STORE_SQLITE_IMPL_H_
 
 #include <string>
+#include <vector>
 
 #include "base/files/file_path.h"
 #include "sql/connection.h"
 #include "sql/meta_table.h"
+#include "sql/statement.h"
+#include "sql/transaction.h"
 #include "xwalk/application/common/db_store.h"
 
 namespace xwalk {
@@ -28,6 +31,18 @@ class DBStoreSqliteImpl: public DBStore {
   virtual bool Remove(const std::string& key) OVERRIDE;
   virtual bool InitDB() OVERRIDE;
   virtual void SetValue(const std::string& key, base::Value* value) OVERRIDE;
+  virtual void BeginBatch() OVERRIDE;
+  virtual bool EndBatch() OVERRIDE;
+  virtual bool QueryApplications(
+      const ApplicationQuery& query,
+      std::vector<ApplicationSummary>* results) OVERRIDE;
+  virtual bool PreloadApplication(const std::string& id) OVERRIDE;
+  virtual bool GetLaunchDescriptor(const std::string& id,
+                                   LaunchDescriptor* descriptor) OVERRIDE;
+
+ protected:
+  virtual base::Value* DeserializeManifest(
+      const std::string& raw_manifest) OVERRIDE;
 
  private:
   enum Action {
@@ -37,22 +52,47 @@ class DBStoreSqliteImpl: public DBStore {
     ACTION_DELETE
   };
   bool UpdateDBCache();
+  // Caches the application in the current row of |smt|, which selects the
+  // id, manifest, path and install_time columns.
+  void CacheApplication(sql::Statement* smt);
   bool Commit(const std::string& id,
               const std::string& column,
               base::Value* value,
               Action action);
+  // Notifies the observers, or defers it until the current batch of changes
+  // is written.
   void ReportValueChanged(const std::string& key,
                           const base::Value* value);
+  // Creates or upgrades the tables to the current version, migrating the
+  // JSON DB in |v0_file| unless it's empty. Called in a transaction.
+  bool InitTables(const base::FilePath& v0_file);
   bool UpgradeToVersion1(const base::FilePath& v0_file);
+  bool UpgradeToVersion2();
+  bool UpgradeToVersion3();
+  bool UpgradeToVersion4();
+  // Fills the columns derived from the manifests of all the applications.
+  bool FillManifestColumns();
   bool SetApplication(const std::string& id, base::Value* value);
   bool UpdateApplication(const std::string& id, base::Value* value);
   bool DeleteApplication(const std::string& id);
   bool SetManifestValue(const std::string& id, base::Value* value);
   bool SetInstallTimeValue(const std::string& id, base::Value* value);
   bool SetApplicationPathValue(const std::string& id, base::Value* value);
+  // Updates the columns derived from |manifest|: the indexed properties and
+  // the launch descriptor.
+  bool UpdateManifestColumns(const std::string& id,
+                             const base::Value& manifest);
   scoped_ptr<sql::Connection> sqlite_db_;
   sql::MetaTable meta_table_;
   bool db_initialized_;
+
+  // The changes of a batch are done inside this transaction, so the
+  // transactions of each change are nested in it and only this one syncs.
+  scoped_ptr<sql::Transaction> batch_transaction_;
+  int batch_nesting_;
+  // The keys changed in the current batch, in order. Their observers are
+  // notified once the batch is written, and not at all if it fails.
+  std::vector<std::string> batch_changed_keys_;
 };
 
 }  // namespace application
@@ -0,0 +1,159 @@
+// Copyright (c) 2013 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "xwalk/application/common/db_store_sqlite_impl.h"
+
+#include <vector>
+
+#include "base/files/scoped_temp_dir.h"
+#include "base/strings/stringprintf.h"
+#include "base/time/time.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "xwalk/application/browser/application_store.h"
+#include "xwalk/test/base/xwalk_test_utils.h"
+
+using xwalk_test_utils::PrintPerfResult;
+
+namespace xwalk {
+namespace application {
+
+namespace {
+
+const int kInstalledApplicationCounts[] = { 10, 100, 500 };
+
+std::string GetApplicationID(int index) {
+  return base::StringPrintf("app%d", index);
+}
+
+// A manifest of a typical size, so parsing it costs like a real one.
+base::DictionaryValue* CreateManifest(int index) {
+  base::DictionaryValue* manifest = new base::DictionaryValue;
+  manifest->SetString("name", GetApplicationID(index));
+  manifest->SetString("version", "1.0.0");
+  manifest->SetString("description",
+                      "An application installed by the startup benchmark.");
+  manifest->SetString("app.main.source", "main.html");
+  manifest->SetString("app.launch.local_path", "index.html");
+  base::ListValue* permissions = new base::ListValue;
+  permissions->AppendString("contacts");
+  permissions->AppendString("geolocation");
+  permissions->AppendString("messaging");
+  manifest->Set("permissions", permissions);
+  return manifest;
+}
+
+}  // namespace
+
+class DBStoreSqliteImplPerfTest : public testing::Test {
+ protected:
+  void InstallApplications(int count) {
+    ASSERT_TRUE(temp_dir_.CreateUniqueTempDir());
+    DBStoreSqliteImpl db_store(temp_dir_.path());
+    ASSERT_TRUE(db_store.InitDB());
+    db_store.BeginBatch();
+    InsertApplications(&db_store, count);
+    ASSERT_TRUE(db_store.EndBatch());
+  }
+
+  void InsertApplications(DBStore* db_store, int count) {
+    for (int i = 0; i < count; ++i) {
+      base::DictionaryValue* value = new base::DictionaryValue;
+      value->SetString(ApplicationStore::kApplicationPath, "path");
+      value->Set(ApplicationStore::kManifestPath, CreateManifest(i));
+      value->SetDouble(ApplicationStore::kInstallTime, 0);
+      db_store->SetValue(GetApplicationID(i), value);
+    }
+  }
+
+  base::ScopedTempDir temp_dir_;
+};
+
+// Measures loading the store and getting one application, as when launching
+// an application, against getting all of them.
+TEST_F(DBStoreSqliteImplPerfTest, Startup) {
+  for (size_t i = 0; i < arraysize(kInstalledApplicationCounts); ++i) {
+    int count = kInstalledApplicationCounts[i];
+    InstallApplications(count);
+
+    base::TimeTicks start = base::TimeTicks::Now();
+    scoped_ptr<DBStoreSqliteImpl> db_store(
+        new DBStoreSqliteImpl(temp_dir_.path()));
+    ASSERT_TRUE(db_store->InitDB());
+    ASSERT_TRUE(db_store->GetApplicationValue(GetApplicationID(0)));
+    base::TimeDelta one_application = base::TimeTicks::Now() - start;
+
+    start = base::TimeTicks::Now();
+    db_store.reset(new DBStoreSqliteImpl(temp_dir_.path()));
+    ASSERT_TRUE(db_store->InitDB());
+    ASSERT_EQ(count, static_cast<int>(db_store->GetApplications()->size()));
+    base::TimeDelta all_applications = base::TimeTicks::Now() - start;
+
+    std::string trace = base::StringPrintf("%d_apps", count);
+    PrintPerfResult("db_store_startup_one_app", trace,
+                    one_application.InMillisecondsF(), "ms");
+    PrintPerfResult("db_store_startup_all_apps", trace,
+                    all_applications.InMillisecondsF(), "ms");
+
+    db_store.reset();
+    ASSERT_TRUE(temp_dir_.Delete());
+  }
+}
+
+// Measures listing the first page of applications by name, as a launcher
+// does, against getting all of them.
+TEST_F(DBStoreSqliteImplPerfTest, QueryFirstPage) {
+  const int kApplicationCount = 500;
+  InstallApplications(kApplicationCount);
+  DBStoreSqliteImpl db_store(temp_dir_.path());
+  ASSERT_TRUE(db_store.InitDB());
+
+  base::TimeTicks start = base::TimeTicks::Now();
+  ApplicationQuery query;
+  query.sort_key = ApplicationQuery::SORT_BY_NAME;
+  query.limit = 20;
+  std::vector<ApplicationSummary> results;
+  ASSERT_TRUE(db_store.QueryApplications(query, &results));
+  ASSERT_EQ(20u, results.size());
+  base::TimeDelta first_page = base::TimeTicks::Now() - start;
+
+  start = base::TimeTicks::Now();
+  ASSERT_EQ(kApplicationCount,
+            static_cast<int>(db_store.GetApplications()->size()));
+  base::TimeDelta all_applications = base::TimeTicks::Now() - start;
+
+  PrintPerfResult("db_store_query", "first_page",
+                  first_page.InMillisecondsF(), "ms");
+  PrintPerfResult("db_store_query", "all_apps",
+                  all_applications.InMillisecondsF(), "ms");
+}
+
+// Measures installing many applications, each change in its own transaction
+// against all of them in a single batch.
+TEST_F(DBStoreSqliteImplPerfTest, BulkInstall) {
+  const int kApplicationCount = 100;
+  for (int batched = 0; batched < 2; ++batched) {
+    ASSERT_TRUE(temp_dir_.CreateUniqueTempDir());
+    scoped_ptr<DBStoreSqliteImpl> db_store(
+        new DBStoreSqliteImpl(temp_dir_.path()));
+    ASSERT_TRUE(db_store->InitDB());
+
+    base::TimeTicks start = base::TimeTicks::Now();
+    if (batched)
+      db_store->BeginBatch();
+    InsertApplications(db_store.get(), kApplicationCount);
+    if (batched)
+      ASSERT_TRUE(db_store->EndBatch());
+    base::TimeDelta elapsed = base::TimeTicks::Now() - start;
+
+    PrintPerfResult("db_store_bulk_install",
+                    batched ? "batched" : "unbatched",
+                    kApplicationCount / elapsed.InSecondsF(), "apps/s");
+
+    db_store.reset();
+    ASSERT_TRUE(temp_dir_.Delete());
+  }
+}
+
+}  // namespace application
+}  // namespace xwalk
@@ -4,17 +4,50 @@
 
 #include "xwalk/application/common/db_store_sqlite_impl.h"
 
+#include <string>
+#include <vector>
+
 #include "base/file_util.h"
 #include "base/files/scoped_temp_dir.h"
 #include "base/json/json_file_value_serializer.h"
 #include "base/logging.h"
 #include "base/path_service.h"
+#include "base/strings/string_number_conversions.h"
+#include "sql/connection.h"
+#include "sql/meta_table.h"
+#include "sql/test/scoped_error_ignorer.h"
 #include "testing/gtest/include/gtest/gtest.h"
+#include "third_party/sqlite/sqlite3.h"
 #include "xwalk/application/browser/application_store.h"
 
 namespace xwalk {
 namespace application {
 
+namespace {
+
+class ChangedKeysObserver : public DBStore::Observer {
+ public:
+  virtual void OnDBValueChanged(const std::string& key,
+                                const base::Value* value) OVERRIDE {
+    keys.push_back(key);
+  }
+  virtual void OnInitializationCompleted(bool succeeded) OVERRIDE {}
+
+  std::vector<std::string> keys;
+};
+
+base::DictionaryValue* CreateApplicationValue() {
+  base::DictionaryValue* value = new base::DictionaryValue;
+  value->SetString(ApplicationStore::kApplicationPath, "path");
+  base::DictionaryValue* manifest = new base::DictionaryValue;
+  manifest->SetString("a", "b");
+  value->Set(ApplicationStore::kManifestPath, manifest);
+  value->SetDouble(ApplicationStore::kInstallTime, 0);
+  return value;
+}
+
+}  // namespace
+
 class DBStoreSqliteImplTest : public testing::Test {
  public:
   virtual ~DBStoreSqliteImplTest() {
@@ -104,6 +137,85 @@ TEST_F(DBStoreSqliteImplTest, DBUpgradeToV1) {
   EXPECT_TRUE(db_value->Equals(db_store_->GetApplications()));
 }
 
+TEST_F(DBStoreSqliteImplTest, DBUpgradeToV2) {
+  base::FilePath tmp;
+  ASSERT_TRUE(PathService::Get(base::DIR_TEMP, &tmp));
+  ASSERT_TRUE(temp_dir_.CreateUniqueTempDirUnderPath(tmp));
+
+  // Create a version 1 DB, which stores the manifests as JSON.
+  {
+    sql::Connection db;
+    ASSERT_TRUE(db.Open(
+        temp_dir_.path().Append(DBStoreSqliteImpl::kDBFileName)));
+    sql::MetaTable meta_table;
+    ASSERT_TRUE(meta_table.Init(&db, 1, 1));
+    ASSERT_TRUE(db.Execute("CREATE TABLE applications ("
+                           "id TEXT NOT NULL UNIQUE PRIMARY KEY,"
+                           "manifest TEXT NOT NULL,"
+                           "path TEXT NOT NULL,"
+                           "install_time REAL)"));
+    ASSERT_TRUE(db.Execute("INSERT INTO applications VALUES "
+                           "('test_id', '{\"a\": \"b\"}', 'path', 0)"));
+  }
+
+  db_store_.reset(new DBStoreSqliteImpl(temp_dir_.path()));
+  ASSERT_TRUE(db_store_->InitDB());
+  const base::DictionaryValue* value =
+      db_store_->GetApplicationValue("test_id");
+  ASSERT_TRUE(value);
+  std::string v;
+  ASSERT_TRUE(value->GetString(
+      std::string(ApplicationStore::kManifestPath) + ".a", &v));
+  EXPECT_EQ("b", v);
+  db_store_.reset();
+
+  // The DB is migrated through version 2 to the current version.
+  sql::Connection db;
+  ASSERT_TRUE(db.Open(
+      temp_dir_.path().Append(DBStoreSqliteImpl::kDBFileName)));
+  sql::MetaTable meta_table;
+  ASSERT_TRUE(meta_table.Init(&db, 4, 4));
+  EXPECT_EQ(4, meta_table.GetVersionNumber());
+  EXPECT_EQ(4, meta_table.GetCompatibleVersionNumber());
+}
+
+TEST_F(DBStoreSqliteImplTest, FailedUpgradeIsRolledBack) {
+  base::FilePath tmp;
+  ASSERT_TRUE(PathService::Get(base::DIR_TEMP, &tmp));
+  ASSERT_TRUE(temp_dir_.CreateUniqueTempDirUnderPath(tmp));
+
+  // A version 1 DB with a manifest which can't be migrated.
+  {
+    sql::Connection db;
+    ASSERT_TRUE(db.Open(
+        temp_dir_.path().Append(DBStoreSqliteImpl::kDBFileName)));
+    sql::MetaTable meta_table;
+    ASSERT_TRUE(meta_table.Init(&db, 1, 1));
+    ASSERT_TRUE(db.Execute("CREATE TABLE applications ("
+                           "id TEXT NOT NULL UNIQUE PRIMARY KEY,"
+                           "manifest TEXT NOT NULL,"
+                           "path TEXT NOT NULL,"
+                           "install_time REAL)"));
+    ASSERT_TRUE(db.Execute("INSERT INTO applications VALUES "
+                           "('test_id', '{\"a\": ', 'path', 0)"));
+  }
+
+  // The DB isn't used in a version the store doesn't handle.
+  db_store_.reset(new DBStoreSqliteImpl(temp_dir_.path()));
+  EXPECT_FALSE(db_store_->InitDB());
+  EXPECT_FALSE(db_store_->Insert(NULL, base::Time()));
+  db_store_.reset();
+
+  // The DB is left as it was.
+  sql::Connection db;
+  ASSERT_TRUE(db.Open(
+      temp_dir_.path().Append(DBStoreSqliteImpl::kDBFileName)));
+  sql::MetaTable meta_table;
+  ASSERT_TRUE(meta_table.Init(&db, 4, 4));
+  EXPECT_EQ(1, meta_table.GetVersionNumber());
+  EXPECT_FALSE(db.DoesColumnExist("applications", "name"));
+}
+
 TEST_F(DBStoreSqliteImplTest, DBUpdate1) {
   TestInit();
   scoped_ptr<base::DictionaryValue> value(new base::DictionaryValue);
@@ -200,5 +312,236 @@ TEST_F(DBStoreSqliteImplTest, DBUpdate4) {
   EXPECT_TRUE(changed_value->Equals(db_value));
 }
 
+TEST_F(DBStoreSqliteImplTest, DBBatch) {
+  TestInit();
+  db_store_->BeginBatch();
+  for (int i = 0; i < 3; ++i) {
+    // Nested batches are part of the outermost one.
+    db_store_->BeginBatch();
+    scoped_ptr<base::DictionaryValue> value(new base::DictionaryValue);
+    value->SetString(ApplicationStore::kApplicationPath, "path");
+    base::DictionaryValue* manifest = new base::DictionaryValue;
+    manifest->SetString("a", "b");
+    value->Set(ApplicationStore::kManifestPath, manifest);
+    value->SetDouble(ApplicationStore::kInstallTime, i);
+    db_store_->SetValue("test_id" + base::IntToString(i), value.release());
+    EXPECT_TRUE(db_store_->EndBatch());
+  }
+  EXPECT_TRUE(db_store_->EndBatch());
+
+  scoped_ptr<base::DictionaryValue> old_value(
+      db_store_->GetApplications()->DeepCopy());
+  db_store_.reset(new DBStoreSqliteImpl(temp_dir_.path()));
+  ASSERT_TRUE(db_store_->InitDB());
+  EXPECT_EQ(3u, db_store_->GetApplications()->size());
+  EXPECT_TRUE(old_value->Equals(db_store_->GetApplications()));
+}
+
+TEST_F(DBStoreSqliteImplTest, BatchNotifiesObserversOnCommit) {
+  TestInit();
+  ChangedKeysObserver observer;
+  db_store_->AddObserver(&observer);
+  db_store_->BeginBatch();
+  db_store_->SetValue("test_id1", CreateApplicationValue());
+  db_store_->SetValue("test_id2", CreateApplicationValue());
+  EXPECT_TRUE(observer.keys.empty());
+  EXPECT_TRUE(db_store_->EndBatch());
+  db_store_->RemoveObserver(&observer);
+
+  ASSERT_EQ(2u, observer.keys.size());
+  EXPECT_EQ("test_id1", observer.keys[0]);
+  EXPECT_EQ("test_id2", observer.keys[1]);
+}
+
+TEST_F(DBStoreSqliteImplTest, FailedBatchIsRolledBack) {
+  TestInit();
+  db_store_->SetValue("test_id", CreateApplicationValue());
+
+  // Make the insertion of one application fail in the middle of the batch.
+  {
+    sql::Connection db;
+    ASSERT_TRUE(db.Open(
+        temp_dir_.path().Append(DBStoreSqliteImpl::kDBFileName)));
+    ASSERT_TRUE(db.Execute(
+        "CREATE TRIGGER fail_insert BEFORE INSERT ON applications "
+        "WHEN NEW.id = 'bad_id' BEGIN SELECT RAISE(ABORT, 'fail'); END"));
+  }
+
+  ChangedKeysObserver observer;
+  db_store_->AddObserver(&observer);
+  {
+    sql::ScopedErrorIgnorer ignore_errors;
+    ignore_errors.IgnoreError(SQLITE_CONSTRAINT);
+    db_store_->BeginBatch();
+    db_store_->SetValue("good_id", CreateApplicationValue());
+    ASSERT_TRUE(db_store_->Remove("test_id"));
+    db_store_->SetValue("bad_id", CreateApplicationValue());
+    EXPECT_FALSE(db_store_->EndBatch());
+    EXPECT_TRUE(ignore_errors.CheckIgnoredErrors());
+  }
+  db_store_->RemoveObserver(&observer);
+
+  // Neither the observers nor the cache saw the changes rolled back.
+  EXPECT_TRUE(observer.keys.empty());
+  EXPECT_TRUE(db_store_->HasApplication("test_id"));
+  EXPECT_FALSE(db_store_->HasApplication("good_id"));
+  EXPECT_FALSE(db_store_->HasApplication("bad_id"));
+
+  db_store_.reset(new DBStoreSqliteImpl(temp_dir_.path()));
+  ASSERT_TRUE(db_store_->InitDB());
+  EXPECT_EQ(1u, db_store_->GetApplications()->size());
+  EXPECT_TRUE(db_store_->HasApplication("test_id"));
+}
+
+TEST_F(DBStoreSqliteImplTest, ManifestsAreParsedOnDemand) {
+  TestInit();
+  const std::string ids[] = { "test_id1", "test_id2" };
+  for (size_t i = 0; i < arraysize(ids); ++i) {
+    scoped_ptr<base::DictionaryValue> value(new base::DictionaryValue);
+    value->SetString(ApplicationStore::kApplicationPath, "path");
+    base::DictionaryValue* manifest = new base::DictionaryValue;
+    manifest->SetString("a", ids[i]);
+    value->Set(ApplicationStore::kManifestPath, manifest);
+    value->SetDouble(ApplicationStore::kInstallTime, 0);
+    db_store_->SetValue(ids[i], value.release());
+  }
+  scoped_ptr<base::DictionaryValue> old_value(
+      db_store_->GetApplications()->DeepCopy());
+
+  // Reopen the database, so the manifests are read from the file.
+  db_store_.reset(new DBStoreSqliteImpl(temp_dir_.path()));
+  ASSERT_TRUE(db_store_->InitDB());
+  EXPECT_TRUE(db_store_->HasApplication(ids[1]));
+  EXPECT_FALSE(db_store_->HasApplication("unknown_id"));
+  EXPECT_EQ(NULL, db_store_->GetApplicationValue("unknown_id"));
+
+  const base::DictionaryValue* value = db_store_->GetApplicationValue(ids[0]);
+  ASSERT_TRUE(value);
+  std::string v;
+  ASSERT_TRUE(value->GetString(
+      std::string(ApplicationStore::kManifestPath) + ".a", &v));
+  EXPECT_EQ(ids[0], v);
+
+  EXPECT_TRUE(old_value->Equals(db_store_->GetApplications()));
+}
+
+TEST_F(DBStoreSqliteImplTest, QueryApplications) {
+  TestInit();
+  const char* names[] = { "c", "a", "b", "a" };
+  for (size_t i = 0; i < arraysize(names); ++i) {
+    scoped_ptr<base::DictionaryValue> value(new base::DictionaryValue);
+    value->SetString(ApplicationStore::kApplicationPath, "path");
+    base::DictionaryValue* manifest = new base::DictionaryValue;
+    manifest->SetString("name", names[i]);
+    manifest->SetString("version", i % 2 ? "1.0" : "2.0");
+    base::ListValue* permissions = new base::ListValue;
+    if (i < 2)
+      permissions->AppendString("contacts");
+    manifest->Set("permissions", permissions);
+    value->Set(ApplicationStore::kManifestPath, manifest);
+    value->SetDouble(ApplicationStore::kInstallTime, i);
+    db_store_->SetValue("test_id" + base::IntToString(i), value.release());
+  }
+
+  // Reopen the database, the queries don't need the manifests.
+  db_store_.reset(new DBStoreSqliteImpl(temp_dir_.path()));
+  ASSERT_TRUE(db_store_->InitDB());
+
+  ApplicationQuery query;
+  query.sort_key = ApplicationQuery::SORT_BY_NAME;
+  std::vector<ApplicationSummary> results;
+  ASSERT_TRUE(db_store_->QueryApplications(query, &results));
+  ASSERT_EQ(4u, results.size());
+  EXPECT_EQ("test_id1", results[0].id);
+  EXPECT_EQ("a", results[0].name);
+  EXPECT_EQ("1.0", results[0].version);
+  EXPECT_EQ("test_id3", results[1].id);
+  EXPECT_EQ("test_id2", results[2].id);
+  EXPECT_EQ("test_id0", results[3].id);
+
+  // Paging.
+  query.offset = 1;
+  query.limit = 2;
+  results.clear();
+  ASSERT_TRUE(db_store_->QueryApplications(query, &results));
+  ASSERT_EQ(2u, results.size());
+  EXPECT_EQ("test_id3", results[0].id);
+  EXPECT_EQ("test_id2", results[1].id);
+
+  // Filters.
+  query = ApplicationQuery();
+  query.permission = "contacts";
+  query.sort_key = ApplicationQuery::SORT_BY_INSTALL_TIME;
+  query.descending = true;
+  results.clear();
+  ASSERT_TRUE(db_store_->QueryApplications(query, &results));
+  ASSERT_EQ(2u, results.size());
+  EXPECT_EQ("test_id1", results[0].id);
+  EXPECT_EQ("test_id0", results[1].id);
+
+  query = ApplicationQuery();
+  query.name = "a";
+  query.version = "1.0";
+  query.installed_after = base::Time::FromDoubleT(2);
+  results.clear();
+  ASSERT_TRUE(db_store_->QueryApplications(query, &results));
+  ASSERT_EQ(1u, results.size());
+  EXPECT_EQ("test_id3", results[0].id);
+
+  // Removed applications aren't found anymore.
+  ASSERT_TRUE(db_store_->Remove("test_id1"));
+  query = ApplicationQuery();
+  query.permission = "contacts";
+  results.clear();
+  ASSERT_TRUE(db_store_->QueryApplications(query, &results));
+  ASSERT_EQ(1u, results.size());
+  EXPECT_EQ("test_id0", results[0].id);
+}
+
+TEST_F(DBStoreSqliteImplTest, LaunchDescriptor) {
+  TestInit();
+  scoped_ptr<base::DictionaryValue> value(new base::DictionaryValue);
+  value->SetString(ApplicationStore::kApplicationPath, "path");
+  base::DictionaryValue* manifest = new base::DictionaryValue;
+  manifest->SetString("app.main.source", "main.html");
+  value->Set(ApplicationStore::kManifestPath, manifest);
+  value->SetDouble(ApplicationStore::kInstallTime, 0);
+  std::string id("test_id");
+  db_store_->SetValue(id, value.release());
+
+  // The descriptor and the application are read before InitDB().
+  db_store_.reset(new DBStoreSqliteImpl(temp_dir_.path()));
+  LaunchDescriptor descriptor;
+  ASSERT_TRUE(db_store_->GetLaunchDescriptor(id, &descriptor));
+  EXPECT_EQ(Application::GetResourceURL(
+                Application::GetBaseURLFromApplicationId(id), "main.html"),
+            descriptor.entry_url);
+  EXPECT_EQ(LaunchDescriptor::MAIN_DOCUMENT_SOURCE,
+            descriptor.main_document_type);
+  EXPECT_EQ(LaunchDescriptor::WINDOW_MODE_NONE, descriptor.window_mode);
+  EXPECT_FALSE(db_store_->GetLaunchDescriptor("unknown_id", &descriptor));
+
+  ASSERT_TRUE(db_store_->PreloadApplication(id));
+  EXPECT_FALSE(db_store_->PreloadApplication("unknown_id"));
+  const base::DictionaryValue* stored_value =
+      db_store_->GetApplicationValue(id);
+  ASSERT_TRUE(stored_value);
+  std::string main_source;
+  EXPECT_TRUE(stored_value->GetString(
+      std::string(ApplicationStore::kManifestPath) + ".app.main.source",
+      &main_source));
+  EXPECT_EQ("main.html", main_source);
+
+  // Updating the manifest updates the descriptor.
+  ASSERT_TRUE(db_store_->InitDB());
+  manifest = new base::DictionaryValue;
+  manifest->SetString("app.launch.local_path", "index.html");
+  db_store_->SetValue(id + "." + ApplicationStore::kManifestPath, manifest);
+  ASSERT_TRUE(db_store_->GetLaunchDescriptor(id, &descriptor));
+  EXPECT_EQ(LaunchDescriptor::MAIN_DOCUMENT_NONE,
+            descriptor.main_document_type);
+  EXPECT_EQ(LaunchDescriptor::WINDOW_MODE_DEFAULT, descriptor.window_mode);
+}
+
 }  // namespace application
 }  // namespace xwalk
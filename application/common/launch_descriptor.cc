@@ -0,0 +1,81 @@
+// Copyright (c) 2013 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "xwalk/application/common/launch_descriptor.h"
+
+#include "base/logging.h"
+#include "xwalk/application/common/application.h"
+#include "xwalk/application/common/application_manifest_constants.h"
+#include "xwalk/application/common/constants.h"
+
+namespace keys = xwalk::application_manifest_keys;
+
+namespace xwalk {
+namespace application {
+
+LaunchDescriptor::LaunchDescriptor()
+    : main_document_type(MAIN_DOCUMENT_NONE),
+      window_mode(WINDOW_MODE_DEFAULT) {
+}
+
+LaunchDescriptor::~LaunchDescriptor() {
+}
+
+// static
+bool LaunchDescriptor::FromManifest(const std::string& application_id,
+                                    const base::DictionaryValue& manifest,
+                                    LaunchDescriptor* descriptor) {
+  const GURL application_url =
+      Application::GetBaseURLFromApplicationId(application_id);
+
+  const base::DictionaryValue* dict = NULL;
+  if (manifest.GetDictionary(keys::kAppMainKey, &dict)) {
+    std::string main_source;
+    const base::ListValue* main_scripts = NULL;
+    manifest.GetString(keys::kAppMainSourceKey, &main_source);
+    manifest.GetList(keys::kAppMainScriptsKey, &main_scripts);
+
+    if (!main_source.empty() && (main_scripts && main_scripts->GetSize()))
+      LOG(WARNING) << "An app should not has more than one main document.";
+
+    if (!main_source.empty()) {
+      descriptor->entry_url =
+          Application::GetResourceURL(application_url, main_source);
+      descriptor->main_document_type = MAIN_DOCUMENT_SOURCE;
+      descriptor->window_mode = WINDOW_MODE_NONE;
+      return true;
+    }
+    if (main_scripts && main_scripts->GetSize()) {
+      // When no main.source is defined but main.scripts are, we implicitly
+      // create a main document.
+      descriptor->entry_url = Application::GetResourceURL(
+          application_url, kGeneratedMainDocumentFilename);
+      descriptor->main_document_type = MAIN_DOCUMENT_GENERATED;
+      descriptor->window_mode = WINDOW_MODE_NONE;
+      return true;
+    }
+    LOG(WARNING) << "The app.main field doesn't contain a valid main document.";
+  }
+
+  // NOTE: For now we allow launching a web app from a local path. This may go
+  // away at some point.
+  std::string entry_page;
+  if (manifest.GetString(keys::kLaunchLocalPathKey, &entry_page) &&
+      !entry_page.empty()) {
+    GURL url = Application::GetResourceURL(application_url, entry_page);
+    if (url.is_empty()) {
+      LOG(WARNING) << "Can't find a valid local path URL for app.";
+      return false;
+    }
+    descriptor->entry_url = url;
+    descriptor->main_document_type = MAIN_DOCUMENT_NONE;
+    descriptor->window_mode = WINDOW_MODE_DEFAULT;
+    return true;
+  }
+
+  return false;
+}
+
+}  // namespace application
+}  // namespace xwalk
@@ -0,0 +1,52 @@
+// Copyright (c) 2013 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef XWALK_APPLICATION_COMMON_LAUNCH_DESCRIPTOR_H_
+#define XWALK_APPLICATION_COMMON_LAUNCH_DESCRIPTOR_H_
+
+#include <string>
+
+#include "base/values.h"
+#include "url/gurl.h"
+
+namespace xwalk {
+namespace application {
+
+// Describes how an application is launched, as derived from its manifest.
+// It is computed when the application is installed and stored with it, so
+// an installed application can be launched without looking up its manifest.
+struct LaunchDescriptor {
+  enum MainDocumentType {
+    // No main document, |entry_url| is the app.launch.local_path page.
+    MAIN_DOCUMENT_NONE = 0,
+    // The main document is app.main.source.
+    MAIN_DOCUMENT_SOURCE,
+    // The main document is generated from app.main.scripts.
+    MAIN_DOCUMENT_GENERATED,
+  };
+
+  enum WindowMode {
+    // Main documents run in a runtime without window.
+    WINDOW_MODE_NONE = 0,
+    WINDOW_MODE_DEFAULT,
+  };
+
+  LaunchDescriptor();
+  ~LaunchDescriptor();
+
+  // Fills |descriptor| for the application |application_id| with |manifest|.
+  // Returns false if the manifest has no valid entry point.
+  static bool FromManifest(const std::string& application_id,
+                           const base::DictionaryValue& manifest,
+                           LaunchDescriptor* descriptor);
+
+  GURL entry_url;
+  MainDocumentType main_document_type;
+  WindowMode window_mode;
+};
+
+}  // namespace application
+}  // namespace xwalk
+
+#endif  // XWALK_APPLICATION_COMMON_LAUNCH_DESCRIPTOR_H_
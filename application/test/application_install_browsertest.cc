@@ -0,0 +1,121 @@
+// Copyright (c) 2013 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <string>
+#include <vector>
+
+#include "base/file_util.h"
+#include "base/files/file_enumerator.h"
+#include "base/path_service.h"
+#include "base/threading/thread_restrictions.h"
+#include "xwalk/application/browser/application_service.h"
+#include "xwalk/application/browser/application_system.h"
+#include "xwalk/runtime/browser/runtime.h"
+#include "xwalk/runtime/browser/runtime_context.h"
+#include "xwalk/test/base/in_process_browser_test.h"
+
+using xwalk::application::ApplicationService;
+
+namespace {
+
+// All the test packages are signed with the same key, so they have the same
+// application id.
+base::FilePath GetTestPackagePath(const std::string& name) {
+  base::FilePath path;
+  PathService::Get(base::DIR_SOURCE_ROOT, &path);
+  return path.AppendASCII("xwalk").AppendASCII("application")
+      .AppendASCII("test").AppendASCII("unpacker").AppendASCII(name);
+}
+
+}  // namespace
+
+class ApplicationInstallBrowserTest : public InProcessBrowserTest {
+ protected:
+  ApplicationService* service() {
+    return runtime()->runtime_context()->GetApplicationSystem()
+        ->application_service();
+  }
+
+  base::FilePath GetApplicationDir(const std::string& id) {
+    return runtime()->runtime_context()->GetPath()
+        .AppendASCII("applications").AppendASCII(id);
+  }
+};
+
+IN_PROC_BROWSER_TEST_F(ApplicationInstallBrowserTest, InstallBatch) {
+  // The batch is installed synchronously, as by --install-batch.
+  base::ThreadRestrictions::ScopedAllowIO allow_io;
+
+  // The first package fails to extract, so the second one, with the same id,
+  // fails with it, and the files extracted are deleted.
+  std::vector<base::FilePath> paths;
+  paths.push_back(GetTestPackagePath("bad_signature.xpk"));
+  paths.push_back(GetTestPackagePath("good.xpk"));
+  paths.push_back(GetTestPackagePath("bad_magic.xpk"));
+  std::vector<ApplicationService::BatchInstallResult> results;
+  EXPECT_FALSE(service()->InstallBatch(paths, &results));
+  ASSERT_EQ(3u, results.size());
+  const std::string id = results[0].id;
+  ASSERT_FALSE(id.empty());
+  EXPECT_FALSE(results[0].succeeded);
+  EXPECT_FALSE(results[0].already_installed);
+  EXPECT_EQ(id, results[1].id);
+  EXPECT_FALSE(results[1].succeeded);
+  EXPECT_TRUE(results[1].already_installed);
+  EXPECT_TRUE(results[2].id.empty());
+  EXPECT_FALSE(results[2].succeeded);
+  EXPECT_FALSE(base::PathExists(GetApplicationDir(id)));
+  EXPECT_FALSE(service()->GetApplicationByID(id).get());
+
+  // Only the first copy of a package is installed.
+  paths.clear();
+  paths.push_back(GetTestPackagePath("good.xpk"));
+  paths.push_back(GetTestPackagePath("good.xpk"));
+  results.clear();
+  EXPECT_TRUE(service()->InstallBatch(paths, &results));
+  ASSERT_EQ(2u, results.size());
+  EXPECT_TRUE(results[0].succeeded);
+  EXPECT_FALSE(results[0].already_installed);
+  EXPECT_TRUE(results[1].succeeded);
+  EXPECT_TRUE(results[1].already_installed);
+  EXPECT_TRUE(base::DirectoryExists(GetApplicationDir(id)));
+  EXPECT_TRUE(service()->GetApplicationByID(id).get());
+
+  // Installed packages aren't extracted again.
+  paths.pop_back();
+  results.clear();
+  EXPECT_TRUE(service()->InstallBatch(paths, &results));
+  ASSERT_EQ(1u, results.size());
+  EXPECT_TRUE(results[0].succeeded);
+  EXPECT_TRUE(results[0].already_installed);
+}
+
+IN_PROC_BROWSER_TEST_F(ApplicationInstallBrowserTest, UpdatePacked) {
+  base::ThreadRestrictions::ScopedAllowIO allow_io;
+
+  std::string id;
+  ASSERT_TRUE(service()->InstallPacked(GetTestPackagePath("good.xpk"), &id));
+  const base::FilePath package_path =
+      GetApplicationDir(id).AddExtension(FILE_PATH_LITERAL(".xpk"));
+  ASSERT_TRUE(base::PathExists(package_path));
+
+  // An invalid package leaves the installed one in place.
+  std::string updated_id;
+  EXPECT_FALSE(service()->Update(GetTestPackagePath("bad_signature.xpk"),
+                                 &updated_id));
+  EXPECT_TRUE(base::PathExists(package_path));
+
+  // The package is replaced, not extracted.
+  EXPECT_TRUE(service()->Update(GetTestPackagePath("good.xpk"), &updated_id));
+  EXPECT_EQ(id, updated_id);
+  EXPECT_TRUE(base::PathExists(package_path));
+  EXPECT_FALSE(base::PathExists(GetApplicationDir(id)));
+  EXPECT_TRUE(service()->GetApplicationByID(id).get());
+
+  // No copy is left behind.
+  base::FileEnumerator files(package_path.DirName(), false,
+                             base::FileEnumerator::FILES);
+  EXPECT_EQ(package_path, files.Next());
+  EXPECT_TRUE(files.Next().empty());
+}
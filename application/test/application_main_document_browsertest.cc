@@ -3,7 +3,10 @@
 // found in the LICENSE file.
 
 #include "base/strings/utf_string_conversions.h"
+#include "content/public/browser/navigation_controller.h"
+#include "content/public/browser/navigation_entry.h"
 #include "content/public/browser/web_contents.h"
+#include "content/public/test/browser_test_utils.h"
 #include "content/public/test/test_utils.h"
 #include "net/base/net_util.h"
 #include "xwalk/application/browser/application_system.h"
@@ -12,6 +15,7 @@
 #include "xwalk/application/test/application_browsertest.h"
 #include "xwalk/runtime/browser/runtime.h"
 #include "xwalk/runtime/browser/runtime_registry.h"
+#include "xwalk/test/base/xwalk_test_utils.h"
 
 using xwalk::application::Application;
 
@@ -49,3 +53,53 @@ IN_PROC_BROWSER_TEST_F(ApplicationMainDocumentBrowserTest, MainDocument) {
   // window created by main document).
   WaitForRuntimes(2);
 }
+
+// Verifies the generated main document served loads the main scripts.
+IN_PROC_BROWSER_TEST_F(ApplicationMainDocumentBrowserTest,
+                       GeneratedMainDocument) {
+  content::RunAllPendingInMessageLoop();
+  ASSERT_GE(GetRuntimeNumber(), 1);
+
+  xwalk::Runtime* main_runtime = xwalk::RuntimeRegistry::Get()->runtimes()[0];
+  const Application* app = main_runtime->runtime_context()->
+      GetApplicationSystem()->application_service()->GetRunningApplication();
+  std::string scripts;
+  ASSERT_TRUE(content::ExecuteScriptAndExtractString(
+      main_runtime->web_contents(),
+      "var scripts = [];"
+      "for (var i = 0; i < document.scripts.length; ++i)"
+      "  scripts.push(document.scripts[i].src);"
+      "window.domAutomationController.send(scripts.join(' '));",
+      &scripts));
+  EXPECT_EQ(app->GetResourceURL("main.js").spec(), scripts);
+  WaitForRuntimes(2);
+}
+
+class ApplicationNoMainDocumentBrowserTest: public ApplicationBrowserTest {
+ public:
+  virtual void SetUpCommandLine(CommandLine* command_line) OVERRIDE;
+};
+
+void ApplicationNoMainDocumentBrowserTest::SetUpCommandLine(
+    CommandLine* command_line) {
+  ApplicationBrowserTest::SetUpCommandLine(command_line);
+  GURL url = net::FilePathToFileURL(test_data_dir_.Append(
+        FILE_PATH_LITERAL("no_main_document")));
+  command_line->AppendArg(url.spec());
+}
+
+// Verifies there's no generated main document without main scripts.
+IN_PROC_BROWSER_TEST_F(ApplicationNoMainDocumentBrowserTest, NotFound) {
+  content::RunAllPendingInMessageLoop();
+  WaitForRuntimes(1);
+
+  xwalk::Runtime* runtime = xwalk::RuntimeRegistry::Get()->runtimes()[0];
+  const Application* app = runtime->runtime_context()->
+      GetApplicationSystem()->application_service()->GetRunningApplication();
+  xwalk_test_utils::NavigateToURL(runtime,
+      app->GetResourceURL(xwalk::application::kGeneratedMainDocumentFilename));
+  content::NavigationEntry* entry =
+      runtime->web_contents()->GetController().GetLastCommittedEntry();
+  ASSERT_TRUE(entry);
+  EXPECT_EQ(404, entry->GetHttpStatusCode());
+}
@@ -29,7 +29,6 @@ class DialogExtension : public XWalkExtension,
                         public RuntimeRegistryObserver {
  public:
   explicit DialogExtension(RuntimeRegistry* runtime_registry);
-  virtual ~DialogExtension();
 
   // XWalkExtension implementation.
   virtual XWalkExtensionInstance* CreateInstance() OVERRIDE;
@@ -42,6 +41,8 @@ class DialogExtension : public XWalkExtension,
  private:
   friend class DialogInstance;
 
+  virtual ~DialogExtension();
+
   RuntimeRegistry* runtime_registry_;
   gfx::NativeWindow owning_window_;
 };
@@ -73,6 +73,14 @@ void XWalkExtensionProcessHost::StartProcess() {
   cmd_line->AppendSwitchASCII(switches::kProcessType,
                               switches::kXWalkExtensionProcess);
   cmd_line->AppendSwitchASCII(switches::kProcessChannelID, channel_id);
+
+  static const char* const kSwitchNames[] = {
+    switches::kXWalkExtensionSyncMessageTimeout,
+    switches::kXWalkDumpExtensionMetrics,
+    switches::kXWalkExtensionDispatchThreads,
+  };
+  cmd_line->CopySwitchesFrom(*CommandLine::ForCurrentProcess(), kSwitchNames,
+                             arraysize(kSwitchNames));
   process_->Launch(
 #if defined(OS_WIN)
       new ExtensionSandboxedProcessLauncherDelegate(),
@@ -119,6 +127,8 @@ bool XWalkExtensionProcessHost::OnMessageReceived(const IPC::Message& message) {
     IPC_MESSAGE_HANDLER(
         XWalkExtensionProcessHostMsg_RenderProcessChannelCreated,
         OnRenderChannelCreated)
+    IPC_MESSAGE_HANDLER(XWalkExtensionProcessHostMsg_ExtensionsUsage,
+        OnExtensionsUsage)
     IPC_MESSAGE_UNHANDLED(handled = false)
   IPC_END_MESSAGE_MAP()
   return handled;
@@ -140,6 +150,21 @@ void XWalkExtensionProcessHost::OnRenderChannelCreated(
   SendChannelHandleToRenderProcess();
 }
 
+void XWalkExtensionProcessHost::OnExtensionsUsage(
+    const std::vector<XWalkExtensionUsage>& usage) {
+  bool dump_metrics = CommandLine::ForCurrentProcess()->HasSwitch(
+      switches::kXWalkDumpExtensionMetrics);
+  for (size_t i = 0; i < usage.size(); ++i) {
+    if (dump_metrics) {
+      LOG(INFO) << "External extension '" << usage[i].name << "': "
+                << usage[i].ToString();
+    } else {
+      VLOG(1) << "External extension '" << usage[i].name << "': "
+              << usage[i].ToString();
+    }
+  }
+}
+
 void XWalkExtensionProcessHost::SendChannelHandleToRenderProcess() {
   // It can be that the EP channel got created before the RenderProcessHost.
   if (!render_process_host_)
@@ -5,9 +5,11 @@
 #ifndef XWALK_EXTENSIONS_BROWSER_XWALK_EXTENSION_PROCESS_HOST_H_
 #define XWALK_EXTENSIONS_BROWSER_XWALK_EXTENSION_PROCESS_HOST_H_
 
+#include <vector>
 #include "base/memory/scoped_ptr.h"
 #include "content/public/browser/browser_child_process_host_delegate.h"
 #include "ipc/ipc_channel_handle.h"
+#include "xwalk/extensions/common/xwalk_extension_metrics.h"
 
 namespace base {
 class FilePath;
@@ -52,6 +54,7 @@ class XWalkExtensionProcessHost
 
   // Message Handlers.
   void OnRenderChannelCreated(const IPC::ChannelHandle& channel_id);
+  void OnExtensionsUsage(const std::vector<XWalkExtensionUsage>& usage);
 
   void SendChannelHandleToRenderProcess();
 
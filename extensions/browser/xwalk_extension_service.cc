@@ -64,8 +64,9 @@ class ExtensionServerMessageFilter : public IPC::ChannelProxy::MessageFilter {
       task_runner_->PostTask(
           FROM_HERE,
           base::Bind(
-              base::IgnoreResult(&XWalkExtensionServer::OnMessageReceived),
-              base::Unretained(server_), message));
+              base::IgnoreResult(
+                  &XWalkExtensionServer::OnQueuedMessageReceived),
+              base::Unretained(server_), base::TimeTicks::Now(), message));
       return true;
     }
     return false;
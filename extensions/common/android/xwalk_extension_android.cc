@@ -164,7 +164,7 @@ static jint CreateExtension(JNIEnv* env, jobject obj,
       new XWalkExtensionAndroid(env, obj, name, js_api);
 
   XWalkContentBrowserClient::Get()->main_parts()->RegisterExtension(
-      scoped_ptr<XWalkExtension>(extension));
+      make_scoped_refptr(extension));
 
   return reinterpret_cast<jint>(extension);
 }
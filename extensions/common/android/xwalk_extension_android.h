@@ -32,7 +32,6 @@ class XWalkExtensionAndroidInstance;
 class XWalkExtensionAndroid : public XWalkExtension {
  public:
   XWalkExtensionAndroid(JNIEnv* env, jobject obj, jstring name, jstring js_api);
-  virtual ~XWalkExtensionAndroid();
 
   // JNI interface to post message from Java to JS
   void PostMessage(JNIEnv* env, jobject obj, jint instance, jstring msg);
@@ -42,6 +41,8 @@ class XWalkExtensionAndroid : public XWalkExtension {
   void RemoveInstance(int instance);
 
  private:
+  virtual ~XWalkExtensionAndroid();
+
   bool is_valid();
 
   typedef std::map<int, XWalkExtensionAndroidInstance*> InstanceMap;
@@ -9,7 +9,9 @@
 namespace xwalk {
 namespace extensions {
 
-XWalkExtension::XWalkExtension() {}
+XWalkExtension::XWalkExtension()
+    : is_poolable_(false),
+      is_thread_safe_(false) {}
 
 XWalkExtension::~XWalkExtension() {}
 
@@ -27,6 +29,11 @@ void XWalkExtensionInstance::SetSendSyncReplyCallback(
   send_sync_reply_ = callback;
 }
 
+void XWalkExtensionInstance::SetWriteStreamChunkCallback(
+    const WriteStreamChunkCallback& callback) {
+  write_stream_chunk_ = callback;
+}
+
 void XWalkExtensionInstance::HandleSyncMessage(
     scoped_ptr<base::Value> msg) {
   LOG(FATAL) << "Sending sync message to extension which doesn't support it!";
@@ -8,6 +8,7 @@
 #include <string>
 #include <vector>
 #include "base/callback.h"
+#include "base/memory/ref_counted.h"
 #include "base/values.h"
 
 namespace xwalk {
@@ -30,22 +31,40 @@ class XWalkExtensionInstance;
 // used to create extension instance objects. It also holds information valid
 // for all the instances, like the JavaScript API. See also
 // XWalkExtensionInstance.
-class XWalkExtension {
+//
+// Extensions are reference counted so a single object, with its name and
+// JavaScript API, can be registered in the XWalkExtensionServer of every
+// render process. Once registered, an extension must not be modified.
+class XWalkExtension : public base::RefCountedThreadSafe<XWalkExtension> {
  public:
-  virtual ~XWalkExtension();
-
   virtual XWalkExtensionInstance* CreateInstance() = 0;
 
-  std::string name() const { return name_; }
-  std::string javascript_api() const { return javascript_api_; }
+  const std::string& name() const { return name_; }
+  const std::string& javascript_api() const { return javascript_api_; }
 
   // Returns a list of entry points for which the extension should be loaded
   // when accessed. Entry points are used when the extension needs to have
   // objects outside the namespace that is implicitly created using its name.
   virtual const base::ListValue& entry_points() const { return entry_points_; }
 
+  // Returns true if the instances of this extension keep no state associated
+  // with the JavaScript context that created them. XWalkExtensionServer can
+  // then recycle a released instance for the next context instead of
+  // destroying it and creating a new one, which is a common pattern when
+  // navigating between pages.
+  bool is_poolable() const { return is_poolable_; }
+
+  // Returns true if different instances of this extension can handle messages
+  // at the same time, in different threads. Otherwise all the instances handle
+  // their messages in the same thread, see XWalkExtensionDispatcher.
+  bool is_thread_safe() const { return is_thread_safe_; }
+
  protected:
+  friend class base::RefCountedThreadSafe<XWalkExtension>;
+
   XWalkExtension();
+  virtual ~XWalkExtension();
+
   void set_name(const std::string& name) { name_ = name; }
   void set_javascript_api(const std::string& javascript_api) {
     javascript_api_ = javascript_api;
@@ -53,6 +72,8 @@ class XWalkExtension {
   void set_entry_points(const std::vector<std::string>& entry_points) {
     entry_points_.AppendStrings(entry_points);
   }
+  void set_poolable(bool poolable) { is_poolable_ = poolable; }
+  void set_thread_safe(bool thread_safe) { is_thread_safe_ = thread_safe; }
 
  private:
   // Name of extension, used for dispatching messages.
@@ -65,6 +86,10 @@ class XWalkExtension {
 
   base::ListValue entry_points_;
 
+  bool is_poolable_;
+
+  bool is_thread_safe_;
+
   DISALLOW_COPY_AND_ASSIGN(XWalkExtension);
 };
 
@@ -87,15 +112,22 @@ class XWalkExtensionInstance {
   // can be sent after HandleSyncMessage() function returns.
   virtual void HandleSyncMessage(scoped_ptr<base::Value> msg);
 
+  // Called when the JavaScript side consumed enough chunks of the stream
+  // |stream_id| for WriteStreamChunkToJS() to accept new ones again.
+  virtual void HandleStreamWritable(int stream_id) {}
+
   // Callbacks used by extension instance to communicate back to JS. These are
   // set by the extension system. Callbacks will take the ownership of the
   // message.
   typedef base::Callback<void(scoped_ptr<base::Value> msg)> PostMessageCallback;
   typedef base::Callback<void(scoped_ptr<base::Value> msg)>
       SendSyncReplyCallback;
+  typedef base::Callback<bool(int stream_id, const std::string& chunk,
+                              bool last)> WriteStreamChunkCallback;
 
   void SetPostMessageCallback(const PostMessageCallback& callback);
   void SetSendSyncReplyCallback(const SendSyncReplyCallback& callback);
+  void SetWriteStreamChunkCallback(const WriteStreamChunkCallback& callback);
 
   // Function to be used by extensions Instances to post messages back to
   // JavaScript in the renderer process. This function will take the ownership
@@ -112,9 +144,23 @@ class XWalkExtensionInstance {
     send_sync_reply_.Run(reply.Pass());
   }
 
+  // Sends a chunk of the stream |stream_id| to the JavaScript stream listener.
+  // Streams let an extension hand large payloads to JavaScript in ordered
+  // pieces instead of building a single huge message. Only a small number of
+  // chunks can be in flight per stream: when this returns false the chunk
+  // was not sent, and the extension should write it again after
+  // HandleStreamWritable() is called. Setting |last| closes the stream, and
+  // its id can be reused afterwards. Must be called from the thread where
+  // messages are handled.
+  bool WriteStreamChunkToJS(int stream_id, const std::string& chunk,
+                            bool last) {
+    return write_stream_chunk_.Run(stream_id, chunk, last);
+  }
+
  private:
   PostMessageCallback post_message_;
   SendSyncReplyCallback send_sync_reply_;
+  WriteStreamChunkCallback write_stream_chunk_;
 
   DISALLOW_COPY_AND_ASSIGN(XWalkExtensionInstance);
 };
@@ -4,9 +4,11 @@
 
 #include <stdint.h>
 #include <string>
+#include <vector>
 #include "base/values.h"
 #include "ipc/ipc_channel_handle.h"
 #include "ipc/ipc_message_macros.h"
+#include "xwalk/extensions/common/xwalk_extension_metrics.h"
 
 // Note: it is safe to use numbers after LastIPCMsgStart since that limit
 // is not relevant for embedders. It is used only by a tool inside chrome/
@@ -19,12 +21,23 @@ enum {
 
 #define IPC_MESSAGE_START XWalkExtensionMsgStart
 
+IPC_STRUCT_TRAITS_BEGIN(xwalk::extensions::XWalkExtensionUsage)
+  IPC_STRUCT_TRAITS_MEMBER(name)
+  IPC_STRUCT_TRAITS_MEMBER(live_instances)
+  IPC_STRUCT_TRAITS_MEMBER(callbacks)
+  IPC_STRUCT_TRAITS_MEMBER(callback_time)
+  IPC_STRUCT_TRAITS_MEMBER(bytes_allocated)
+IPC_STRUCT_TRAITS_END()
+
 IPC_MESSAGE_CONTROL1(XWalkExtensionProcessMsg_RegisterExtensions,  // NOLINT(*)
                      base::FilePath /* extensions path */)
 
 IPC_MESSAGE_CONTROL1(XWalkExtensionProcessHostMsg_RenderProcessChannelCreated, // NOLINT(*)
                      IPC::ChannelHandle /* channel id */)
 
+IPC_MESSAGE_CONTROL1(XWalkExtensionProcessHostMsg_ExtensionsUsage, // NOLINT(*)
+                     std::vector<xwalk::extensions::XWalkExtensionUsage>)
+
 IPC_MESSAGE_CONTROL1(XWalkViewMsg_ExtensionProcessChannelCreated, // NOLINT(*)
                      IPC::ChannelHandle /* channel id */)
 
@@ -56,6 +69,16 @@ IPC_SYNC_MESSAGE_CONTROL2_1(XWalkExtensionServerMsg_SendSyncMessageToNative,  //
                             base::ListValue /* input contents */,
                             base::ListValue /* output contents */)
 
+IPC_MESSAGE_CONTROL4(XWalkExtensionClientMsg_PostStreamChunkToJS,  // NOLINT(*)
+                     int64_t /* instance id */,
+                     int /* stream id */,
+                     std::string /* chunk */,
+                     bool /* last chunk */)
+
+IPC_MESSAGE_CONTROL2(XWalkExtensionServerMsg_StreamChunkConsumed,  // NOLINT(*)
+                     int64_t /* instance id */,
+                     int /* stream id */)
+
 IPC_MESSAGE_CONTROL1(XWalkExtensionServerMsg_DestroyInstance,  // NOLINT(*)
                      int64_t /* instance id */)
 
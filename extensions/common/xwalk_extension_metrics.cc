@@ -0,0 +1,57 @@
+// Copyright (c) 2013 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "xwalk/extensions/common/xwalk_extension_metrics.h"
+
+#include "base/format_macros.h"
+#include "base/strings/stringprintf.h"
+
+namespace xwalk {
+namespace extensions {
+
+XWalkExtensionMetrics::XWalkExtensionMetrics()
+    : messages_to_native(0),
+      bytes_to_native(0),
+      messages_to_js(0),
+      bytes_to_js(0),
+      sync_messages(0) {}
+
+void XWalkExtensionMetrics::Add(const XWalkExtensionMetrics& other) {
+  messages_to_native += other.messages_to_native;
+  bytes_to_native += other.bytes_to_native;
+  messages_to_js += other.messages_to_js;
+  bytes_to_js += other.bytes_to_js;
+  sync_messages += other.sync_messages;
+  handler_time += other.handler_time;
+  queue_wait_time += other.queue_wait_time;
+  sync_latency += other.sync_latency;
+}
+
+std::string XWalkExtensionMetrics::ToString() const {
+  return base::StringPrintf(
+      "to native: %" PRId64 " msgs / %" PRId64 " bytes, "
+      "to JS: %" PRId64 " msgs / %" PRId64 " bytes, "
+      "sync: %" PRId64 " msgs / %" PRId64 " ms, "
+      "handlers: %" PRId64 " ms, queue wait: %" PRId64 " ms",
+      messages_to_native, bytes_to_native,
+      messages_to_js, bytes_to_js,
+      sync_messages, sync_latency.InMilliseconds(),
+      handler_time.InMilliseconds(), queue_wait_time.InMilliseconds());
+}
+
+XWalkExtensionUsage::XWalkExtensionUsage()
+    : live_instances(0),
+      callbacks(0),
+      bytes_allocated(0) {}
+
+std::string XWalkExtensionUsage::ToString() const {
+  return base::StringPrintf(
+      "%" PRId64 " instances, %" PRId64 " callbacks / %" PRId64 " ms, "
+      "%" PRId64 " bytes allocated",
+      live_instances, callbacks, callback_time.InMilliseconds(),
+      bytes_allocated);
+}
+
+}  // namespace extensions
+}  // namespace xwalk
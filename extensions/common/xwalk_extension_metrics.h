@@ -0,0 +1,62 @@
+// Copyright (c) 2013 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef XWALK_EXTENSIONS_COMMON_XWALK_EXTENSION_METRICS_H_
+#define XWALK_EXTENSIONS_COMMON_XWALK_EXTENSION_METRICS_H_
+
+#include <stdint.h>
+#include <string>
+#include "base/time/time.h"
+
+namespace xwalk {
+namespace extensions {
+
+// Counters about the messages exchanged between the native and JavaScript
+// sides of an extension. XWalkExtensionServer keeps one of these for each
+// extension and each live instance, see --dump-extension-metrics.
+struct XWalkExtensionMetrics {
+  XWalkExtensionMetrics();
+
+  void Add(const XWalkExtensionMetrics& other);
+  std::string ToString() const;
+
+  int64_t messages_to_native;
+  int64_t bytes_to_native;
+  int64_t messages_to_js;
+  int64_t bytes_to_js;
+  int64_t sync_messages;
+
+  // Time spent running the instances' message handlers.
+  base::TimeDelta handler_time;
+  // Time messages waited between arriving in the process and being handled.
+  base::TimeDelta queue_wait_time;
+  // Time between a SyncMessage arriving and the extension replying it.
+  base::TimeDelta sync_latency;
+};
+
+// Resources used by an external extension in the Extension Process. They are
+// reported periodically to the Browser Process, see
+// XWalkExternalExtension::GetUsage().
+struct XWalkExtensionUsage {
+  XWalkExtensionUsage();
+
+  std::string ToString() const;
+
+  std::string name;
+  int64_t live_instances;
+  int64_t callbacks;
+
+  // CPU time spent running the extension callbacks. Wall time is used on
+  // platforms where the CPU time of a thread can't be read.
+  base::TimeDelta callback_time;
+
+  // Bytes allocated by the runtime to hold the messages, replies and stream
+  // chunks given by the extension.
+  int64_t bytes_allocated;
+};
+
+}  // namespace extensions
+}  // namespace xwalk
+
+#endif  // XWALK_EXTENSIONS_COMMON_XWALK_EXTENSION_METRICS_H_
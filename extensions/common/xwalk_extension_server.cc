@@ -4,30 +4,190 @@
 
 #include "xwalk/extensions/common/xwalk_extension_server.h"
 
+#include <algorithm>
+
+#include "base/command_line.h"
+#include "base/debug/trace_event.h"
 #include "base/file_util.h"
 #include "base/files/file_enumerator.h"
 #include "base/files/file_path.h"
+#include "base/lazy_instance.h"
+#include "base/memory/scoped_vector.h"
+#include "base/metrics/histogram.h"
+#include "base/strings/string_number_conversions.h"
 #include "base/strings/string16.h"
 #include "base/strings/utf_string_conversions.h"
 #include "base/stl_util.h"
+#include "base/threading/simple_thread.h"
+#include "base/threading/thread.h"
+#include "base/threading/thread_local.h"
 #include "content/public/browser/render_process_host.h"
 #include "ipc/ipc_sender.h"
 #include "xwalk/extensions/common/xwalk_extension.h"
 #include "xwalk/extensions/common/xwalk_extension_messages.h"
+#include "xwalk/extensions/common/xwalk_extension_switches.h"
 #include "xwalk/extensions/common/xwalk_external_extension.h"
 
 namespace xwalk {
 namespace extensions {
 
+namespace {
+
+// Upper bound of released instances kept alive per extension. Most pages load
+// a handful of frames, so this covers navigation while capping the memory held
+// by idle instances.
+const size_t kMaxPooledInstancesPerExtension = 4;
+
+void IgnoreMessageFromPooledInstance(scoped_ptr<base::Value> msg) {
+  LOG(WARNING) << "Ignoring message sent by an extension instance that "
+               << "is not associated with any context.";
+}
+
+bool IgnoreStreamChunkFromPooledInstance(int stream_id,
+                                         const std::string& chunk, bool last) {
+  LOG(WARNING) << "Ignoring stream chunk sent by an extension instance that "
+               << "is not associated with any context.";
+  return false;
+}
+
+// Maximum number of chunks of a stream sent to JavaScript and not consumed
+// yet. Together with the chunk size chosen by the extension, this bounds the
+// memory used by a stream regardless of the total size of the payload.
+const int kMaxStreamChunksInFlight = 4;
+
+// Used when no timeout is given by kXWalkExtensionSyncMessageTimeout.
+const int kDefaultSyncMessageTimeoutInSeconds = 30;
+
+// SyncMessages taking longer than this to be replied are logged, since they
+// keep the JavaScript context blocked long enough to be noticed by users.
+const int kSlowSyncMessageThresholdInMilliseconds = 100;
+
+base::TimeDelta GetSyncMessageTimeout() {
+  const CommandLine* cmd_line = CommandLine::ForCurrentProcess();
+  int seconds = kDefaultSyncMessageTimeoutInSeconds;
+  if (cmd_line->HasSwitch(switches::kXWalkExtensionSyncMessageTimeout)) {
+    std::string value = cmd_line->GetSwitchValueASCII(
+        switches::kXWalkExtensionSyncMessageTimeout);
+    if (!base::StringToInt(value, &seconds) || seconds < 0) {
+      LOG(WARNING) << "Invalid value for --"
+                   << switches::kXWalkExtensionSyncMessageTimeout << ": "
+                   << value;
+      seconds = kDefaultSyncMessageTimeoutInSeconds;
+    }
+  }
+  return base::TimeDelta::FromSeconds(seconds);
+}
+
+// Keeps one histogram per extension, so the extensions hurting
+// responsiveness can be told apart.
+void RecordSyncMessageLatency(const std::string& extension_name,
+                              base::TimeDelta latency) {
+  base::HistogramBase* histogram = base::Histogram::FactoryTimeGet(
+      "XWalk.Extensions.SyncMessageLatency." + extension_name,
+      base::TimeDelta::FromMilliseconds(1), base::TimeDelta::FromSeconds(60),
+      50, base::HistogramBase::kNoFlags);
+  histogram->AddTime(latency);
+
+  if (latency.InMilliseconds() > kSlowSyncMessageThresholdInMilliseconds) {
+    LOG(WARNING) << "Extension '" << extension_name << "' took "
+                 << latency.InMilliseconds() << "ms to reply a SyncMessage.";
+  }
+}
+
+// Describes the message being dispatched in the current thread. It is kept in
+// thread local storage because messages of different instances may be
+// dispatched in parallel.
+struct IncomingMessage {
+  size_t size;
+  base::TimeDelta queue_wait;
+};
+
+base::LazyInstance<base::ThreadLocalPointer<const IncomingMessage> >::Leaky
+    g_incoming_message = LAZY_INSTANCE_INITIALIZER;
+
+// Runs the SyncMessage timeouts of every server. It can't be a thread
+// dispatching messages, since an extension hanging in HandleSyncMessage()
+// keeps that thread blocked, which is the case the timeout exists for.
+class SyncMessageWatchdogThread : public base::Thread {
+ public:
+  SyncMessageWatchdogThread() : base::Thread("XWalkExtensionSyncWatchdog") {
+    Start();
+  }
+};
+
+base::LazyInstance<SyncMessageWatchdogThread>::Leaky
+    g_watchdog_thread = LAZY_INSTANCE_INITIALIZER;
+
+}  // namespace
+
+// The delayed tasks releasing SyncMessages hold a reference to this object
+// instead of to the server, so they do nothing once the server is gone. They
+// run in the watchdog thread, and the server waits for a running one to finish
+// before going away.
+class XWalkExtensionServer::SyncMessageWatchdog
+    : public base::RefCountedThreadSafe<SyncMessageWatchdog> {
+ public:
+  explicit SyncMessageWatchdog(XWalkExtensionServer* server)
+      : server_(server) {}
+
+  void Invalidate() {
+    base::AutoLock l(lock_);
+    server_ = NULL;
+  }
+
+  void OnTimeout(int64_t instance_id, int pending_reply_id) {
+    base::AutoLock l(lock_);
+    if (server_)
+      server_->OnSyncMessageTimeout(instance_id, pending_reply_id);
+  }
+
+ private:
+  friend class base::RefCountedThreadSafe<SyncMessageWatchdog>;
+  ~SyncMessageWatchdog() {}
+
+  base::Lock lock_;
+  XWalkExtensionServer* server_;
+
+  DISALLOW_COPY_AND_ASSIGN(SyncMessageWatchdog);
+};
+
 XWalkExtensionServer::XWalkExtensionServer()
-    : sender_(NULL) {}
+    : sender_(NULL),
+      dump_metrics_(CommandLine::ForCurrentProcess()->HasSwitch(
+          switches::kXWalkDumpExtensionMetrics)),
+      sync_message_timeout_(GetSyncMessageTimeout()),
+      next_pending_reply_id_(1),
+      watchdog_(new SyncMessageWatchdog(this)) {}
 
 XWalkExtensionServer::~XWalkExtensionServer() {
+  watchdog_->Invalidate();
   DeleteInstanceMap();
-  STLDeleteValues(&extensions_);
+  extensions_.clear();
+  if (dump_metrics_)
+    DumpExtensionMetrics();
+}
+
+bool XWalkExtensionServer::OnQueuedMessageReceived(
+    base::TimeTicks queued_time, const IPC::Message& message) {
+  return HandleIncomingMessage(message.size(),
+                               base::TimeTicks::Now() - queued_time, message);
 }
 
 bool XWalkExtensionServer::OnMessageReceived(const IPC::Message& message) {
+  return HandleIncomingMessage(message.size(), base::TimeDelta(), message);
+}
+
+bool XWalkExtensionServer::HandleIncomingMessage(
+    size_t size, base::TimeDelta queue_wait, const IPC::Message& message) {
+  IncomingMessage incoming;
+  incoming.size = size;
+  incoming.queue_wait = queue_wait;
+
+  base::ThreadLocalPointer<const IncomingMessage>& current =
+      g_incoming_message.Get();
+  const IncomingMessage* previous = current.Get();
+  current.Set(&incoming);
+
   bool handled = true;
   IPC_BEGIN_MESSAGE_MAP(XWalkExtensionServer, message)
     IPC_MESSAGE_HANDLER(XWalkExtensionServerMsg_CreateInstance,
@@ -39,12 +199,28 @@ bool XWalkExtensionServer::OnMessageReceived(const IPC::Message& message) {
     IPC_MESSAGE_HANDLER_DELAY_REPLY(
         XWalkExtensionServerMsg_SendSyncMessageToNative,
         OnSendSyncMessageToNative)
+    IPC_MESSAGE_HANDLER(XWalkExtensionServerMsg_StreamChunkConsumed,
+        OnStreamChunkConsumed)
     IPC_MESSAGE_UNHANDLED(handled = false)
   IPC_END_MESSAGE_MAP()
 
+  current.Set(previous);
   return handled;
 }
 
+bool XWalkExtensionServer::FindInstance(int64_t instance_id,
+                                        XWalkExtensionInstance** instance,
+                                        XWalkExtension** extension) {
+  base::AutoLock l(instances_lock_);
+  InstanceMap::const_iterator it = instances_.find(instance_id);
+  if (it == instances_.end())
+    return false;
+
+  *instance = it->second.instance;
+  *extension = it->second.extension;
+  return true;
+}
+
 void XWalkExtensionServer::OnCreateInstance(int64_t instance_id,
     std::string name) {
   ExtensionMap::const_iterator it = extensions_.find(name);
@@ -55,7 +231,14 @@ void XWalkExtensionServer::OnCreateInstance(int64_t instance_id,
     return;
   }
 
-  XWalkExtensionInstance* instance = it->second->CreateInstance();
+  XWalkExtensionInstance* instance;
+  {
+    base::AutoLock l(instances_lock_);
+    instance = TakeInstanceFromPool(name);
+  }
+  if (!instance)
+    instance = it->second->CreateInstance();
+
   instance->SetPostMessageCallback(
       base::Bind(&XWalkExtensionServer::PostMessageToJSCallback,
                  base::Unretained(this), instance_id));
@@ -64,23 +247,40 @@ void XWalkExtensionServer::OnCreateInstance(int64_t instance_id,
       base::Bind(&XWalkExtensionServer::SendSyncReplyToJSCallback,
                  base::Unretained(this), instance_id));
 
+  instance->SetWriteStreamChunkCallback(
+      base::Bind(&XWalkExtensionServer::WriteStreamChunkToJSCallback,
+                 base::Unretained(this), instance_id));
+
   InstanceExecutionData data;
   data.instance = instance;
+  data.extension = it->second;
   data.pending_reply = NULL;
+  data.pending_reply_id = 0;
+  data.timed_out = false;
 
-  instances_[instance_id] = data;
+  {
+    base::AutoLock l(instances_lock_);
+    instances_[instance_id] = data;
+  }
+
+  base::AutoLock l(metrics_lock_);
+  instance_metrics_[instance_id].extension_name = name;
 }
 
 void XWalkExtensionServer::OnPostMessageToNative(int64_t instance_id,
     const base::ListValue& msg) {
-  InstanceMap::const_iterator it = instances_.find(instance_id);
-  if (it == instances_.end()) {
+  XWalkExtensionInstance* instance;
+  XWalkExtension* extension;
+  if (!FindInstance(instance_id, &instance, &extension)) {
     LOG(WARNING) << "Can't PostMessage to invalid Extension instance id: "
                  << instance_id;
     return;
   }
 
-  const InstanceExecutionData& data = it->second;
+  const IncomingMessage& incoming = *g_incoming_message.Get().Get();
+  TRACE_EVENT2("xwalk", "XWalkExtensionServer::OnPostMessageToNative",
+               "extension", TRACE_STR_COPY(extension->name().c_str()),
+               "bytes", static_cast<int>(incoming.size));
 
   // The const_cast is needed to remove the only Value contained by the
   // ListValue (which is solely used as wrapper, since Value doesn't
@@ -90,7 +290,16 @@ void XWalkExtensionServer::OnPostMessageToNative(int64_t instance_id,
   // can be costly depending on the size of Value.
   scoped_ptr<base::Value> value;
   const_cast<base::ListValue*>(&msg)->Remove(0, &value);
-  data.instance->HandleMessage(value.Pass());
+
+  base::TimeTicks handler_start = base::TimeTicks::Now();
+  instance->HandleMessage(value.Pass());
+
+  XWalkExtensionMetrics delta;
+  delta.messages_to_native = 1;
+  delta.bytes_to_native = incoming.size;
+  delta.handler_time = base::TimeTicks::Now() - handler_start;
+  delta.queue_wait_time = incoming.queue_wait;
+  AddMetrics(instance_id, delta);
 }
 
 void XWalkExtensionServer::Initialize(IPC::Sender* sender) {
@@ -140,7 +349,7 @@ bool ValidateExtensionIdentifier(const std::string& name) {
 }  // namespace
 
 bool XWalkExtensionServer::RegisterExtension(
-    scoped_ptr<XWalkExtension> extension) {
+    const scoped_refptr<XWalkExtension>& extension) {
   if (!ValidateExtensionIdentifier(extension->name())) {
     LOG(WARNING) << "Ignoring extension with invalid name: "
                  << extension->name();
@@ -168,10 +377,10 @@ bool XWalkExtensionServer::RegisterExtension(
     extension_symbols_.insert(entry_point);
   }
 
-  std::string name = extension->name();
+  const std::string& name = extension->name();
 
   extension_symbols_.insert(name);
-  extensions_[name] = extension.release();
+  extensions_[name] = extension;
   return true;
 }
 
@@ -179,35 +388,156 @@ void XWalkExtensionServer::PostMessageToJSCallback(
     int64_t instance_id, scoped_ptr<base::Value> msg) {
   base::ListValue wrapped_msg;
   wrapped_msg.Append(msg.release());
-  Send(new XWalkExtensionClientMsg_PostMessageToJS(instance_id, wrapped_msg));
+  IPC::Message* ipc_msg =
+      new XWalkExtensionClientMsg_PostMessageToJS(instance_id, wrapped_msg);
+
+  XWalkExtensionMetrics delta;
+  delta.messages_to_js = 1;
+  delta.bytes_to_js = ipc_msg->size();
+  AddMetrics(instance_id, delta);
+
+  TRACE_EVENT1("xwalk", "XWalkExtensionServer::PostMessageToJS",
+               "bytes", static_cast<int>(delta.bytes_to_js));
+  Send(ipc_msg);
 }
 
 void XWalkExtensionServer::SendSyncReplyToJSCallback(
     int64_t instance_id, scoped_ptr<base::Value> reply) {
+  IPC::Message* pending_reply;
+  XWalkExtension* extension;
+  base::TimeTicks pending_reply_start;
+  {
+    base::AutoLock l(instances_lock_);
+    InstanceMap::iterator it = instances_.find(instance_id);
+    if (it == instances_.end()) {
+      LOG(WARNING) << "Can't SendSyncMessage to invalid Extension instance id: "
+                   << instance_id;
+      return;
+    }
+
+    InstanceExecutionData& data = it->second;
+    if (!data.pending_reply) {
+      LOG(WARNING) << "There's no pending SyncMessage for instance id: "
+                   << instance_id;
+      return;
+    }
+
+    pending_reply = data.pending_reply;
+    extension = data.extension;
+    pending_reply_start = data.pending_reply_start;
+    data.pending_reply = NULL;
+    data.pending_reply_id = 0;
+  }
+
+  base::TimeDelta latency = base::TimeTicks::Now() - pending_reply_start;
+  RecordSyncMessageLatency(extension->name(), latency);
 
+  base::ListValue wrapped_reply;
+  wrapped_reply.Append(reply.release());
+  IPC::WriteParam(pending_reply, wrapped_reply);
+
+  XWalkExtensionMetrics delta;
+  delta.bytes_to_js = pending_reply->size();
+  delta.sync_latency = latency;
+  AddMetrics(instance_id, delta);
+
+  Send(pending_reply);
+}
+
+bool XWalkExtensionServer::WriteStreamChunkToJSCallback(
+    int64_t instance_id, int stream_id, const std::string& chunk, bool last) {
+  // Held while sending, so chunks of a stream written from different threads
+  // are accounted in the same order they are sent.
+  base::AutoLock l(instances_lock_);
   InstanceMap::iterator it = instances_.find(instance_id);
   if (it == instances_.end()) {
-    LOG(WARNING) << "Can't SendSyncMessage to invalid Extension instance id: "
-                 << instance_id;
-    return;
+    LOG(WARNING) << "Can't write stream chunk from invalid Extension instance "
+                 << "id: " << instance_id;
+    return false;
+  }
+
+  // A stream reusing the id of one whose chunks are still in flight shares
+  // its budget until they're acknowledged.
+  std::map<int, StreamState>& streams = it->second.streams;
+  StreamState& stream = streams[stream_id];
+  if (stream.chunks_in_flight >= kMaxStreamChunksInFlight)
+    return false;
+
+  if (!Send(new XWalkExtensionClientMsg_PostStreamChunkToJS(
+          instance_id, stream_id, chunk, last))) {
+    if (!stream.chunks_in_flight)
+      streams.erase(stream_id);
+    return false;
+  }
+
+  // The client doesn't acknowledge the last chunk, so the stream is done
+  // from our side once the others are.
+  stream.ended = last;
+  if (!last)
+    stream.chunks_in_flight++;
+  else if (!stream.chunks_in_flight)
+    streams.erase(stream_id);
+  return true;
+}
+
+void XWalkExtensionServer::OnStreamChunkConsumed(int64_t instance_id,
+                                                 int stream_id) {
+  XWalkExtensionInstance* instance;
+  bool was_full;
+  {
+    base::AutoLock l(instances_lock_);
+    InstanceMap::iterator it = instances_.find(instance_id);
+    if (it == instances_.end())
+      return;
+
+    InstanceExecutionData& data = it->second;
+    std::map<int, StreamState>::iterator stream_it =
+        data.streams.find(stream_id);
+    if (stream_it == data.streams.end())
+      return;
+
+    StreamState& stream = stream_it->second;
+    instance = data.instance;
+    was_full = stream.chunks_in_flight >= kMaxStreamChunksInFlight;
+    if (stream.chunks_in_flight > 0)
+      stream.chunks_in_flight--;
+    if (stream.ended && !stream.chunks_in_flight)
+      data.streams.erase(stream_it);
   }
 
+  if (was_full)
+    instance->HandleStreamWritable(stream_id);
+}
+
+void XWalkExtensionServer::OnSyncMessageTimeout(int64_t instance_id,
+                                                int pending_reply_id) {
+  base::AutoLock l(instances_lock_);
+  InstanceMap::iterator it = instances_.find(instance_id);
+  if (it == instances_.end())
+    return;
+
   InstanceExecutionData& data = it->second;
-  if (!data.pending_reply) {
-    LOG(WARNING) << "There's no pending SyncMessage for instance id: "
-                 << instance_id;
+  if (!data.pending_reply || data.pending_reply_id != pending_reply_id)
     return;
-  }
 
-  base::ListValue wrapped_reply;
-  wrapped_reply.Append(reply.release());
-  IPC::WriteParam(data.pending_reply, wrapped_reply);
+  LOG(ERROR) << "Extension '" << data.extension->name() << "' didn't reply "
+             << "a SyncMessage after "
+             << sync_message_timeout_.InMilliseconds()
+             << "ms. Releasing instance id " << instance_id
+             << " with an empty reply.";
+  RecordSyncMessageLatency(data.extension->name(), sync_message_timeout_);
+
+  IPC::WriteParam(data.pending_reply, base::ListValue());
   Send(data.pending_reply);
 
   data.pending_reply = NULL;
+  data.pending_reply_id = 0;
+  // The instance may still be busy with the message.
+  data.timed_out = true;
 }
 
 void XWalkExtensionServer::DeleteInstanceMap() {
+  base::AutoLock l(instances_lock_);
   InstanceMap::iterator it = instances_.begin();
   int pending_replies_left = 0;
 
@@ -225,6 +555,47 @@ void XWalkExtensionServer::DeleteInstanceMap() {
     LOG(WARNING) << pending_replies_left
                  << " pending replies left when destroying server.";
   }
+
+  DeleteInstancePool();
+}
+
+XWalkExtensionInstance* XWalkExtensionServer::TakeInstanceFromPool(
+    const std::string& name) {
+  InstancePool::iterator it = instance_pool_.find(
+      InstancePoolKey(name, base::PlatformThread::CurrentId()));
+  if (it == instance_pool_.end() || it->second.empty())
+    return NULL;
+
+  XWalkExtensionInstance* instance = it->second.back();
+  it->second.pop_back();
+  return instance;
+}
+
+bool XWalkExtensionServer::ReturnInstanceToPool(
+    const std::string& name, XWalkExtensionInstance* instance) {
+  std::vector<XWalkExtensionInstance*>& pooled = instance_pool_[
+      InstancePoolKey(name, base::PlatformThread::CurrentId())];
+  if (pooled.size() >= kMaxPooledInstancesPerExtension)
+    return false;
+
+  // The instance is not bound to any context anymore, so whatever it posts
+  // until it is reused can't reach JavaScript.
+  instance->SetPostMessageCallback(
+      base::Bind(&IgnoreMessageFromPooledInstance));
+  instance->SetSendSyncReplyCallback(
+      base::Bind(&IgnoreMessageFromPooledInstance));
+  instance->SetWriteStreamChunkCallback(
+      base::Bind(&IgnoreStreamChunkFromPooledInstance));
+
+  pooled.push_back(instance);
+  return true;
+}
+
+void XWalkExtensionServer::DeleteInstancePool() {
+  InstancePool::iterator it = instance_pool_.begin();
+  for (; it != instance_pool_.end(); ++it)
+    STLDeleteElements(&it->second);
+  instance_pool_.clear();
 }
 
 bool XWalkExtensionServer::ValidateExtensionEntryPoints(
@@ -251,21 +622,45 @@ bool XWalkExtensionServer::ValidateExtensionEntryPoints(
 
 void XWalkExtensionServer::OnSendSyncMessageToNative(int64_t instance_id,
     const base::ListValue& msg, IPC::Message* ipc_reply) {
-  InstanceMap::iterator it = instances_.find(instance_id);
-  if (it == instances_.end()) {
-    LOG(WARNING) << "Can't SendSyncMessage to invalid Extension instance id: "
-                 << instance_id;
-    return;
-  }
+  XWalkExtensionInstance* instance;
+  XWalkExtension* extension;
+  int pending_reply_id;
+  {
+    base::AutoLock l(instances_lock_);
+    InstanceMap::iterator it = instances_.find(instance_id);
+    if (it == instances_.end()) {
+      LOG(WARNING) << "Can't SendSyncMessage to invalid Extension instance id: "
+                   << instance_id;
+      // Reply anyway, otherwise the caller would stay blocked forever.
+      IPC::WriteParam(ipc_reply, base::ListValue());
+      Send(ipc_reply);
+      return;
+    }
 
-  InstanceExecutionData& data = it->second;
-  if (data.pending_reply) {
-    LOG(WARNING) << "There's already a pending Sync Message for "
-                 << "Extension instance id: " << instance_id;
-    return;
+    InstanceExecutionData& data = it->second;
+    if (data.pending_reply) {
+      LOG(WARNING) << "There's already a pending Sync Message for "
+                   << "Extension instance id: " << instance_id;
+      IPC::WriteParam(ipc_reply, base::ListValue());
+      Send(ipc_reply);
+      return;
+    }
+
+    data.pending_reply = ipc_reply;
+    data.pending_reply_id = next_pending_reply_id_++;
+    data.pending_reply_start = base::TimeTicks::Now();
+    instance = data.instance;
+    extension = data.extension;
+    pending_reply_id = data.pending_reply_id;
   }
 
-  data.pending_reply = ipc_reply;
+  if (sync_message_timeout_ > base::TimeDelta()) {
+    g_watchdog_thread.Get().message_loop_proxy()->PostDelayedTask(
+        FROM_HERE,
+        base::Bind(&SyncMessageWatchdog::OnTimeout, watchdog_, instance_id,
+                   pending_reply_id),
+        sync_message_timeout_);
+  }
 
   // The const_cast is needed to remove the only Value contained by the
   // ListValue (which is solely used as wrapper, since Value doesn't
@@ -275,26 +670,89 @@ void XWalkExtensionServer::OnSendSyncMessageToNative(int64_t instance_id,
   // can be costly depending on the size of Value.
   scoped_ptr<base::Value> value;
   const_cast<base::ListValue*>(&msg)->Remove(0, &value);
-  XWalkExtensionInstance* instance = data.instance;
 
+  const IncomingMessage& incoming = *g_incoming_message.Get().Get();
+  TRACE_EVENT2("xwalk", "XWalkExtensionServer::OnSendSyncMessageToNative",
+               "extension", TRACE_STR_COPY(extension->name().c_str()),
+               "bytes", static_cast<int>(incoming.size));
+
+  // Accounted before running the handler, since it may reply right away.
+  XWalkExtensionMetrics delta;
+  delta.messages_to_native = 1;
+  delta.sync_messages = 1;
+  delta.bytes_to_native = incoming.size;
+  delta.queue_wait_time = incoming.queue_wait;
+  AddMetrics(instance_id, delta);
+
+  base::TimeTicks handler_start = base::TimeTicks::Now();
   instance->HandleSyncMessage(value.Pass());
+
+  XWalkExtensionMetrics handler_delta;
+  handler_delta.handler_time = base::TimeTicks::Now() - handler_start;
+  AddMetrics(instance_id, handler_delta);
 }
 
 void XWalkExtensionServer::OnDestroyInstance(int64_t instance_id) {
-  InstanceMap::iterator it = instances_.find(instance_id);
-  if (it == instances_.end()) {
-    LOG(WARNING) << "Can't destroy inexistent instance:" << instance_id;
-    return;
-  }
+  XWalkExtensionInstance* instance_to_delete = NULL;
+  {
+    base::AutoLock l(instances_lock_);
+    InstanceMap::iterator it = instances_.find(instance_id);
+    if (it == instances_.end()) {
+      LOG(WARNING) << "Can't destroy inexistent instance:" << instance_id;
+      return;
+    }
 
-  InstanceExecutionData& data = it->second;
+    InstanceExecutionData& data = it->second;
 
-  delete data.instance;
-  instances_.erase(it);
+    // Instances still waiting to reply a SyncMessage, or which didn't reply
+    // one in time, may be in the middle of some work, so they are not safe to
+    // be handed to another context.
+    if (!data.extension->is_poolable() || data.pending_reply ||
+        data.timed_out ||
+        !ReturnInstanceToPool(data.extension->name(), data.instance)) {
+      instance_to_delete = data.instance;
+    }
+    instances_.erase(it);
+  }
+  delete instance_to_delete;
+
+  {
+    base::AutoLock l(metrics_lock_);
+    std::map<int64_t, InstanceMetrics>::iterator metrics_it =
+        instance_metrics_.find(instance_id);
+    if (metrics_it != instance_metrics_.end()) {
+      if (dump_metrics_) {
+        LOG(INFO) << "Extension '" << metrics_it->second.extension_name
+                  << "' instance " << instance_id << ": "
+                  << metrics_it->second.metrics.ToString();
+      }
+      instance_metrics_.erase(metrics_it);
+    }
+  }
 
   Send(new XWalkExtensionClientMsg_InstanceDestroyed(instance_id));
 }
 
+void XWalkExtensionServer::AddMetrics(int64_t instance_id,
+                                      const XWalkExtensionMetrics& delta) {
+  base::AutoLock l(metrics_lock_);
+  std::map<int64_t, InstanceMetrics>::iterator it =
+      instance_metrics_.find(instance_id);
+  if (it == instance_metrics_.end())
+    return;
+
+  it->second.metrics.Add(delta);
+  extension_metrics_[it->second.extension_name].Add(delta);
+}
+
+void XWalkExtensionServer::DumpExtensionMetrics() {
+  base::AutoLock l(metrics_lock_);
+  std::map<std::string, XWalkExtensionMetrics>::const_iterator it =
+      extension_metrics_.begin();
+  for (; it != extension_metrics_.end(); ++it)
+    LOG(INFO) << "Extension '" << it->first << "': " << it->second.ToString();
+}
+
 void XWalkExtensionServer::RegisterExtensionsInRenderProcess() {
   // Having a sender means we have a RenderProcessHost ready.
   DCHECK(sender_);
@@ -308,6 +766,14 @@ void XWalkExtensionServer::RegisterExtensionsInRenderProcess() {
   }
 }
 
+bool XWalkExtensionServer::IsExtensionThreadSafe(
+    const std::string& name) const {
+  // Extensions are registered before any message is dispatched, so the map
+  // doesn't change while the dispatch threads run.
+  ExtensionMap::const_iterator it = extensions_.find(name);
+  return it != extensions_.end() && it->second->is_thread_safe();
+}
+
 void XWalkExtensionServer::Invalidate() {
   base::AutoLock l(sender_lock_);
   sender_ = NULL;
@@ -327,6 +793,40 @@ base::FilePath::StringType GetNativeLibraryPattern() {
   return UTF16ToUTF8(library_pattern);
 #endif
 }
+
+// Upper bound of threads used to load external extensions. Loading is
+// dominated by disk access and dynamic linking, so a few threads are enough.
+const int kMaxExtensionLoaderThreads = 4;
+
+// Loading a library slower than this is reported, since it delays startup.
+const int kSlowExtensionLoadThresholdInMilliseconds = 50;
+
+// Loads and initializes an external extension library. It runs in a thread
+// of the loader pool, and the result is registered later in the calling
+// thread, see RegisterExternalExtensionsInDirectory().
+class ExternalExtensionLoader : public base::DelegateSimpleThread::Delegate {
+ public:
+  explicit ExternalExtensionLoader(const base::FilePath& path)
+      : path_(path) {}
+
+  virtual void Run() OVERRIDE {
+    base::TimeTicks start = base::TimeTicks::Now();
+    extension_ = new XWalkExternalExtension(path_);
+    load_time_ = base::TimeTicks::Now() - start;
+  }
+
+  const base::FilePath& path() const { return path_; }
+  XWalkExternalExtension* extension() const { return extension_.get(); }
+  base::TimeDelta load_time() const { return load_time_; }
+
+ private:
+  base::FilePath path_;
+  scoped_refptr<XWalkExternalExtension> extension_;
+  base::TimeDelta load_time_;
+
+  DISALLOW_COPY_AND_ASSIGN(ExternalExtensionLoader);
+};
+
 }  // namespace
 
 void RegisterExternalExtensionsInDirectory(
@@ -342,15 +842,66 @@ void RegisterExternalExtensionsInDirectory(
   base::FileEnumerator libraries(
       dir, false, base::FileEnumerator::FILES, GetNativeLibraryPattern());
 
+  std::vector<base::FilePath> paths;
   for (base::FilePath extension_path = libraries.Next();
         !extension_path.empty(); extension_path = libraries.Next()) {
-    scoped_ptr<XWalkExternalExtension> extension(
-        new XWalkExternalExtension(extension_path));
+    paths.push_back(extension_path);
+  }
+
+  // The enumeration order depends on the file system. Sorting keeps the
+  // registration order, and thus which extension wins a name conflict,
+  // stable between runs.
+  std::sort(paths.begin(), paths.end());
+
+  ScopedVector<ExternalExtensionLoader> loaders;
+  for (size_t i = 0; i < paths.size(); ++i)
+    loaders.push_back(new ExternalExtensionLoader(paths[i]));
+
+  // Libraries are loaded and initialized in parallel, since each one is
+  // independent from the others and dynamic linking dominates the cost.
+  if (loaders.size() == 1) {
+    loaders[0]->Run();
+  } else if (loaders.size() > 1) {
+    base::DelegateSimpleThreadPool pool(
+        "XWalkExtensionLoader",
+        std::min(static_cast<int>(loaders.size()),
+                 kMaxExtensionLoaderThreads));
+    for (size_t i = 0; i < loaders.size(); ++i)
+      pool.AddWork(loaders[i]);
+    pool.Start();
+    pool.JoinAll();
+  }
+
+  for (size_t i = 0; i < loaders.size(); ++i) {
+    const ExternalExtensionLoader* loader = loaders[i];
+    int64 load_time_ms = loader->load_time().InMilliseconds();
+    if (load_time_ms > kSlowExtensionLoadThresholdInMilliseconds) {
+      LOG(WARNING) << "Loading external extension '"
+                   << loader->path().AsUTF8Unsafe() << "' took "
+                   << load_time_ms << "ms.";
+    } else {
+      VLOG(1) << "Loading external extension '"
+              << loader->path().AsUTF8Unsafe() << "' took "
+              << load_time_ms << "ms.";
+    }
+
+    XWalkExternalExtension* extension = loader->extension();
     if (extension->is_valid())
-      server->RegisterExtension(extension.PassAs<XWalkExtension>());
+      server->RegisterExtension(scoped_refptr<XWalkExtension>(extension));
   }
 }
 
+void XWalkExtensionServer::SetSyncMessageTimeoutForTesting(
+    base::TimeDelta timeout) {
+  sync_message_timeout_ = timeout;
+}
+
+XWalkExtensionMetrics XWalkExtensionServer::GetExtensionMetricsForTesting(
+    const std::string& name) {
+  base::AutoLock l(metrics_lock_);
+  return extension_metrics_[name];
+}
+
 bool ValidateExtensionNameForTesting(const std::string& extension_name) {
   return ValidateExtensionIdentifier(extension_name);
 }
@@ -9,11 +9,17 @@
 #include <map>
 #include <set>
 #include <string>
+#include <utility>
+#include <vector>
 
+#include "base/memory/ref_counted.h"
 #include "base/synchronization/lock.h"
+#include "base/threading/platform_thread.h"
+#include "base/time/time.h"
 #include "base/values.h"
 #include "ipc/ipc_channel_proxy.h"
 #include "ipc/ipc_listener.h"
+#include "xwalk/extensions/common/xwalk_extension_metrics.h"
 
 namespace base {
 class FilePath;
@@ -38,6 +44,11 @@ class XWalkExtensionInstance;
 //
 // This class is used both by in-process extensions running in the Browser
 // Process, and by the external extensions running in the Extension Process.
+//
+// Messages of different instances may be dispatched from different threads,
+// see XWalkExtensionDispatcher, as long as the messages of each instance are
+// dispatched in sequence. Extensions must be registered before any message is
+// dispatched.
 class XWalkExtensionServer : public IPC::Listener {
  public:
   XWalkExtensionServer();
@@ -47,26 +58,77 @@ class XWalkExtensionServer : public IPC::Listener {
   virtual bool OnMessageReceived(const IPC::Message& message) OVERRIDE;
   virtual void OnChannelConnected(int32 peer_pid) OVERRIDE;
 
+  // Same as OnMessageReceived(), for messages that waited in a task queue
+  // since |queued_time| before reaching the server thread.
+  bool OnQueuedMessageReceived(base::TimeTicks queued_time,
+                               const IPC::Message& message);
+
   void Initialize(IPC::Sender* sender);
   bool Send(IPC::Message* msg);
 
-  bool RegisterExtension(scoped_ptr<XWalkExtension> extension);
+  // Registers an extension that may be shared with other servers. The server
+  // keeps a reference to it.
+  bool RegisterExtension(const scoped_refptr<XWalkExtension>& extension);
   void RegisterExtensionsInRenderProcess();
 
+  // Returns false if |name| isn't registered. Can be called from any thread.
+  bool IsExtensionThreadSafe(const std::string& name) const;
+
   void Invalidate();
 
+  // Overrides kXWalkExtensionSyncMessageTimeout, which is in seconds.
+  void SetSyncMessageTimeoutForTesting(base::TimeDelta timeout);
+
+  // Returns the metrics accumulated by the instances of extension |name|.
+  XWalkExtensionMetrics GetExtensionMetricsForTesting(
+      const std::string& name);
+
  private:
+  class SyncMessageWatchdog;
+
+  // The chunks of a stream sent and not yet consumed by JavaScript.
+  struct StreamState {
+    StreamState() : chunks_in_flight(0), ended(false) {}
+    int chunks_in_flight;
+    // The last chunk was sent. The state is kept until the other chunks are
+    // acknowledged, so late acknowledgements aren't accounted to a new stream
+    // reusing the id.
+    bool ended;
+  };
+
   struct InstanceExecutionData {
     XWalkExtensionInstance* instance;
+    XWalkExtension* extension;
     IPC::Message* pending_reply;
+    // Identifies the current pending reply, so a timeout posted for an
+    // earlier SyncMessage doesn't affect the current one.
+    int pending_reply_id;
+    base::TimeTicks pending_reply_start;
+    // Whether a SyncMessage of this instance timed out, see
+    // OnSyncMessageTimeout().
+    bool timed_out;
+    // The streams of this instance with chunks in flight, by id.
+    std::map<int, StreamState> streams;
   };
 
+  // |size| and |queue_wait| describe |message| to its handlers, so they can
+  // account it in the metrics.
+  bool HandleIncomingMessage(size_t size, base::TimeDelta queue_wait,
+                             const IPC::Message& message);
+
+  // Looks up |instance_id|. The pointers returned stay valid while handling a
+  // message of that instance, since its destruction is dispatched in the same
+  // sequence.
+  bool FindInstance(int64_t instance_id, XWalkExtensionInstance** instance,
+                    XWalkExtension** extension);
+
   // Message Handlers
   void OnCreateInstance(int64_t instance_id, std::string name);
   void OnDestroyInstance(int64_t instance_id);
   void OnPostMessageToNative(int64_t instance_id, const base::ListValue& msg);
   void OnSendSyncMessageToNative(int64_t instance_id,
       const base::ListValue& msg, IPC::Message* ipc_reply);
+  void OnStreamChunkConsumed(int64_t instance_id, int stream_id);
 
   void PostMessageToJSCallback(int64_t instance_id,
                                scoped_ptr<base::Value> msg);
@@ -74,22 +136,70 @@ class XWalkExtensionServer : public IPC::Listener {
   void SendSyncReplyToJSCallback(int64_t instance_id,
                                  scoped_ptr<base::Value> reply);
 
+  bool WriteStreamChunkToJSCallback(int64_t instance_id, int stream_id,
+                                    const std::string& chunk, bool last);
+
+  // Releases the JavaScript context blocked on a SyncMessage that the
+  // extension didn't reply in time. The reply is sent empty, which the
+  // client reports to JavaScript as an error.
+  void OnSyncMessageTimeout(int64_t instance_id, int pending_reply_id);
+
   void DeleteInstanceMap();
 
+  // Instances of poolable extensions are kept here when their context is
+  // released, so they can be handed to the next context asking for the same
+  // extension. See XWalkExtension::is_poolable(). An instance is only handed
+  // to a context whose messages are dispatched in the thread it was released
+  // from, so each instance keeps running in a single thread. Must be called
+  // with |instances_lock_| held.
+  XWalkExtensionInstance* TakeInstanceFromPool(const std::string& name);
+  bool ReturnInstanceToPool(const std::string& name,
+                            XWalkExtensionInstance* instance);
+  void DeleteInstancePool();
+
   bool ValidateExtensionEntryPoints(const base::ListValue& entry_points);
 
+  // Adds |delta| to the metrics of |instance_id| and of its extension. Can be
+  // called from any thread.
+  void AddMetrics(int64_t instance_id, const XWalkExtensionMetrics& delta);
+  void DumpExtensionMetrics();
+
   base::Lock sender_lock_;
   IPC::Sender* sender_;
 
-  typedef std::map<std::string, XWalkExtension*> ExtensionMap;
+  typedef std::map<std::string, scoped_refptr<XWalkExtension> > ExtensionMap;
   ExtensionMap extensions_;
 
+  // Protects |instances_|, |instance_pool_| and |next_pending_reply_id_|. It is
+  // never held while calling into an extension instance.
+  base::Lock instances_lock_;
+
   typedef std::map<int64_t, InstanceExecutionData> InstanceMap;
   InstanceMap instances_;
 
+  typedef std::pair<std::string, base::PlatformThreadId> InstancePoolKey;
+  typedef std::map<InstancePoolKey, std::vector<XWalkExtensionInstance*> >
+      InstancePool;
+  InstancePool instance_pool_;
+
   // The exported symbols for extensions already registered.
   typedef std::set<std::string> ExtensionSymbolsSet;
   ExtensionSymbolsSet extension_symbols_;
+
+  struct InstanceMetrics {
+    std::string extension_name;
+    XWalkExtensionMetrics metrics;
+  };
+
+  // Protects the metrics, since extensions can post messages from any thread.
+  base::Lock metrics_lock_;
+  std::map<int64_t, InstanceMetrics> instance_metrics_;
+  std::map<std::string, XWalkExtensionMetrics> extension_metrics_;
+  bool dump_metrics_;
+
+  base::TimeDelta sync_message_timeout_;
+  int next_pending_reply_id_;
+  scoped_refptr<SyncMessageWatchdog> watchdog_;
 };
 
 void RegisterExternalExtensionsInDirectory(
@@ -4,10 +4,260 @@
 
 #include "xwalk/extensions/common/xwalk_extension_server.h"
 
+#include <string>
+#include <vector>
+
 #include "base/basictypes.h"
+#include "base/bind.h"
+#include "base/command_line.h"
+#include "base/logging.h"
+#include "base/memory/scoped_vector.h"
+#include "base/synchronization/lock.h"
+#include "base/synchronization/waitable_event.h"
+#include "base/threading/thread.h"
+#include "base/time/time.h"
+#include "ipc/ipc_sender.h"
 #include "testing/gtest/include/gtest/gtest.h"
+#include "xwalk/extensions/common/xwalk_extension.h"
+#include "xwalk/extensions/common/xwalk_extension_messages.h"
+#include "xwalk/extensions/common/xwalk_extension_metrics.h"
+#include "xwalk/extensions/common/xwalk_extension_switches.h"
 
 using xwalk::extensions::ValidateExtensionNameForTesting;
+using xwalk::extensions::XWalkExtension;
+using xwalk::extensions::XWalkExtensionInstance;
+using xwalk::extensions::XWalkExtensionMetrics;
+using xwalk::extensions::XWalkExtensionServer;
+
+namespace {
+
+class NullSender : public IPC::Sender {
+ public:
+  virtual bool Send(IPC::Message* msg) OVERRIDE {
+    delete msg;
+    return true;
+  }
+};
+
+class CountingInstance : public XWalkExtensionInstance {
+ public:
+  explicit CountingInstance(int* live_instances)
+      : live_instances_(live_instances) {
+    ++(*live_instances_);
+  }
+  virtual ~CountingInstance() { --(*live_instances_); }
+
+  virtual void HandleMessage(scoped_ptr<base::Value> msg) OVERRIDE {}
+
+ private:
+  int* live_instances_;
+};
+
+class CountingExtension : public XWalkExtension {
+ public:
+  CountingExtension(bool poolable, int* created_instances,
+                    int* live_instances)
+      : created_instances_(created_instances),
+        live_instances_(live_instances) {
+    set_name("counting");
+    set_poolable(poolable);
+  }
+
+  virtual XWalkExtensionInstance* CreateInstance() OVERRIDE {
+    ++(*created_instances_);
+    return new CountingInstance(live_instances_);
+  }
+
+ private:
+  int* created_instances_;
+  int* live_instances_;
+};
+
+// Signals |replied| when a SyncMessage reply is sent.
+class SyncReplySender : public IPC::Sender {
+ public:
+  explicit SyncReplySender(base::WaitableEvent* replied)
+      : replied_(replied) {}
+
+  virtual bool Send(IPC::Message* msg) OVERRIDE {
+    if (msg->is_reply())
+      replied_->Signal();
+    delete msg;
+    return true;
+  }
+
+ private:
+  base::WaitableEvent* replied_;
+};
+
+// Hangs in HandleSyncMessage() until a reply is sent for it by someone else,
+// or for a long time if that never happens.
+class HangingInstance : public CountingInstance {
+ public:
+  HangingInstance(int* live_instances, base::WaitableEvent* replied)
+      : CountingInstance(live_instances),
+        replied_(replied) {}
+
+  virtual void HandleSyncMessage(scoped_ptr<base::Value> msg) OVERRIDE {
+    replied_->TimedWait(base::TimeDelta::FromSeconds(30));
+  }
+
+ private:
+  base::WaitableEvent* replied_;
+};
+
+class HangingExtension : public XWalkExtension {
+ public:
+  HangingExtension(int* live_instances, base::WaitableEvent* replied)
+      : live_instances_(live_instances),
+        replied_(replied) {
+    set_name("hanging");
+    set_poolable(true);
+  }
+
+  virtual XWalkExtensionInstance* CreateInstance() OVERRIDE {
+    return new HangingInstance(live_instances_, replied_);
+  }
+
+ private:
+  int* live_instances_;
+  base::WaitableEvent* replied_;
+};
+
+class StreamingInstance : public XWalkExtensionInstance {
+ public:
+  StreamingInstance() : writable_calls_(0) {}
+
+  virtual void HandleMessage(scoped_ptr<base::Value> msg) OVERRIDE {}
+  virtual void HandleStreamWritable(int stream_id) OVERRIDE {
+    writable_calls_++;
+  }
+
+  bool WriteChunk(int stream_id, bool last) {
+    return WriteStreamChunkToJS(stream_id, "chunk", last);
+  }
+
+  int writable_calls() const { return writable_calls_; }
+
+ private:
+  int writable_calls_;
+};
+
+class StreamingExtension : public XWalkExtension {
+ public:
+  StreamingExtension() : last_instance_(NULL) {
+    set_name("streaming");
+  }
+
+  virtual XWalkExtensionInstance* CreateInstance() OVERRIDE {
+    last_instance_ = new StreamingInstance;
+    return last_instance_;
+  }
+
+  StreamingInstance* last_instance() const { return last_instance_; }
+
+ private:
+  StreamingInstance* last_instance_;
+};
+
+class MessageCounter {
+ public:
+  MessageCounter() : count_(0) {}
+
+  void Increment() {
+    base::AutoLock l(lock_);
+    count_++;
+  }
+
+  int count() {
+    base::AutoLock l(lock_);
+    return count_;
+  }
+
+ private:
+  base::Lock lock_;
+  int count_;
+};
+
+class MessageCountingInstance : public XWalkExtensionInstance {
+ public:
+  explicit MessageCountingInstance(MessageCounter* counter)
+      : counter_(counter) {}
+
+  virtual void HandleMessage(scoped_ptr<base::Value> msg) OVERRIDE {
+    counter_->Increment();
+  }
+
+ private:
+  MessageCounter* counter_;
+};
+
+class MessageCountingExtension : public XWalkExtension {
+ public:
+  explicit MessageCountingExtension(MessageCounter* counter)
+      : counter_(counter) {
+    set_name("message_counting");
+  }
+
+  virtual XWalkExtensionInstance* CreateInstance() OVERRIDE {
+    return new MessageCountingInstance(counter_);
+  }
+
+ private:
+  MessageCounter* counter_;
+};
+
+// Posts every message back to JavaScript.
+class EchoingInstance : public XWalkExtensionInstance {
+ public:
+  virtual void HandleMessage(scoped_ptr<base::Value> msg) OVERRIDE {
+    PostMessageToJS(msg.Pass());
+  }
+};
+
+class EchoingExtension : public XWalkExtension {
+ public:
+  EchoingExtension() {
+    set_name("echoing");
+  }
+
+  virtual XWalkExtensionInstance* CreateInstance() OVERRIDE {
+    return new EchoingInstance;
+  }
+};
+
+std::vector<std::string>* g_log_messages = NULL;
+
+bool CaptureLogMessage(int severity, const char* file, int line,
+                       size_t message_start, const std::string& str) {
+  g_log_messages->push_back(str.substr(message_start));
+  return true;
+}
+
+void DispatchInstanceMessages(XWalkExtensionServer* server,
+                              int64_t instance_id, int count) {
+  server->OnMessageReceived(
+      XWalkExtensionServerMsg_CreateInstance(instance_id, "message_counting"));
+  for (int i = 0; i < count; ++i) {
+    base::ListValue msg;
+    msg.AppendInteger(i);
+    server->OnMessageReceived(
+        XWalkExtensionServerMsg_PostMessageToNative(instance_id, msg));
+  }
+  server->OnMessageReceived(
+      XWalkExtensionServerMsg_DestroyInstance(instance_id));
+}
+
+void CreateAndDestroyInstances(XWalkExtensionServer* server, int count) {
+  for (int i = 0; i < count; ++i) {
+    server->OnMessageReceived(
+        XWalkExtensionServerMsg_CreateInstance(i, "counting"));
+  }
+  for (int i = 0; i < count; ++i)
+    server->OnMessageReceived(XWalkExtensionServerMsg_DestroyInstance(i));
+}
+
+}  // namespace
 
 TEST(XWalkExtensionServerTest, ValidateExtensionName) {
   const std::string valid_names[] = {
@@ -42,3 +292,249 @@ TEST(XWalkExtensionServerTest, ValidateExtensionName) {
         << "Extension name should be invalid: " << invalid_names[i];
   }
 }
+
+TEST(XWalkExtensionServerTest, PoolableInstancesAreReused) {
+  int created_instances = 0;
+  int live_instances = 0;
+  NullSender sender;
+
+  {
+    XWalkExtensionServer server;
+    server.Initialize(&sender);
+    ASSERT_TRUE(server.RegisterExtension(make_scoped_refptr(
+        new CountingExtension(true, &created_instances, &live_instances))));
+
+    // Simulate navigating a few times between pages with two frames each.
+    for (int i = 0; i < 3; ++i)
+      CreateAndDestroyInstances(&server, 2);
+
+    EXPECT_EQ(2, created_instances);
+    EXPECT_EQ(2, live_instances);
+  }
+
+  EXPECT_EQ(0, live_instances);
+}
+
+TEST(XWalkExtensionServerTest, NonPoolableInstancesAreDestroyed) {
+  int created_instances = 0;
+  int live_instances = 0;
+  NullSender sender;
+
+  XWalkExtensionServer server;
+  server.Initialize(&sender);
+  ASSERT_TRUE(server.RegisterExtension(make_scoped_refptr(
+      new CountingExtension(false, &created_instances, &live_instances))));
+
+  for (int i = 0; i < 3; ++i)
+    CreateAndDestroyInstances(&server, 2);
+
+  EXPECT_EQ(6, created_instances);
+  EXPECT_EQ(0, live_instances);
+}
+
+TEST(XWalkExtensionServerTest, StreamChunksAreFlowControlled) {
+  NullSender sender;
+  XWalkExtensionServer server;
+  server.Initialize(&sender);
+
+  StreamingExtension* extension = new StreamingExtension;
+  ASSERT_TRUE(server.RegisterExtension(
+      make_scoped_refptr(extension)));
+  server.OnMessageReceived(
+      XWalkExtensionServerMsg_CreateInstance(1, "streaming"));
+  StreamingInstance* instance = extension->last_instance();
+  ASSERT_TRUE(instance);
+
+  // Keep writing until the server refuses the chunk because none of them was
+  // consumed by the client.
+  int written_chunks = 0;
+  while (instance->WriteChunk(1, false))
+    written_chunks++;
+  EXPECT_LT(0, written_chunks);
+
+  // Other streams are not affected.
+  EXPECT_TRUE(instance->WriteChunk(2, false));
+
+  server.OnMessageReceived(XWalkExtensionServerMsg_StreamChunkConsumed(1, 1));
+  EXPECT_EQ(1, instance->writable_calls());
+  EXPECT_TRUE(instance->WriteChunk(1, false));
+  EXPECT_FALSE(instance->WriteChunk(1, false));
+
+  // Closing a stream makes its id available again, once its chunks are
+  // consumed.
+  for (int i = 0; i < written_chunks; ++i)
+    server.OnMessageReceived(XWalkExtensionServerMsg_StreamChunkConsumed(1, 1));
+  EXPECT_TRUE(instance->WriteChunk(1, true));
+  for (int i = 0; i < written_chunks; ++i)
+    EXPECT_TRUE(instance->WriteChunk(1, false));
+}
+
+TEST(XWalkExtensionServerTest, LateStreamAcksAfterIdReuse) {
+  NullSender sender;
+  XWalkExtensionServer server;
+  server.Initialize(&sender);
+
+  StreamingExtension* extension = new StreamingExtension;
+  ASSERT_TRUE(server.RegisterExtension(
+      make_scoped_refptr(extension)));
+  server.OnMessageReceived(
+      XWalkExtensionServerMsg_CreateInstance(1, "streaming"));
+  StreamingInstance* instance = extension->last_instance();
+  ASSERT_TRUE(instance);
+
+  // The stream ends with all its chunks in flight.
+  int written_chunks = 0;
+  while (instance->WriteChunk(1, false))
+    written_chunks++;
+  EXPECT_TRUE(instance->WriteChunk(1, true));
+
+  // A new stream reusing the id waits for the chunks of the previous one.
+  EXPECT_FALSE(instance->WriteChunk(1, false));
+  server.OnMessageReceived(XWalkExtensionServerMsg_StreamChunkConsumed(1, 1));
+  EXPECT_TRUE(instance->WriteChunk(1, false));
+  EXPECT_FALSE(instance->WriteChunk(1, false));
+
+  // The late acknowledgements of the previous stream only free the room of
+  // its own chunks, so the new one stays bounded.
+  for (int i = 1; i < written_chunks; ++i)
+    server.OnMessageReceived(XWalkExtensionServerMsg_StreamChunkConsumed(1, 1));
+  for (int i = 1; i < written_chunks; ++i)
+    EXPECT_TRUE(instance->WriteChunk(1, false));
+  EXPECT_FALSE(instance->WriteChunk(1, false));
+}
+
+TEST(XWalkExtensionServerTest, ExtensionsCanBeSharedBetweenServers) {
+  int created_instances = 0;
+  int live_instances = 0;
+  NullSender sender;
+  scoped_refptr<XWalkExtension> extension(
+      new CountingExtension(false, &created_instances, &live_instances));
+
+  {
+    XWalkExtensionServer first_server;
+    XWalkExtensionServer second_server;
+    first_server.Initialize(&sender);
+    second_server.Initialize(&sender);
+    ASSERT_TRUE(first_server.RegisterExtension(extension));
+    ASSERT_TRUE(second_server.RegisterExtension(extension));
+
+    first_server.OnMessageReceived(
+        XWalkExtensionServerMsg_CreateInstance(1, "counting"));
+    second_server.OnMessageReceived(
+        XWalkExtensionServerMsg_CreateInstance(1, "counting"));
+    EXPECT_EQ(2, live_instances);
+  }
+
+  // The servers only dropped their references.
+  EXPECT_TRUE(extension->HasOneRef());
+  EXPECT_EQ(0, live_instances);
+}
+
+TEST(XWalkExtensionServerTest, InstancesCanBeDispatchedInParallel) {
+  const int kThreadCount = 4;
+  const int kMessagesPerInstance = 100;
+
+  NullSender sender;
+  MessageCounter counter;
+  XWalkExtensionServer server;
+  server.Initialize(&sender);
+  ASSERT_TRUE(server.RegisterExtension(make_scoped_refptr(
+      new MessageCountingExtension(&counter))));
+
+  // Each thread plays the role of a dispatch thread owning one instance.
+  ScopedVector<base::Thread> threads;
+  for (int i = 0; i < kThreadCount; ++i) {
+    base::Thread* thread = new base::Thread("DispatchThread");
+    ASSERT_TRUE(thread->Start());
+    thread->message_loop()->PostTask(
+        FROM_HERE, base::Bind(&DispatchInstanceMessages, &server, i,
+                              kMessagesPerInstance));
+    threads.push_back(thread);
+  }
+
+  // Stopping the threads waits for the tasks posted to them.
+  threads.clear();
+
+  EXPECT_EQ(kThreadCount * kMessagesPerInstance, counter.count());
+}
+
+TEST(XWalkExtensionServerTest, HangingSyncMessageTimesOut) {
+  int live_instances = 0;
+  base::WaitableEvent replied(false, false);
+  SyncReplySender sender(&replied);
+
+  XWalkExtensionServer server;
+  server.Initialize(&sender);
+  server.SetSyncMessageTimeoutForTesting(
+      base::TimeDelta::FromMilliseconds(50));
+  ASSERT_TRUE(server.RegisterExtension(make_scoped_refptr(
+      new HangingExtension(&live_instances, &replied))));
+
+  server.OnMessageReceived(
+      XWalkExtensionServerMsg_CreateInstance(1, "hanging"));
+  EXPECT_EQ(1, live_instances);
+
+  // The handler blocks this thread, so only the watchdog can release it.
+  base::TimeTicks start = base::TimeTicks::Now();
+  base::ListValue msg;
+  msg.AppendString("hang");
+  base::ListValue reply;
+  server.OnMessageReceived(
+      XWalkExtensionServerMsg_SendSyncMessageToNative(1, msg, &reply));
+  EXPECT_LT(base::TimeTicks::Now() - start, base::TimeDelta::FromSeconds(10));
+
+  // Although the extension is poolable, an instance that timed out is
+  // destroyed instead of being handed to another context.
+  server.OnMessageReceived(XWalkExtensionServerMsg_DestroyInstance(1));
+  EXPECT_EQ(0, live_instances);
+}
+
+TEST(XWalkExtensionServerTest, MessagesAreAccountedInMetrics) {
+  // The dump is enabled when the server is created.
+  CommandLine original_command_line(*CommandLine::ForCurrentProcess());
+  CommandLine::ForCurrentProcess()->AppendSwitch(
+      switches::kXWalkDumpExtensionMetrics);
+  NullSender sender;
+  scoped_ptr<XWalkExtensionServer> server(new XWalkExtensionServer);
+  *CommandLine::ForCurrentProcess() = original_command_line;
+
+  server->Initialize(&sender);
+  ASSERT_TRUE(server->RegisterExtension(
+      make_scoped_refptr(new EchoingExtension)));
+  server->OnMessageReceived(
+      XWalkExtensionServerMsg_CreateInstance(1, "echoing"));
+
+  base::ListValue msg;
+  msg.AppendString("ping");
+  XWalkExtensionServerMsg_PostMessageToNative message(1, msg);
+  const int64_t message_size = message.size();
+  server->OnMessageReceived(message);
+  const base::TimeDelta queue_wait = base::TimeDelta::FromMilliseconds(20);
+  server->OnQueuedMessageReceived(base::TimeTicks::Now() - queue_wait,
+                                  message);
+
+  XWalkExtensionMetrics metrics =
+      server->GetExtensionMetricsForTesting("echoing");
+  EXPECT_EQ(2, metrics.messages_to_native);
+  EXPECT_EQ(2 * message_size, metrics.bytes_to_native);
+  EXPECT_EQ(2, metrics.messages_to_js);
+  EXPECT_LT(0, metrics.bytes_to_js);
+  EXPECT_EQ(0, metrics.sync_messages);
+  EXPECT_GE(metrics.queue_wait_time, queue_wait);
+
+  std::vector<std::string> log_messages;
+  g_log_messages = &log_messages;
+  logging::SetLogMessageHandler(&CaptureLogMessage);
+  server->OnMessageReceived(XWalkExtensionServerMsg_DestroyInstance(1));
+  // The metrics of the extension outlive its instances.
+  EXPECT_EQ(2, server->GetExtensionMetricsForTesting("echoing")
+                   .messages_to_native);
+  server.reset();
+  logging::SetLogMessageHandler(NULL);
+  g_log_messages = NULL;
+
+  ASSERT_EQ(2u, log_messages.size());
+  EXPECT_EQ(0u, log_messages[0].find("Extension 'echoing' instance 1: "));
+  EXPECT_EQ(0u, log_messages[1].find(
+      "Extension 'echoing': " + metrics.ToString()));
+}
@@ -23,4 +23,21 @@ const char kXWalkDisableExtensionProcess[] =
 // Used internally to launch an extension process.
 const char kXWalkExtensionProcess[] = "xwalk-extension-process";
 
+// Number of seconds an extension has to reply a synchronous message before
+// the blocked JavaScript context is released with an error. Zero disables the
+// timeout.
+const char kXWalkExtensionSyncMessageTimeout[] =
+    "extension-sync-message-timeout";
+
+// Logs the messaging metrics of each extension instance when it is destroyed,
+// and the totals per extension when the extension system shuts down.
+const char kXWalkDumpExtensionMetrics[] = "dump-extension-metrics";
+
+// Number of threads dispatching the messages of the external extensions in
+// the Extension Process. The instances of an extension share one thread,
+// unless the extension declares itself thread-safe. Zero, or no switch, keeps
+// all messages in the main thread of the process.
+const char kXWalkExtensionDispatchThreads[] =
+    "extension-dispatch-threads";
+
 }  // namespace switches
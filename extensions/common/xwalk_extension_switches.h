@@ -11,6 +11,9 @@ namespace switches {
 extern const char kXWalkEnableLoadingExtensionsOnDemand[];
 extern const char kXWalkDisableExtensionProcess[];
 extern const char kXWalkExtensionProcess[];
+extern const char kXWalkExtensionSyncMessageTimeout[];
+extern const char kXWalkDumpExtensionMetrics[];
+extern const char kXWalkExtensionDispatchThreads[];
 
 }  // namespace switches
 
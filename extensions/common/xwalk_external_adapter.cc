@@ -20,15 +20,18 @@ XWalkExternalAdapter* XWalkExternalAdapter::GetInstance() {
 }
 
 XW_Extension XWalkExternalAdapter::GetNextXWExtension() {
+  base::AutoLock l(lock_);
   return next_xw_extension_++;
 }
 
 XW_Instance XWalkExternalAdapter::GetNextXWInstance() {
+  base::AutoLock l(lock_);
   return next_xw_instance_++;
 }
 
 void XWalkExternalAdapter::RegisterExtension(
     XWalkExternalExtension* extension) {
+  base::AutoLock l(lock_);
   XW_Extension xw_extension = extension->xw_extension_;
   CHECK(IsValidXWExtension(xw_extension));
   CHECK(extension_map_.find(xw_extension) == extension_map_.end());
@@ -37,6 +40,7 @@ void XWalkExternalAdapter::RegisterExtension(
 
 void XWalkExternalAdapter::UnregisterExtension(
     XWalkExternalExtension* extension) {
+  base::AutoLock l(lock_);
   XW_Extension xw_extension = extension->xw_extension_;
   CHECK(IsValidXWExtension(xw_extension));
   CHECK(extension_map_.find(xw_extension) != extension_map_.end());
@@ -44,6 +48,7 @@ void XWalkExternalAdapter::UnregisterExtension(
 }
 
 void XWalkExternalAdapter::RegisterInstance(XWalkExternalInstance* context) {
+  base::AutoLock l(lock_);
   XW_Instance xw_instance = context->xw_instance_;
   CHECK(IsValidXWInstance(xw_instance));
   CHECK(instance_map_.find(xw_instance) == instance_map_.end());
@@ -51,12 +56,23 @@ void XWalkExternalAdapter::RegisterInstance(XWalkExternalInstance* context) {
 }
 
 void XWalkExternalAdapter::UnregisterInstance(XWalkExternalInstance* context) {
+  base::AutoLock l(lock_);
   XW_Instance xw_instance = context->xw_instance_;
   CHECK(IsValidXWInstance(xw_instance));
   CHECK(instance_map_.find(xw_instance) != instance_map_.end());
   instance_map_.erase(xw_instance);
 }
 
+void XWalkExternalAdapter::GetExtensionsUsage(
+    std::vector<XWalkExtensionUsage>* usage) {
+  base::AutoLock l(lock_);
+  ExtensionMap::iterator it = extension_map_.begin();
+  for (; it != extension_map_.end(); ++it) {
+    if (it->second->is_valid())
+      usage->push_back(it->second->GetUsage());
+  }
+}
+
 const void* XWalkExternalAdapter::GetInterface(const char* name) {
   if (!strcmp(name, XW_CORE_INTERFACE_1)) {
     static const XW_CoreInterface_1 coreInterface1 = {
@@ -94,6 +110,28 @@ const void* XWalkExternalAdapter::GetInterface(const char* name) {
     return &entryPointsInterface1;
   }
 
+  if (!strcmp(name, XW_INTERNAL_INSTANCE_POOL_INTERFACE_1)) {
+    static const XW_Internal_InstancePoolInterface_1 instancePoolInterface1 = {
+      InstancePoolSetInstancesPoolable
+    };
+    return &instancePoolInterface1;
+  }
+
+  if (!strcmp(name, XW_INTERNAL_THREADING_INTERFACE_1)) {
+    static const XW_Internal_ThreadingInterface_1 threadingInterface1 = {
+      ThreadingSetInstancesThreadSafe
+    };
+    return &threadingInterface1;
+  }
+
+  if (!strcmp(name, XW_INTERNAL_STREAM_INTERFACE_1)) {
+    static const XW_Internal_StreamInterface_1 streamInterface1 = {
+      StreamRegisterWritable,
+      StreamWriteChunk
+    };
+    return &streamInterface1;
+  }
+
   LOG(WARNING) << "Interface '" << name << "' is not supported.";
   return NULL;
 }
@@ -109,6 +147,7 @@ bool XWalkExternalAdapter::IsValidXWInstance(XW_Instance xw_instance) {
 XWalkExternalExtension* XWalkExternalAdapter::GetExtension(
     XW_Extension xw_extension) {
   XWalkExternalAdapter* adapter = XWalkExternalAdapter::GetInstance();
+  base::AutoLock l(adapter->lock_);
   ExtensionMap::iterator it = adapter->extension_map_.find(xw_extension);
   if (it == adapter->extension_map_.end())
     return NULL;
@@ -118,6 +157,7 @@ XWalkExternalExtension* XWalkExternalAdapter::GetExtension(
 XWalkExternalInstance* XWalkExternalAdapter::GetInstance(
     XW_Instance xw_instance) {
   XWalkExternalAdapter* adapter = XWalkExternalAdapter::GetInstance();
+  base::AutoLock l(adapter->lock_);
   InstanceMap::iterator it = adapter->instance_map_.find(xw_instance);
   if (it == adapter->instance_map_.end())
     return NULL;
@@ -6,10 +6,15 @@
 #define XWALK_EXTENSIONS_COMMON_XWALK_EXTERNAL_ADAPTER_H_
 
 #include <map>
+#include <vector>
 #include "base/memory/singleton.h"
+#include "base/synchronization/lock.h"
 #include "xwalk/extensions/public/XW_Extension.h"
 #include "xwalk/extensions/public/XW_Extension_SyncMessage.h"
 #include "xwalk/extensions/public/XW_Extension_EntryPoints.h"
+#include "xwalk/extensions/public/XW_Extension_InstancePool.h"
+#include "xwalk/extensions/public/XW_Extension_Stream.h"
+#include "xwalk/extensions/public/XW_Extension_Threading.h"
 #include "xwalk/extensions/common/xwalk_external_extension.h"
 #include "xwalk/extensions/common/xwalk_external_instance.h"
 
@@ -17,6 +22,15 @@
 // GetInterface(). They dispatch the function to the appropriate
 // extension or instance.
 
+#define DEFINE_FUNCTION_0(TYPE, INTERFACE, NAME)                \
+  static void INTERFACE ## NAME(XW_ ## TYPE xw) {               \
+    XWalkExternal ## TYPE * ptr = Get ## TYPE(xw);              \
+    if (!ptr)                                                   \
+      LogInvalidCall(xw, #TYPE, #INTERFACE, #NAME);             \
+    else                                                        \
+      ptr->INTERFACE ## NAME();                                 \
+  }
+
 #define DEFINE_FUNCTION_1(TYPE, INTERFACE, NAME, ARG1)          \
   static void INTERFACE ## NAME(XW_ ## TYPE xw, ARG1 arg1) {    \
     XWalkExternal ## TYPE * ptr = Get ## TYPE(xw);              \
@@ -44,6 +58,17 @@
     return NULL;                                                \
   }
 
+#define DEFINE_RET_FUNCTION_4(TYPE, INTERFACE, NAME, RET_ARG,              \
+                              ARG1, ARG2, ARG3, ARG4)                     \
+  static RET_ARG INTERFACE ## NAME(XW_ ## TYPE xw, ARG1 arg1, ARG2 arg2,  \
+                                   ARG3 arg3, ARG4 arg4) {                \
+    XWalkExternal ## TYPE * ptr = Get ## TYPE(xw);                        \
+    if (ptr)                                                              \
+      return ptr->INTERFACE ## NAME(arg1, arg2, arg3, arg4);              \
+    LogInvalidCall(xw, #TYPE, #INTERFACE, #NAME);                         \
+    return 0;                                                             \
+  }
+
 template <typename T> struct DefaultSingletonTraits;
 
 namespace xwalk {
@@ -55,7 +80,8 @@ class XWalkExternalInstance;
 // Provides the "C Interfaces" defined in XW_Extension.h and maps the
 // functions from external extension to their implementations in
 // XWalkExternalExtension and XWalkExternalInstance. We have only one
-// adapter per process.
+// adapter per process. External extensions can be loaded from several threads
+// at once, so the adapter is thread-safe.
 class XWalkExternalAdapter {
  public:
   static XWalkExternalAdapter* GetInstance();
@@ -73,6 +99,10 @@ class XWalkExternalAdapter {
   void RegisterInstance(XWalkExternalInstance* context);
   void UnregisterInstance(XWalkExternalInstance* context);
 
+  // Fills |usage| with the resources used by each external extension loaded
+  // in this process.
+  void GetExtensionsUsage(std::vector<XWalkExtensionUsage>* usage);
+
   // Returns the correct struct according to interface asked. This is
   // passed to external extensions in XW_Initialize() call.
   static const void* GetInterface(const char* name);
@@ -114,6 +144,21 @@ class XWalkExternalAdapter {
                     XW_HandleSyncMessageCallback);
   DEFINE_FUNCTION_1(Instance, SyncMessaging, SetSyncReply, const char*);
 
+  // XW_Internal_InstancePoolInterface_1 from XW_Extension_InstancePool.h.
+  DEFINE_FUNCTION_0(Extension, InstancePool, SetInstancesPoolable);
+
+  // XW_Internal_ThreadingInterface_1 from XW_Extension_Threading.h.
+  DEFINE_FUNCTION_0(Extension, Threading, SetInstancesThreadSafe);
+
+  // XW_Internal_StreamInterface_1 from XW_Extension_Stream.h.
+  DEFINE_FUNCTION_1(Extension, Stream, RegisterWritable,
+                    XW_HandleStreamWritableCallback);
+  DEFINE_RET_FUNCTION_4(Instance, Stream, WriteChunk, int32_t,
+                        int32_t, const char*, size_t, int32_t);
+
+  // Protects the maps and the counters below.
+  base::Lock lock_;
+
   typedef std::map<XW_Extension, XWalkExternalExtension*> ExtensionMap;
   ExtensionMap extension_map_;
 
@@ -21,6 +21,7 @@ XWalkExternalExtension::XWalkExternalExtension(const base::FilePath& path)
       shutdown_callback_(NULL),
       handle_msg_callback_(NULL),
       handle_sync_msg_callback_(NULL),
+      handle_stream_writable_callback_(NULL),
       initialized_(false) {
   std::string error;
   base::ScopedNativeLibrary library(base::LoadNativeLibrary(path, &error));
@@ -53,10 +54,11 @@ XWalkExternalExtension::XWalkExternalExtension(const base::FilePath& path)
 }
 
 XWalkExternalExtension::~XWalkExternalExtension() {
-  if (!initialized_)
+  // Extensions that failed to initialize are registered in the adapter too.
+  if (!xw_extension_)
     return;
 
-  if (shutdown_callback_)
+  if (initialized_ && shutdown_callback_)
     shutdown_callback_(xw_extension_);
   XWalkExternalAdapter::GetInstance()->UnregisterExtension(this);
 }
@@ -65,6 +67,29 @@ bool XWalkExternalExtension::is_valid() {
   return initialized_;
 }
 
+XWalkExtensionUsage XWalkExternalExtension::GetUsage() {
+  base::AutoLock l(usage_lock_);
+  XWalkExtensionUsage usage = usage_;
+  usage.name = name();
+  return usage;
+}
+
+void XWalkExternalExtension::AddInstances(int delta) {
+  base::AutoLock l(usage_lock_);
+  usage_.live_instances += delta;
+}
+
+void XWalkExternalExtension::AddCallbackTime(base::TimeDelta time) {
+  base::AutoLock l(usage_lock_);
+  usage_.callbacks++;
+  usage_.callback_time += time;
+}
+
+void XWalkExternalExtension::AddAllocatedBytes(size_t bytes) {
+  base::AutoLock l(usage_lock_);
+  usage_.bytes_allocated += bytes;
+}
+
 XWalkExtensionInstance* XWalkExternalExtension::CreateInstance() {
   XW_Instance xw_instance =
       XWalkExternalAdapter::GetInstance()->GetNextXWInstance();
@@ -115,6 +140,22 @@ void XWalkExternalExtension::SyncMessagingRegister(
   handle_sync_msg_callback_ = callback;
 }
 
+void XWalkExternalExtension::StreamRegisterWritable(
+    XW_HandleStreamWritableCallback callback) {
+  RETURN_IF_INITIALIZED("RegisterWritable from Internal_StreamInterface");
+  handle_stream_writable_callback_ = callback;
+}
+
+void XWalkExternalExtension::InstancePoolSetInstancesPoolable() {
+  RETURN_IF_INITIALIZED("SetInstancesPoolable from Internal_InstancePool");
+  set_poolable(true);
+}
+
+void XWalkExternalExtension::ThreadingSetInstancesThreadSafe() {
+  RETURN_IF_INITIALIZED("SetInstancesThreadSafe from Internal_Threading");
+  set_thread_safe(true);
+}
+
 void XWalkExternalExtension::EntryPointsSetExtraJSEntryPoints(
     const char** entry_points) {
   RETURN_IF_INITIALIZED("SetExtraJSEntryPoints from EntryPoints");
@@ -7,8 +7,12 @@
 
 #include <string>
 #include "base/scoped_native_library.h"
+#include "base/synchronization/lock.h"
+#include "base/time/time.h"
 #include "xwalk/extensions/common/xwalk_extension.h"
+#include "xwalk/extensions/common/xwalk_extension_metrics.h"
 #include "xwalk/extensions/public/XW_Extension.h"
+#include "xwalk/extensions/public/XW_Extension_Stream.h"
 #include "xwalk/extensions/public/XW_Extension_SyncMessage.h"
 
 namespace base {
@@ -32,14 +36,18 @@ class XWalkExternalExtension : public XWalkExtension {
  public:
   explicit XWalkExternalExtension(const base::FilePath& path);
 
-  virtual ~XWalkExternalExtension();
-
   bool is_valid();
 
+  // Returns the resources used by this extension so far. It can be called
+  // from any thread.
+  XWalkExtensionUsage GetUsage();
+
  private:
   friend class XWalkExternalAdapter;
   friend class XWalkExternalInstance;
 
+  virtual ~XWalkExternalExtension();
+
   // XWalkExtension implementation.
   virtual XWalkExtensionInstance* CreateInstance() OVERRIDE;
 
@@ -58,6 +66,23 @@ class XWalkExternalExtension : public XWalkExtension {
   // XW_Internal_SyncMessagingInterface_1 (from XW_Extension.h) implementation.
   void SyncMessagingRegister(XW_HandleSyncMessageCallback callback);
 
+  // XW_Internal_InstancePoolInterface_1 (from XW_Extension_InstancePool.h)
+  // implementation.
+  void InstancePoolSetInstancesPoolable();
+
+  // XW_Internal_ThreadingInterface_1 (from XW_Extension_Threading.h)
+  // implementation.
+  void ThreadingSetInstancesThreadSafe();
+
+  // XW_Internal_StreamInterface_1 (from XW_Extension_Stream.h)
+  // implementation.
+  void StreamRegisterWritable(XW_HandleStreamWritableCallback callback);
+
+  // Used by XWalkExternalInstance to account the work done by the extension.
+  void AddInstances(int delta);
+  void AddCallbackTime(base::TimeDelta time);
+  void AddAllocatedBytes(size_t bytes);
+
   base::ScopedNativeLibrary library_;
   XW_Extension xw_extension_;
 
@@ -66,9 +91,14 @@ class XWalkExternalExtension : public XWalkExtension {
   XW_ShutdownCallback shutdown_callback_;
   XW_HandleMessageCallback handle_msg_callback_;
   XW_HandleSyncMessageCallback handle_sync_msg_callback_;
+  XW_HandleStreamWritableCallback handle_stream_writable_callback_;
 
   bool initialized_;
 
+  // Protects |usage_|, since instances may run in different threads.
+  base::Lock usage_lock_;
+  XWalkExtensionUsage usage_;
+
   DISALLOW_COPY_AND_ASSIGN(XWalkExternalExtension);
 };
 
@@ -4,6 +4,8 @@
 
 #include "xwalk/extensions/common/xwalk_external_instance.h"
 
+#include <string.h>
+
 #include <string>
 #include "base/logging.h"
 #include "xwalk/extensions/common/xwalk_external_extension.h"
@@ -12,6 +14,34 @@
 namespace xwalk {
 namespace extensions {
 
+namespace {
+
+base::TimeTicks CallbackClockNow() {
+  if (base::TimeTicks::IsThreadNowSupported())
+    return base::TimeTicks::ThreadNow();
+  return base::TimeTicks::Now();
+}
+
+}  // namespace
+
+// Accounts the time the current thread spends in a callback of the extension.
+class XWalkExternalInstance::ScopedCallbackTimer {
+ public:
+  explicit ScopedCallbackTimer(XWalkExternalExtension* extension)
+      : extension_(extension),
+        start_(CallbackClockNow()) {}
+
+  ~ScopedCallbackTimer() {
+    extension_->AddCallbackTime(CallbackClockNow() - start_);
+  }
+
+ private:
+  XWalkExternalExtension* extension_;
+  base::TimeTicks start_;
+
+  DISALLOW_COPY_AND_ASSIGN(ScopedCallbackTimer);
+};
+
 XWalkExternalInstance::XWalkExternalInstance(
     XWalkExternalExtension* extension, XW_Instance xw_instance)
     : xw_instance_(xw_instance),
@@ -19,16 +49,22 @@ XWalkExternalInstance::XWalkExternalInstance(
       instance_data_(NULL),
       is_handling_sync_msg_(false) {
   XWalkExternalAdapter::GetInstance()->RegisterInstance(this);
+  extension_->AddInstances(1);
   XW_CreatedInstanceCallback callback = extension_->created_instance_callback_;
-  if (callback)
+  if (callback) {
+    ScopedCallbackTimer timer(extension_);
     callback(xw_instance_);
+  }
 }
 
 XWalkExternalInstance::~XWalkExternalInstance() {
   XW_DestroyedInstanceCallback callback =
       extension_->destroyed_instance_callback_;
-  if (callback)
+  if (callback) {
+    ScopedCallbackTimer timer(extension_);
     callback(xw_instance_);
+  }
+  extension_->AddInstances(-1);
   XWalkExternalAdapter::GetInstance()->UnregisterInstance(this);
 }
 
@@ -42,6 +78,8 @@ void XWalkExternalInstance::HandleMessage(scoped_ptr<base::Value> msg) {
 
   std::string string_msg;
   msg->GetAsString(&string_msg);
+
+  ScopedCallbackTimer timer(extension_);
   callback(xw_instance_, string_msg.c_str());
 }
 
@@ -56,9 +94,19 @@ void XWalkExternalInstance::HandleSyncMessage(scoped_ptr<base::Value> msg) {
   std::string string_msg;
   msg->GetAsString(&string_msg);
 
+  ScopedCallbackTimer timer(extension_);
   callback(xw_instance_, string_msg.c_str());
 }
 
+void XWalkExternalInstance::HandleStreamWritable(int stream_id) {
+  XW_HandleStreamWritableCallback callback =
+      extension_->handle_stream_writable_callback_;
+  if (callback) {
+    ScopedCallbackTimer timer(extension_);
+    callback(xw_instance_, stream_id);
+  }
+}
+
 void XWalkExternalInstance::CoreSetInstanceData(void* data) {
   instance_data_ = data;
 }
@@ -68,12 +116,30 @@ void* XWalkExternalInstance::CoreGetInstanceData() {
 }
 
 void XWalkExternalInstance::MessagingPostMessage(const char* msg) {
+  extension_->AddAllocatedBytes(strlen(msg));
   PostMessageToJS(scoped_ptr<base::Value>(new base::StringValue(msg)));
 }
 
 void XWalkExternalInstance::SyncMessagingSetSyncReply(const char* reply) {
+  extension_->AddAllocatedBytes(strlen(reply));
   SendSyncReplyToJS(scoped_ptr<base::Value>(new base::StringValue(reply)));
 }
 
+int32_t XWalkExternalInstance::StreamWriteChunk(int32_t stream_id,
+                                                const char* data, size_t size,
+                                                int32_t last) {
+  if (!data && size) {
+    LOG(WARNING) << "Ignoring stream chunk without data from external "
+                 << "extension '" << extension_->name() << "'.";
+    return 0;
+  }
+
+  std::string chunk;
+  if (data)
+    chunk.assign(data, size);
+  extension_->AddAllocatedBytes(size);
+  return WriteStreamChunkToJS(stream_id, chunk, last != 0);
+}
+
 }  // namespace extensions
 }  // namespace xwalk
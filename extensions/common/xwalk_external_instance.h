@@ -32,9 +32,12 @@ class XWalkExternalInstance : public XWalkExtensionInstance {
  private:
   friend class XWalkExternalAdapter;
 
+  class ScopedCallbackTimer;
+
   // XWalkExtensionInstance implementation.
   virtual void HandleMessage(scoped_ptr<base::Value> msg) OVERRIDE;
   virtual void HandleSyncMessage(scoped_ptr<base::Value> msg) OVERRIDE;
+  virtual void HandleStreamWritable(int stream_id) OVERRIDE;
 
   // XW_CoreInterface_1 (from XW_Extension.h) implementation.
   void CoreSetInstanceData(void* data);
@@ -47,6 +50,11 @@ class XWalkExternalInstance : public XWalkExtensionInstance {
   // implementation.
   void SyncMessagingSetSyncReply(const char* reply);
 
+  // XW_Internal_StreamInterface_1 (from XW_Extension_Stream.h)
+  // implementation.
+  int32_t StreamWriteChunk(int32_t stream_id, const char* data, size_t size,
+                           int32_t last);
+
   XW_Instance xw_instance_;
   std::string sync_reply_;
   XWalkExternalExtension* extension_;
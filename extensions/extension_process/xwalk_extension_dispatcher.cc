@@ -0,0 +1,143 @@
+// Copyright (c) 2013 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "xwalk/extensions/extension_process/xwalk_extension_dispatcher.h"
+
+#include <algorithm>
+#include <string>
+
+#include "base/bind.h"
+#include "base/command_line.h"
+#include "base/strings/string_number_conversions.h"
+#include "base/strings/stringprintf.h"
+#include "ipc/ipc_sync_message.h"
+#include "xwalk/extensions/common/xwalk_extension_messages.h"
+#include "xwalk/extensions/common/xwalk_extension_server.h"
+#include "xwalk/extensions/common/xwalk_extension_switches.h"
+
+namespace xwalk {
+namespace extensions {
+
+namespace {
+
+// More threads than this would mostly add contention, since the extension
+// process usually serves a single render process.
+const int kMaxDispatchThreads = 8;
+
+// Every message from XWalkExtensionClient starts with the instance id.
+bool ReadInstanceId(const IPC::Message& message, int64* instance_id) {
+  PickleIterator iter = message.is_sync() ?
+      IPC::SyncMessage::GetDataIterator(&message) : PickleIterator(message);
+  return iter.ReadInt64(instance_id);
+}
+
+}  // namespace
+
+XWalkExtensionDispatcher::XWalkExtensionDispatcher(
+    XWalkExtensionServer* server, int thread_count)
+    : server_(server),
+      next_extension_thread_(0) {
+  DCHECK_GT(thread_count, 0);
+  for (int i = 0; i < thread_count; ++i) {
+    base::Thread* thread = new base::Thread(
+        base::StringPrintf("XWalkExtensionDispatcher_%d", i));
+    thread->Start();
+    threads_.push_back(thread);
+  }
+}
+
+XWalkExtensionDispatcher::~XWalkExtensionDispatcher() {
+  Stop();
+}
+
+void XWalkExtensionDispatcher::Stop() {
+  {
+    base::AutoLock l(lock_);
+    server_ = NULL;
+  }
+
+  // Stopping the threads outside the lock, otherwise the IO-thread would be
+  // blocked until the messages being handled are done.
+  for (size_t i = 0; i < threads_.size(); ++i)
+    threads_[i]->Stop();
+}
+
+// static
+int XWalkExtensionDispatcher::GetThreadCountFromCommandLine() {
+  const CommandLine* cmd_line = CommandLine::ForCurrentProcess();
+  if (!cmd_line->HasSwitch(switches::kXWalkExtensionDispatchThreads))
+    return 0;
+
+  std::string value = cmd_line->GetSwitchValueASCII(
+      switches::kXWalkExtensionDispatchThreads);
+  int thread_count;
+  if (!base::StringToInt(value, &thread_count) || thread_count < 0) {
+    LOG(WARNING) << "Invalid value for --"
+                 << switches::kXWalkExtensionDispatchThreads << ": " << value;
+    return 0;
+  }
+  return std::min(thread_count, kMaxDispatchThreads);
+}
+
+bool XWalkExtensionDispatcher::OnMessageReceived(
+    const IPC::Message& message) {
+  if (IPC_MESSAGE_CLASS(message) != XWalkExtensionClientServerMsgStart)
+    return false;
+
+  int64 instance_id = 0;
+  if (!ReadInstanceId(message, &instance_id))
+    LOG(WARNING) << "Dispatching message without instance id.";
+
+  base::AutoLock l(lock_);
+  // After Stop() the messages are dropped instead of reaching the server in
+  // the main thread, since it is being destroyed.
+  if (!server_)
+    return true;
+
+  size_t index = GetThreadIndexForInstance(instance_id, message);
+  threads_[index]->message_loop()->PostTask(
+      FROM_HERE,
+      base::Bind(
+          base::IgnoreResult(&XWalkExtensionServer::OnQueuedMessageReceived),
+          base::Unretained(server_), base::TimeTicks::Now(), message));
+
+  if (message.type() == XWalkExtensionServerMsg_DestroyInstance::ID)
+    instance_threads_.erase(instance_id);
+  return true;
+}
+
+size_t XWalkExtensionDispatcher::GetThreadIndexForInstance(
+    int64_t instance_id, const IPC::Message& message) {
+  std::map<int64_t, size_t>::const_iterator it =
+      instance_threads_.find(instance_id);
+  if (it != instance_threads_.end())
+    return it->second;
+
+  // Instance ids are assigned sequentially by the client, so this spreads the
+  // instances of thread-safe extensions evenly. It's also used for messages
+  // of unknown instances, which the server rejects.
+  size_t index = static_cast<uint64_t>(instance_id) % threads_.size();
+
+  XWalkExtensionServerMsg_CreateInstance::Param param;
+  if (message.type() != XWalkExtensionServerMsg_CreateInstance::ID ||
+      !XWalkExtensionServerMsg_CreateInstance::Read(&message, &param))
+    return index;
+
+  const std::string& name = param.b;
+  if (!server_->IsExtensionThreadSafe(name)) {
+    std::map<std::string, size_t>::const_iterator extension_it =
+        extension_threads_.find(name);
+    if (extension_it != extension_threads_.end()) {
+      index = extension_it->second;
+    } else {
+      index = next_extension_thread_++ % threads_.size();
+      extension_threads_[name] = index;
+    }
+  }
+  instance_threads_[instance_id] = index;
+  return index;
+}
+
+}  // namespace extensions
+}  // namespace xwalk
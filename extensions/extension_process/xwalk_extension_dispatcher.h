@@ -0,0 +1,73 @@
+// Copyright (c) 2013 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef XWALK_EXTENSIONS_EXTENSION_PROCESS_XWALK_EXTENSION_DISPATCHER_H_
+#define XWALK_EXTENSIONS_EXTENSION_PROCESS_XWALK_EXTENSION_DISPATCHER_H_
+
+#include <stdint.h>
+
+#include <map>
+#include <string>
+
+#include "base/memory/scoped_vector.h"
+#include "base/synchronization/lock.h"
+#include "base/threading/thread.h"
+#include "ipc/ipc_channel_proxy.h"
+
+namespace xwalk {
+namespace extensions {
+
+class XWalkExtensionServer;
+
+// Intercepts the messages destined to a XWalkExtensionServer and dispatches
+// them in a small pool of threads, so instances of independent extensions
+// can be busy at the same time. All the messages of an instance are handled
+// by the same thread, in the order they arrived. The instances of an
+// extension all run in the same thread, unless the extension is thread-safe,
+// see XWalkExtension::is_thread_safe(). Like other filters, this filter runs
+// in the IO-thread.
+class XWalkExtensionDispatcher : public IPC::ChannelProxy::MessageFilter {
+ public:
+  XWalkExtensionDispatcher(XWalkExtensionServer* server, int thread_count);
+
+  // Drops the messages received from now on and joins the dispatch threads.
+  // The messages already posted to the threads are handled before they exit.
+  // Must be called before the server is destroyed.
+  void Stop();
+
+  // Returns the number of dispatch threads requested in the command line, or
+  // zero if messages should be handled in the main thread of the process.
+  static int GetThreadCountFromCommandLine();
+
+ private:
+  virtual ~XWalkExtensionDispatcher();
+
+  // IPC::ChannelProxy::MessageFilter implementation.
+  virtual bool OnMessageReceived(const IPC::Message& message) OVERRIDE;
+
+  // Returns the index in |threads_| of the thread handling the messages of
+  // |instance_id|, assigning one if |message| creates the instance. Must be
+  // called with |lock_| held.
+  size_t GetThreadIndexForInstance(int64_t instance_id,
+                                   const IPC::Message& message);
+
+  // This lock is used to protect access to filter members.
+  base::Lock lock_;
+
+  XWalkExtensionServer* server_;
+  ScopedVector<base::Thread> threads_;
+
+  // The thread of each live instance.
+  std::map<int64_t, size_t> instance_threads_;
+  // The thread of the instances of each extension which isn't thread-safe.
+  std::map<std::string, size_t> extension_threads_;
+  size_t next_extension_thread_;
+
+  DISALLOW_COPY_AND_ASSIGN(XWalkExtensionDispatcher);
+};
+
+}  // namespace extensions
+}  // namespace xwalk
+
+#endif  // XWALK_EXTENSIONS_EXTENSION_PROCESS_XWALK_EXTENSION_DISPATCHER_H_
@@ -0,0 +1,194 @@
+// Copyright (c) 2013 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "xwalk/extensions/extension_process/xwalk_extension_dispatcher.h"
+
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "base/memory/ref_counted.h"
+#include "base/synchronization/lock.h"
+#include "base/threading/platform_thread.h"
+#include "ipc/ipc_sender.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "xwalk/extensions/common/xwalk_extension.h"
+#include "xwalk/extensions/common/xwalk_extension_messages.h"
+#include "xwalk/extensions/common/xwalk_extension_server.h"
+
+using xwalk::extensions::XWalkExtension;
+using xwalk::extensions::XWalkExtensionDispatcher;
+using xwalk::extensions::XWalkExtensionInstance;
+using xwalk::extensions::XWalkExtensionServer;
+
+namespace {
+
+class NullSender : public IPC::Sender {
+ public:
+  virtual bool Send(IPC::Message* msg) OVERRIDE {
+    delete msg;
+    return true;
+  }
+};
+
+// Records the messages received by each instance, and the threads they were
+// handled in.
+class MessageLog {
+ public:
+  void Add(int instance_number, int value) {
+    base::AutoLock l(lock_);
+    values_[instance_number].push_back(value);
+    threads_[instance_number].insert(base::PlatformThread::CurrentId());
+  }
+
+  std::vector<int> values(int instance_number) {
+    base::AutoLock l(lock_);
+    return values_[instance_number];
+  }
+
+  std::set<base::PlatformThreadId> threads(int instance_number) {
+    base::AutoLock l(lock_);
+    return threads_[instance_number];
+  }
+
+ private:
+  base::Lock lock_;
+  std::map<int, std::vector<int> > values_;
+  std::map<int, std::set<base::PlatformThreadId> > threads_;
+};
+
+// Each message is a list with the instance number and a value.
+class LoggingInstance : public XWalkExtensionInstance {
+ public:
+  explicit LoggingInstance(MessageLog* log) : log_(log) {}
+
+  virtual void HandleMessage(scoped_ptr<base::Value> msg) OVERRIDE {
+    base::ListValue* list;
+    int instance_number;
+    int value;
+    ASSERT_TRUE(msg->GetAsList(&list));
+    ASSERT_TRUE(list->GetInteger(0, &instance_number));
+    ASSERT_TRUE(list->GetInteger(1, &value));
+    log_->Add(instance_number, value);
+  }
+
+ private:
+  MessageLog* log_;
+};
+
+class LoggingExtension : public XWalkExtension {
+ public:
+  LoggingExtension(const std::string& name, bool thread_safe, MessageLog* log)
+      : log_(log) {
+    set_name(name);
+    set_thread_safe(thread_safe);
+  }
+
+  virtual XWalkExtensionInstance* CreateInstance() OVERRIDE {
+    return new LoggingInstance(log_);
+  }
+
+ private:
+  MessageLog* log_;
+};
+
+const int kThreadCount = 4;
+const int kInstancesPerExtension = 4;
+const int kMessagesPerInstance = 200;
+
+}  // namespace
+
+TEST(XWalkExtensionDispatcherTest, InstanceMessagesAreHandledInOrder) {
+  NullSender sender;
+  MessageLog log;
+  XWalkExtensionServer server;
+  server.Initialize(&sender);
+  ASSERT_TRUE(server.RegisterExtension(make_scoped_refptr(
+      new LoggingExtension("safe", true, &log))));
+  ASSERT_TRUE(server.RegisterExtension(make_scoped_refptr(
+      new LoggingExtension("unsafe", false, &log))));
+
+  scoped_refptr<XWalkExtensionDispatcher> dispatcher(
+      new XWalkExtensionDispatcher(&server, kThreadCount));
+  IPC::ChannelProxy::MessageFilter* filter = dispatcher.get();
+
+  // Instances 0 to 3 are of the thread-safe extension, 4 to 7 of the other.
+  const int instance_count = 2 * kInstancesPerExtension;
+  for (int i = 0; i < instance_count; ++i) {
+    EXPECT_TRUE(filter->OnMessageReceived(
+        XWalkExtensionServerMsg_CreateInstance(
+            i, i < kInstancesPerExtension ? "safe" : "unsafe")));
+  }
+
+  // The messages of the instances are interleaved, as they come from the
+  // client.
+  for (int value = 0; value < kMessagesPerInstance; ++value) {
+    for (int i = 0; i < instance_count; ++i) {
+      base::ListValue msg;
+      base::ListValue* contents = new base::ListValue;
+      contents->AppendInteger(i);
+      contents->AppendInteger(value);
+      msg.Append(contents);
+      EXPECT_TRUE(filter->OnMessageReceived(
+          XWalkExtensionServerMsg_PostMessageToNative(i, msg)));
+    }
+  }
+
+  for (int i = 0; i < instance_count; ++i) {
+    EXPECT_TRUE(filter->OnMessageReceived(
+        XWalkExtensionServerMsg_DestroyInstance(i)));
+  }
+
+  // Waits for the messages already posted to be handled.
+  dispatcher->Stop();
+
+  std::set<base::PlatformThreadId> safe_threads;
+  std::set<base::PlatformThreadId> unsafe_threads;
+  for (int i = 0; i < instance_count; ++i) {
+    std::vector<int> values = log.values(i);
+    ASSERT_EQ(static_cast<size_t>(kMessagesPerInstance), values.size());
+    for (int value = 0; value < kMessagesPerInstance; ++value)
+      EXPECT_EQ(value, values[value]) << "Instance " << i;
+
+    std::set<base::PlatformThreadId> threads = log.threads(i);
+    ASSERT_EQ(1u, threads.size()) << "Instance " << i;
+    if (i < kInstancesPerExtension)
+      safe_threads.insert(*threads.begin());
+    else
+      unsafe_threads.insert(*threads.begin());
+  }
+
+  // The instances of the thread-safe extension are spread over the threads,
+  // the others share one.
+  EXPECT_EQ(static_cast<size_t>(kThreadCount), safe_threads.size());
+  EXPECT_EQ(1u, unsafe_threads.size());
+}
+
+TEST(XWalkExtensionDispatcherTest, MessagesAreDroppedAfterStop) {
+  NullSender sender;
+  MessageLog log;
+  XWalkExtensionServer server;
+  server.Initialize(&sender);
+  ASSERT_TRUE(server.RegisterExtension(make_scoped_refptr(
+      new LoggingExtension("safe", true, &log))));
+
+  scoped_refptr<XWalkExtensionDispatcher> dispatcher(
+      new XWalkExtensionDispatcher(&server, kThreadCount));
+  IPC::ChannelProxy::MessageFilter* filter = dispatcher.get();
+  EXPECT_TRUE(filter->OnMessageReceived(
+      XWalkExtensionServerMsg_CreateInstance(1, "safe")));
+  dispatcher->Stop();
+
+  base::ListValue msg;
+  base::ListValue* contents = new base::ListValue;
+  contents->AppendInteger(1);
+  contents->AppendInteger(0);
+  msg.Append(contents);
+  // Still handled by the filter, so it doesn't reach the server in the main
+  // thread.
+  EXPECT_TRUE(filter->OnMessageReceived(
+      XWalkExtensionServerMsg_PostMessageToNative(1, msg)));
+  EXPECT_TRUE(log.values(1).empty());
+}
@@ -5,6 +5,7 @@
 #include "xwalk/extensions/extension_process/xwalk_extension_process.h"
 
 #include <string>
+#include <vector>
 
 #include "base/command_line.h"
 #include "base/files/file_path.h"
@@ -13,10 +14,18 @@
 #include "ipc/ipc_message_macros.h"
 #include "ipc/ipc_sync_channel.h"
 #include "xwalk/extensions/common/xwalk_extension_messages.h"
+#include "xwalk/extensions/common/xwalk_external_adapter.h"
+#include "xwalk/extensions/extension_process/xwalk_extension_dispatcher.h"
 
 namespace xwalk {
 namespace extensions {
 
+namespace {
+
+const int kUsageReportIntervalInSeconds = 10;
+
+}  // namespace
+
 XWalkExtensionProcess::XWalkExtensionProcess()
     : shutdown_event_(false, false),
       io_thread_("XWalkExtensionProcess_IOThread") {
@@ -28,8 +37,12 @@ XWalkExtensionProcess::XWalkExtensionProcess()
 }
 
 XWalkExtensionProcess::~XWalkExtensionProcess() {
+  usage_report_timer_.Stop();
+
   // FIXME(jeez): Move this to OnChannelClosing/Error/Disconnected when we have
   // our MessageFilter set.
+  if (dispatcher_)
+    dispatcher_->Stop();
   extensions_server_.Invalidate();
 
   shutdown_event_.Signal();
@@ -49,6 +62,22 @@ bool XWalkExtensionProcess::OnMessageReceived(const IPC::Message& message) {
 void XWalkExtensionProcess::OnRegisterExtensions(
     const base::FilePath& path) {
   RegisterExternalExtensionsInDirectory(&extensions_server_, path);
+
+  if (!usage_report_timer_.IsRunning()) {
+    usage_report_timer_.Start(
+        FROM_HERE, base::TimeDelta::FromSeconds(kUsageReportIntervalInSeconds),
+        this, &XWalkExtensionProcess::ReportExtensionsUsage);
+  }
+}
+
+void XWalkExtensionProcess::ReportExtensionsUsage() {
+  std::vector<XWalkExtensionUsage> usage;
+  XWalkExternalAdapter::GetInstance()->GetExtensionsUsage(&usage);
+  if (usage.empty())
+    return;
+
+  browser_process_channel_->Send(
+      new XWalkExtensionProcessHostMsg_ExtensionsUsage(usage));
 }
 
 void XWalkExtensionProcess::CreateBrowserProcessChannel() {
@@ -80,6 +109,14 @@ void XWalkExtensionProcess::CreateRenderProcessChannel() {
 
   extensions_server_.Initialize(render_process_channel_.get());
 
+  int dispatch_threads =
+      XWalkExtensionDispatcher::GetThreadCountFromCommandLine();
+  if (dispatch_threads > 0) {
+    dispatcher_ = new XWalkExtensionDispatcher(&extensions_server_,
+                                               dispatch_threads);
+    render_process_channel_->AddFilter(dispatcher_.get());
+  }
+
   browser_process_channel_->Send(
       new XWalkExtensionProcessHostMsg_RenderProcessChannelCreated(
           rp_channel_handle_));
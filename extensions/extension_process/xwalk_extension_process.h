@@ -5,9 +5,11 @@
 #ifndef XWALK_EXTENSIONS_EXTENSION_PROCESS_XWALK_EXTENSION_PROCESS_H_
 #define XWALK_EXTENSIONS_EXTENSION_PROCESS_XWALK_EXTENSION_PROCESS_H_
 
+#include "base/memory/ref_counted.h"
 #include "base/values.h"
 #include "base/synchronization/waitable_event.h"
 #include "base/threading/thread.h"
+#include "base/timer/timer.h"
 #include "ipc/ipc_channel_handle.h"
 #include "ipc/ipc_listener.h"
 #include "xwalk/extensions/common/xwalk_extension_server.h"
@@ -24,6 +26,7 @@ namespace xwalk {
 namespace extensions {
 
 class XWalkExtension;
+class XWalkExtensionDispatcher;
 class XWalkExtensionRunner;
 
 
@@ -45,6 +48,10 @@ class XWalkExtensionProcess : public IPC::Listener {
   // Handlers for IPC messages from XWalkExtensionProcessHost.
   void OnRegisterExtensions(const base::FilePath& extension_path);
 
+  // Reports the resources used by each external extension to the Browser
+  // Process, so heavy extensions can be told apart in a shared process.
+  void ReportExtensionsUsage();
+
   void CreateBrowserProcessChannel();
   void CreateRenderProcessChannel();
 
@@ -55,6 +62,12 @@ class XWalkExtensionProcess : public IPC::Listener {
   scoped_ptr<IPC::SyncChannel> render_process_channel_;
   IPC::ChannelHandle rp_channel_handle_;
 
+  // Set when the messages from the render process are handled in a pool of
+  // threads instead of the main thread, see kXWalkExtensionDispatchThreads.
+  scoped_refptr<XWalkExtensionDispatcher> dispatcher_;
+
+  base::RepeatingTimer<XWalkExtensionProcess> usage_report_timer_;
+
   DISALLOW_COPY_AND_ASSIGN(XWalkExtensionProcess);
 };
 
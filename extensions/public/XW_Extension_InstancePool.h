@@ -0,0 +1,46 @@
+// Copyright (c) 2013 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef XWALK_EXTENSIONS_PUBLIC_XW_EXTENSION_INSTANCEPOOL_H_
+#define XWALK_EXTENSIONS_PUBLIC_XW_EXTENSION_INSTANCEPOOL_H_
+
+// NOTE: This file and interfaces marked as internal are not considered stable
+// and can be modified in incompatible ways between Crosswalk versions.
+
+#ifndef XWALK_EXTENSIONS_PUBLIC_XW_EXTENSION_H_
+#error "You should include XW_Extension.h before this file"
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define XW_INTERNAL_INSTANCE_POOL_INTERFACE_1 \
+  "XW_Internal_InstancePoolInterface_1"
+#define XW_INTERNAL_INSTANCE_POOL_INTERFACE \
+  XW_INTERNAL_INSTANCE_POOL_INTERFACE_1
+
+//
+// XW_INTERNAL_INSTANCE_POOL_INTERFACE: allow extensions whose instances keep
+// no per-context state to have them reused. When the context of such instance
+// goes away, the instance may be kept alive and later handed to another
+// context instead of being destroyed. Its XW_Instance and instance data are
+// preserved, and the created/destroyed callbacks are not called on reuse.
+//
+
+struct XW_Internal_InstancePoolInterface_1 {
+  // Mark the instances of this extension as poolable.
+  //
+  // This function should be called only during XW_Initialize().
+  void (*SetInstancesPoolable)(XW_Extension extension);
+};
+
+typedef struct XW_Internal_InstancePoolInterface_1
+    XW_Internal_InstancePoolInterface;
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif
+
+#endif  // XWALK_EXTENSIONS_PUBLIC_XW_EXTENSION_INSTANCEPOOL_H_
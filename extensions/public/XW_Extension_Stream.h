@@ -0,0 +1,65 @@
+// Copyright (c) 2013 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef XWALK_EXTENSIONS_PUBLIC_XW_EXTENSION_STREAM_H_
+#define XWALK_EXTENSIONS_PUBLIC_XW_EXTENSION_STREAM_H_
+
+// NOTE: This file and interfaces marked as internal are not considered stable
+// and can be modified in incompatible ways between Crosswalk versions.
+
+#ifndef XWALK_EXTENSIONS_PUBLIC_XW_EXTENSION_H_
+#error "You should include XW_Extension.h before this file"
+#endif
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//
+// XW_INTERNAL_STREAM_INTERFACE: allow extension code to send large payloads
+// to JavaScript as a sequence of ordered chunks, instead of a single message.
+// JavaScript code receives the chunks by registering a listener with
+// extension.setStreamListener(function(streamId, chunk, last) {}), where
+// chunk is an ArrayBuffer.
+//
+// Only a few chunks of each stream can be pending consumption by JavaScript.
+// When WriteChunk refuses a chunk, the extension should keep it and try again
+// after the stream writable callback is called for that stream.
+//
+
+#define XW_INTERNAL_STREAM_INTERFACE_1 \
+  "XW_Internal_StreamInterface_1"
+#define XW_INTERNAL_STREAM_INTERFACE \
+  XW_INTERNAL_STREAM_INTERFACE_1
+
+typedef void (*XW_HandleStreamWritableCallback)(XW_Instance instance,
+                                                int32_t stream_id);
+
+struct XW_Internal_StreamInterface_1 {
+  // Register the callback called when a stream that refused a chunk is able
+  // to accept chunks again.
+  //
+  // This function should be called only during XW_Initialize().
+  void (*RegisterWritable)(XW_Extension extension,
+                           XW_HandleStreamWritableCallback handle_writable);
+
+  // Write |size| bytes from |data| as the next chunk of |stream_id|. Stream
+  // ids are chosen by the extension and are scoped to the instance. A non-zero
+  // |last| closes the stream. Returns non-zero if the chunk was accepted.
+  //
+  // This function should be called from the thread handling messages.
+  int32_t (*WriteChunk)(XW_Instance instance, int32_t stream_id,
+                        const char* data, size_t size, int32_t last);
+};
+
+typedef struct XW_Internal_StreamInterface_1
+    XW_Internal_StreamInterface;
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif
+
+#endif  // XWALK_EXTENSIONS_PUBLIC_XW_EXTENSION_STREAM_H_
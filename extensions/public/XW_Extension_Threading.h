@@ -0,0 +1,46 @@
+// Copyright (c) 2013 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef XWALK_EXTENSIONS_PUBLIC_XW_EXTENSION_THREADING_H_
+#define XWALK_EXTENSIONS_PUBLIC_XW_EXTENSION_THREADING_H_
+
+// NOTE: This file and interfaces marked as internal are not considered stable
+// and can be modified in incompatible ways between Crosswalk versions.
+
+#ifndef XWALK_EXTENSIONS_PUBLIC_XW_EXTENSION_H_
+#error "You should include XW_Extension.h before this file"
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define XW_INTERNAL_THREADING_INTERFACE_1 \
+  "XW_Internal_ThreadingInterface_1"
+#define XW_INTERNAL_THREADING_INTERFACE \
+  XW_INTERNAL_THREADING_INTERFACE_1
+
+//
+// XW_INTERNAL_THREADING_INTERFACE: allow extensions whose code is thread-safe
+// to have different instances handle messages at the same time, in different
+// threads. The messages of each instance are still handled in sequence, by a
+// single thread. By default all the instances of an extension handle their
+// messages in the same thread.
+//
+
+struct XW_Internal_ThreadingInterface_1 {
+  // Mark the instances of this extension as safe to run in parallel.
+  //
+  // This function should be called only during XW_Initialize().
+  void (*SetInstancesThreadSafe)(XW_Extension extension);
+};
+
+typedef struct XW_Internal_ThreadingInterface_1
+    XW_Internal_ThreadingInterface;
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif
+
+#endif  // XWALK_EXTENSIONS_PUBLIC_XW_EXTENSION_THREADING_H_
@@ -4,6 +4,7 @@
 
 #include "xwalk/extensions/renderer/xwalk_extension_client.h"
 
+#include "base/debug/trace_event.h"
 #include "base/values.h"
 #include "base/stl_util.h"
 #include "ipc/ipc_sender.h"
@@ -44,6 +45,8 @@ bool XWalkExtensionClient::OnMessageReceived(const IPC::Message& message) {
   IPC_BEGIN_MESSAGE_MAP(XWalkExtensionClient, message)
     IPC_MESSAGE_HANDLER(XWalkExtensionClientMsg_PostMessageToJS,
         OnPostMessageToJS)
+    IPC_MESSAGE_HANDLER(XWalkExtensionClientMsg_PostStreamChunkToJS,
+        OnPostStreamChunkToJS)
     IPC_MESSAGE_HANDLER(XWalkExtensionClientMsg_RegisterExtension,
         OnRegisterExtension)
     IPC_MESSAGE_HANDLER(XWalkExtensionClientMsg_InstanceDestroyed,
@@ -56,6 +59,8 @@ bool XWalkExtensionClient::OnMessageReceived(const IPC::Message& message) {
 
 void XWalkExtensionClient::OnPostMessageToJS(int64_t instance_id,
                                              const base::ListValue& msg) {
+  TRACE_EVENT1("xwalk", "XWalkExtensionClient::OnPostMessageToJS",
+               "instance", static_cast<int>(instance_id));
   HandlerMap::const_iterator it = handlers_.find(instance_id);
   if (it == handlers_.end()) {
     LOG(WARNING) << "Can't PostMessage to invalid Extension instance id: "
@@ -72,6 +77,30 @@ void XWalkExtensionClient::OnPostMessageToJS(int64_t instance_id,
   it->second->HandleMessageFromNative(*value);
 }
 
+void XWalkExtensionClient::OnPostStreamChunkToJS(int64_t instance_id,
+                                                 int stream_id,
+                                                 const std::string& chunk,
+                                                 bool last) {
+  HandlerMap::const_iterator it = handlers_.find(instance_id);
+  if (it == handlers_.end()) {
+    LOG(WARNING) << "Can't write stream chunk to invalid Extension instance "
+                 << "id: " << instance_id;
+    return;
+  }
+
+  // See comment in DestroyInstance() about two step destruction.
+  if (!it->second)
+    return;
+
+  it->second->HandleStreamChunkFromNative(stream_id, chunk, last);
+
+  // The chunk was handed to JavaScript, so the server can send more. This
+  // acknowledgement is what keeps the amount of data in flight bounded.
+  if (!last)
+    Send(new XWalkExtensionServerMsg_StreamChunkConsumed(instance_id,
+                                                         stream_id));
+}
+
 void XWalkExtensionClient::OnRegisterExtension(
     const std::string& name,
     const std::string& api,
@@ -132,19 +161,26 @@ scoped_ptr<base::ListValue> WrapValueInList(scoped_ptr<base::Value> value) {
 
 void XWalkExtensionClient::PostMessageToNative(int64_t instance_id,
     scoped_ptr<base::Value> msg) {
+  TRACE_EVENT1("xwalk", "XWalkExtensionClient::PostMessageToNative",
+               "instance", static_cast<int>(instance_id));
   scoped_ptr<base::ListValue> list_msg = WrapValueInList(msg.Pass());
   Send(new XWalkExtensionServerMsg_PostMessageToNative(instance_id, *list_msg));
 }
 
 scoped_ptr<base::Value> XWalkExtensionClient::SendSyncMessageToNative(
     int64_t instance_id, scoped_ptr<base::Value> msg) {
+  // Covers the whole round trip, including the time blocked on the reply.
+  TRACE_EVENT1("xwalk", "XWalkExtensionClient::SendSyncMessageToNative",
+               "instance", static_cast<int>(instance_id));
   scoped_ptr<base::ListValue> wrapped_msg = WrapValueInList(msg.Pass());
-  base::ListValue* wrapped_reply = new base::ListValue;
+  base::ListValue wrapped_reply;
   Send(new XWalkExtensionServerMsg_SendSyncMessageToNative(instance_id,
-      *wrapped_msg, wrapped_reply));
+      *wrapped_msg, &wrapped_reply));
 
+  // An empty reply means the server couldn't get an answer from the extension,
+  // e.g. it didn't reply in time. Callers get a NULL value in this case.
   scoped_ptr<base::Value> reply;
-  wrapped_reply->Remove(0, &reply);
+  wrapped_reply.Remove(0, &reply);
   return reply.Pass();
 }
 
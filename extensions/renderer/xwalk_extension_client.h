@@ -35,6 +35,9 @@ class XWalkExtensionClient : public IPC::Listener {
  public:
   struct InstanceHandler {
     virtual void HandleMessageFromNative(const base::Value& msg) = 0;
+    virtual void HandleStreamChunkFromNative(int stream_id,
+                                             const std::string& chunk,
+                                             bool last) = 0;
    protected:
     ~InstanceHandler() {}
   };
@@ -72,6 +75,8 @@ class XWalkExtensionClient : public IPC::Listener {
   // Message Handlers.
   void OnInstanceDestroyed(int64_t instance_id);
   void OnPostMessageToJS(int64_t instance_id, const base::ListValue& msg);
+  void OnPostStreamChunkToJS(int64_t instance_id, int stream_id,
+                             const std::string& chunk, bool last);
   void OnRegisterExtension(const std::string& name, const std::string& api,
                            const base::ListValue& entry_points);
 
@@ -51,6 +51,9 @@ XWalkExtensionModule::XWalkExtensionModule(XWalkExtensionClient* client,
   object_template->Set(
       "setMessageListener",
       v8::FunctionTemplate::New(SetMessageListenerCallback, function_data));
+  object_template->Set(
+      "setStreamListener",
+      v8::FunctionTemplate::New(SetStreamListenerCallback, function_data));
 
   function_data_.Reset(isolate, function_data);
   object_template_.Reset(isolate, object_template);
@@ -76,6 +79,8 @@ XWalkExtensionModule::~XWalkExtensionModule() {
   function_data_.Clear();
   message_listener_.Dispose();
   message_listener_.Clear();
+  stream_listener_.Dispose();
+  stream_listener_.Clear();
 
   if (instance_id_)
     client_->DestroyInstance(instance_id_);
@@ -198,6 +203,34 @@ void XWalkExtensionModule::HandleMessageFromNative(const base::Value& msg) {
         << ExceptionToString(try_catch);
 }
 
+void XWalkExtensionModule::HandleStreamChunkFromNative(
+    int stream_id, const std::string& chunk, bool last) {
+  if (stream_listener_.IsEmpty())
+    return;
+
+  v8::Isolate* isolate = v8::Isolate::GetCurrent();
+  v8::HandleScope handle_scope(isolate);
+  v8::Handle<v8::Context> context = module_system_->GetV8Context();
+  v8::Context::Scope context_scope(context);
+
+  scoped_ptr<base::BinaryValue> binary_chunk(
+      base::BinaryValue::CreateWithCopiedBuffer(chunk.data(), chunk.size()));
+  v8::Handle<v8::Value> args[] = {
+    v8::Integer::New(stream_id),
+    converter_->ToV8Value(binary_chunk.get(), context),
+    v8::Boolean::New(last)
+  };
+  v8::Handle<v8::Function> stream_listener =
+      v8::Handle<v8::Function>::New(isolate, stream_listener_);
+
+  WebKit::WebScopedMicrotaskSuppression suppression;
+  v8::TryCatch try_catch;
+  stream_listener->Call(context->Global(), arraysize(args), args);
+  if (try_catch.HasCaught())
+    LOG(WARNING) << "Exception when running stream listener: "
+        << ExceptionToString(try_catch);
+}
+
 // static
 void XWalkExtensionModule::PostMessageCallback(
     const v8::FunctionCallbackInfo<v8::Value>& info) {
@@ -235,6 +268,15 @@ void XWalkExtensionModule::SendSyncMessageCallback(
   scoped_ptr<base::Value> reply(
       module->client_->SendSyncMessageToNative(module->instance_id_,
                                                value.Pass()));
+
+  // The reply is missing when the extension fails to answer in time. Throw so
+  // the caller doesn't take it for a valid reply.
+  if (!reply) {
+    v8::ThrowException(v8::Exception::Error(v8::String::New(
+        "No reply received from the extension for the sync message.")));
+    return;
+  }
+
   result.Set(module->converter_->ToV8Value(reply.get(), context));
 }
 
@@ -266,6 +308,32 @@ void XWalkExtensionModule::SetMessageListenerCallback(
   result.Set(true);
 }
 
+// static
+void XWalkExtensionModule::SetStreamListenerCallback(
+    const v8::FunctionCallbackInfo<v8::Value>& info) {
+  v8::ReturnValue<v8::Value> result(info.GetReturnValue());
+  XWalkExtensionModule* module = GetExtensionModule(info);
+  if (!module || info.Length() != 1) {
+    result.Set(false);
+    return;
+  }
+
+  if (!info[0]->IsFunction() && !info[0]->IsUndefined()) {
+    LOG(WARNING) << "Trying to set stream listener with invalid value.";
+    result.Set(false);
+    return;
+  }
+
+  v8::Isolate* isolate = info.GetIsolate();
+  module->stream_listener_.Dispose();
+  if (info[0]->IsUndefined())
+    module->stream_listener_.Clear();
+  else
+    module->stream_listener_.Reset(isolate, info[0].As<v8::Function>());
+
+  result.Set(true);
+}
+
 // static
 XWalkExtensionModule* XWalkExtensionModule::GetExtensionModule(
     const v8::FunctionCallbackInfo<v8::Value>& info) {
@@ -47,6 +47,9 @@ class XWalkExtensionModule : public XWalkExtensionClient::InstanceHandler {
  private:
   // XWalkExtensionClient::InstanceHandler implementation.
   virtual void HandleMessageFromNative(const base::Value& msg) OVERRIDE;
+  virtual void HandleStreamChunkFromNative(int stream_id,
+                                           const std::string& chunk,
+                                           bool last) OVERRIDE;
 
   // Callbacks for JS functions available in 'extension' object.
   static void PostMessageCallback(
@@ -55,6 +58,8 @@ class XWalkExtensionModule : public XWalkExtensionClient::InstanceHandler {
       const v8::FunctionCallbackInfo<v8::Value>& info);
   static void SetMessageListenerCallback(
       const v8::FunctionCallbackInfo<v8::Value>& info);
+  static void SetStreamListenerCallback(
+      const v8::FunctionCallbackInfo<v8::Value>& info);
 
   static XWalkExtensionModule* GetExtensionModule(
       const v8::FunctionCallbackInfo<v8::Value>& info);
@@ -70,6 +75,12 @@ class XWalkExtensionModule : public XWalkExtensionClient::InstanceHandler {
   // This value is registered by using 'extension.setMessageListener()'.
   v8::Persistent<v8::Function> message_listener_;
 
+  // Function to be called for each chunk of a stream written by the
+  // extension. It receives the stream id, the chunk as an ArrayBuffer and
+  // whether this is the last chunk. This value is registered by using
+  // 'extension.setStreamListener()'.
+  v8::Persistent<v8::Function> stream_listener_;
+
   std::string extension_name_;
   std::string extension_code_;
 
@@ -95,10 +95,10 @@ class XWalkExtensionsConflictsWithNameTest : public XWalkExtensionsTestBase {
   void RegisterExtensions(XWalkExtensionService* extension_service,
       XWalkExtensionServer* server) OVERRIDE {
     bool registered_clean = server->RegisterExtension(
-        scoped_ptr<XWalkExtension>(new CleanExtension));
+        make_scoped_refptr(new CleanExtension));
     ASSERT_TRUE(registered_clean);
     bool registered_dirty = server->RegisterExtension(
-        scoped_ptr<XWalkExtension>(new ConflictsWithNameExtension));
+        make_scoped_refptr(new ConflictsWithNameExtension));
     ASSERT_FALSE(registered_dirty);
   }
 };
@@ -109,10 +109,10 @@ class XWalkExtensionsConflictsWithEntryPointTest
   void RegisterExtensions(XWalkExtensionService* extension_service,
       XWalkExtensionServer* server) OVERRIDE {
     bool registered_clean = server->RegisterExtension(
-        scoped_ptr<XWalkExtension>(new CleanExtension));
+        make_scoped_refptr(new CleanExtension));
     ASSERT_TRUE(registered_clean);
     bool registered_dirty = server->RegisterExtension(
-        scoped_ptr<XWalkExtension>(new ConflictsWithEntryPointExtension));
+        make_scoped_refptr(new ConflictsWithEntryPointExtension));
     ASSERT_FALSE(registered_dirty);
   }
 };
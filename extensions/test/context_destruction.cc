@@ -80,7 +80,7 @@ class XWalkExtensionsContextDestructionTest : public XWalkExtensionsTestBase {
   void RegisterExtensions(XWalkExtensionService* extension_service,
       XWalkExtensionServer* server) OVERRIDE {
     bool registered = server->RegisterExtension(
-        scoped_ptr<XWalkExtension>(new OnceExtension));
+        make_scoped_refptr(new OnceExtension));
     ASSERT_TRUE(registered);
   }
 
@@ -60,7 +60,7 @@ class XWalkExtensionsIFrameTest : public XWalkExtensionsTestBase {
   void RegisterExtensions(XWalkExtensionService* extension_service,
       XWalkExtensionServer* server) OVERRIDE {
     bool registered = server->RegisterExtension(
-        scoped_ptr<XWalkExtension>(new CounterExtension));
+        make_scoped_refptr(new CounterExtension));
     ASSERT_TRUE(registered);
   }
 };
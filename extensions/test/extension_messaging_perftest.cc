@@ -0,0 +1,109 @@
+// Copyright (c) 2013 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/command_line.h"
+#include "base/path_service.h"
+#include "base/strings/stringprintf.h"
+#include "xwalk/extensions/browser/xwalk_extension_service.h"
+#include "xwalk/extensions/common/xwalk_extension_switches.h"
+#include "xwalk/extensions/test/xwalk_extensions_test_base.h"
+#include "xwalk/runtime/browser/runtime.h"
+#include "xwalk/test/base/xwalk_test_utils.h"
+#include "content/public/test/browser_test_utils.h"
+#include "content/public/test/test_utils.h"
+
+using xwalk::extensions::XWalkExtensionService;
+using xwalk::extensions::XWalkExtensionServer;
+using xwalk_test_utils::PrintPerfResult;
+
+namespace {
+
+struct PayloadConfig {
+  int size;
+  int iterations;
+};
+
+// Bigger payloads run fewer iterations to keep the total time reasonable.
+const PayloadConfig kPayloads[] = {
+  { 16, 1000 },
+  { 1024, 1000 },
+  { 64 * 1024, 200 },
+  { 1024 * 1024, 20 },
+};
+
+}  // namespace
+
+class ExtensionMessagingPerfTest : public XWalkExtensionsTestBase {
+ public:
+  virtual void RegisterExtensions(XWalkExtensionService* extension_service,
+                                  XWalkExtensionServer* server) OVERRIDE {
+    base::FilePath extension_dir;
+    PathService::Get(base::DIR_EXE, &extension_dir);
+
+    extension_dir = extension_dir
+                    .Append(FILE_PATH_LITERAL("tests"))
+                    .Append(FILE_PATH_LITERAL("extension"))
+                    .Append(FILE_PATH_LITERAL("echo_extension"));
+
+    extension_service->RegisterExternalExtensionsForPath(extension_dir);
+  }
+
+ protected:
+  // Runs all the benchmarks of echo_perf.html, reporting results with the
+  // |mode| suffix so in-process and extension process numbers are kept apart.
+  void RunBenchmarks(const std::string& mode) {
+    content::RunAllPendingInMessageLoop();
+    GURL url = GetExtensionsTestURL(
+        base::FilePath(), base::FilePath().AppendASCII("echo_perf.html"));
+    xwalk_test_utils::NavigateToURL(runtime(), url);
+
+    for (size_t i = 0; i < arraysize(kPayloads); ++i) {
+      const PayloadConfig& payload = kPayloads[i];
+      std::string trace =
+          base::StringPrintf("%s_%dB", mode.c_str(), payload.size);
+
+      double elapsed_ms = Measure("measurePostMessageThroughput", payload);
+      PrintPerfResult("extension_post_message_throughput", trace,
+                      payload.iterations * 1000.0 / elapsed_ms, "msgs/s");
+
+      elapsed_ms = Measure("measureAsyncRoundTrip", payload);
+      PrintPerfResult("extension_async_round_trip", trace,
+                      elapsed_ms * 1000.0 / payload.iterations, "us");
+
+      elapsed_ms = Measure("measureSyncRoundTrip", payload);
+      PrintPerfResult("extension_sync_round_trip", trace,
+                      elapsed_ms * 1000.0 / payload.iterations, "us");
+    }
+  }
+
+ private:
+  double Measure(const std::string& function, const PayloadConfig& payload) {
+    std::string script = base::StringPrintf(
+        "%s(%d, %d);", function.c_str(), payload.size, payload.iterations);
+    std::string result;
+    EXPECT_TRUE(content::ExecuteScriptAndExtractString(
+        runtime()->web_contents(), script, &result));
+
+    double elapsed_ms = 0;
+    EXPECT_TRUE(base::StringToDouble(result, &elapsed_ms));
+    EXPECT_LT(0, elapsed_ms) << function << " didn't report a valid time.";
+    return elapsed_ms > 0 ? elapsed_ms : 1;
+  }
+};
+
+class InProcessExtensionMessagingPerfTest : public ExtensionMessagingPerfTest {
+ public:
+  virtual void SetUpCommandLine(CommandLine* command_line) OVERRIDE {
+    ExtensionMessagingPerfTest::SetUpCommandLine(command_line);
+    command_line->AppendSwitch(switches::kXWalkDisableExtensionProcess);
+  }
+};
+
+IN_PROC_BROWSER_TEST_F(ExtensionMessagingPerfTest, ExtensionProcess) {
+  RunBenchmarks("extension_process");
+}
+
+IN_PROC_BROWSER_TEST_F(InProcessExtensionMessagingPerfTest, InProcess) {
+  RunBenchmarks("in_process");
+}
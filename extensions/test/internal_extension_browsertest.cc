@@ -135,7 +135,7 @@ class InternalExtensionTest : public XWalkExtensionsTestBase {
   void RegisterExtensions(XWalkExtensionService* extension_service,
       XWalkExtensionServer* server) OVERRIDE {
     bool registered = server->RegisterExtension(
-        scoped_ptr<XWalkExtension>(new TestExtension()));
+        make_scoped_refptr(new TestExtension()));
     ASSERT_TRUE(registered);
   }
 };
@@ -69,10 +69,10 @@ class XWalkExtensionsNestedNamespaceTest : public XWalkExtensionsTestBase {
   void RegisterExtensions(XWalkExtensionService* extension_service,
       XWalkExtensionServer* server) OVERRIDE {
     bool registered_outer = server->RegisterExtension(
-        scoped_ptr<XWalkExtension>(new OuterExtension));
+        make_scoped_refptr(new OuterExtension));
     ASSERT_TRUE(registered_outer);
     bool registered_inner = server->RegisterExtension(
-        scoped_ptr<XWalkExtension>(new InnerExtension));
+        make_scoped_refptr(new InnerExtension));
     ASSERT_TRUE(registered_inner);
   }
 };
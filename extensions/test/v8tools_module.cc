@@ -51,7 +51,7 @@ class XWalkExtensionsV8ToolsTest : public XWalkExtensionsTestBase {
   void RegisterExtensions(XWalkExtensionService* extension_service,
       XWalkExtensionServer* server) OVERRIDE {
     bool registered = server->RegisterExtension(
-        scoped_ptr<XWalkExtension>(new TestV8ToolsExtension));
+        make_scoped_refptr(new TestV8ToolsExtension));
     ASSERT_TRUE(registered);
   }
 };
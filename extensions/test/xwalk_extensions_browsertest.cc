@@ -108,11 +108,11 @@ class XWalkExtensionsTest : public XWalkExtensionsTestBase {
   void RegisterExtensions(XWalkExtensionService* extension_service,
       XWalkExtensionServer* server) OVERRIDE {
     bool registered = server->RegisterExtension(
-        scoped_ptr<XWalkExtension>(new EchoExtension));
+        make_scoped_refptr(new EchoExtension));
     ASSERT_TRUE(registered);
 
     bool invalid_registered = server->RegisterExtension(
-        scoped_ptr<XWalkExtension>(new ExtensionWithInvalidName));
+        make_scoped_refptr(new ExtensionWithInvalidName));
     ASSERT_FALSE(invalid_registered);
   }
 };
@@ -122,7 +122,7 @@ class XWalkExtensionsDelayedTest : public XWalkExtensionsTestBase {
   void RegisterExtensions(XWalkExtensionService* extension_service,
       XWalkExtensionServer* server) OVERRIDE {
     bool registered = server->RegisterExtension(
-        scoped_ptr<XWalkExtension>(new DelayedEchoExtension));
+        make_scoped_refptr(new DelayedEchoExtension));
   }
 };
 
@@ -6,6 +6,7 @@
 
 #include <stdlib.h>
 #include <string>
+#include <vector>
 
 #include "base/bind.h"
 #include "base/command_line.h"
@@ -13,6 +14,7 @@
 #include "base/files/file_path.h"
 #include "base/message_loop/message_loop.h"
 #include "base/strings/string_number_conversions.h"
+#include "base/time/time.h"
 #include "xwalk/application/browser/application_service.h"
 #include "xwalk/application/browser/application_system.h"
 #include "xwalk/application/common/application.h"
@@ -20,6 +22,7 @@
 #include "xwalk/application/common/application_manifest_constants.h"
 #include "xwalk/application/extension/application_extension.h"
 #include "xwalk/experimental/dialog/dialog_extension.h"
+#include "xwalk/extensions/common/xwalk_extension.h"
 #include "xwalk/extensions/common/xwalk_extension_server.h"
 #include "xwalk/extensions/common/xwalk_extension_switches.h"
 #include "xwalk/runtime/browser/devtools/remote_debugging_server.h"
@@ -248,6 +251,7 @@ void XWalkBrowserMainParts::PreMainMessageLoopRun() {
   runtime_registry_.reset(new RuntimeRegistry);
   extension_service_.reset(new extensions::XWalkExtensionService(this));
 
+  RegisterInternalExtensions();
   RegisterExternalExtensions();
 
   xwalk::application::ApplicationSystem* system =
@@ -256,6 +260,12 @@ void XWalkBrowserMainParts::PreMainMessageLoopRun() {
       system->application_service();
 
   CommandLine* command_line = CommandLine::ForCurrentProcess();
+  if (command_line->HasSwitch(switches::kShareApplicationResources) &&
+      !service->EnableResourceSharing())
+    LOG(ERROR) << "Unable to enable sharing the application resources.";
+  service->set_compress_resources(
+      command_line->HasSwitch(switches::kCompressApplicationResources));
+
   if (command_line->HasSwitch(switches::kRemoteDebuggingPort)) {
     std::string port_str =
         command_line->GetSwitchValueASCII(switches::kRemoteDebuggingPort);
@@ -267,14 +277,66 @@ void XWalkBrowserMainParts::PreMainMessageLoopRun() {
               loopback_ip, port, std::string()));
     }
   } else if (command_line->HasSwitch(switches::kListApplications)) {
-    xwalk::application::ApplicationStore::ApplicationMap* apps =
-        service->GetInstalledApplications();
+    // Only the indexed columns are read, the applications aren't created.
+    xwalk::application::ApplicationQuery query;
+    query.sort_key = xwalk::application::ApplicationQuery::SORT_BY_NAME;
+    std::vector<xwalk::application::ApplicationSummary> apps;
+    if (!service->QueryApplications(query, &apps))
+      LOG(ERROR) << "Unable to list the installed applications.";
     LOG(INFO) << "Application ID                       Application Name";
     LOG(INFO) << "-----------------------------------------------------";
-    xwalk::application::ApplicationStore::ApplicationMapIterator it;
-    for (it = apps->begin(); it != apps->end(); ++it)
-      LOG(INFO) << it->first << "     " << it->second->Name();
+    for (size_t i = 0; i < apps.size(); ++i)
+      LOG(INFO) << apps[i].id << "     " << apps[i].name;
     LOG(INFO) << "-----------------------------------------------------";
+    xwalk::application::SharedResourceStore::Report report;
+    if (service->GetSharedResourceReport(&report)) {
+      LOG(INFO) << "Shared resources: " << report.files << " files linked "
+                << report.links << " times, " << report.bytes_saved
+                << " bytes saved.";
+    }
+    run_default_message_loop_ = false;
+    return;
+  } else if (command_line->HasSwitch(switches::kInstallBatch)) {
+    std::vector<base::FilePath> paths;
+    const CommandLine::StringVector& args = command_line->GetArgs();
+    for (size_t i = 0; i < args.size(); ++i)
+      paths.push_back(base::FilePath(args[i]));
+
+    base::TimeTicks start = base::TimeTicks::Now();
+    std::vector<xwalk::application::ApplicationService::BatchInstallResult>
+        results;
+    service->InstallBatch(paths, &results);
+    base::TimeDelta elapsed = base::TimeTicks::Now() - start;
+
+    size_t installed = 0;
+    for (size_t i = 0; i < results.size(); ++i) {
+      if (!results[i].succeeded) {
+        LOG(ERROR) << "[ERR] Application install failure: "
+                   << results[i].path.value();
+        continue;
+      }
+      if (results[i].already_installed) {
+        LOG(INFO) << "[OK] Application already installed: " << results[i].id;
+        continue;
+      }
+#if defined(OS_TIZEN_MOBILE)
+      scoped_refptr<xwalk::application::PackageInstaller> installer =
+          xwalk::application::PackageInstaller::Create(service,
+              results[i].id, runtime_context_->GetPath());
+      if (!installer->Install()) {
+        LOG(ERROR) << "[ERR] An error occurred during installing on Tizen: "
+                   << results[i].id;
+        continue;
+      }
+#endif  // OS_TIZEN_MOBILE
+      LOG(INFO) << "[OK] Application installed: " << results[i].id;
+      ++installed;
+    }
+    LOG(INFO) << installed << " of " << results.size()
+              << " packages installed in " << elapsed.InSecondsF() << " s ("
+              << (elapsed.InSecondsF() > 0 ?
+                  installed / elapsed.InSecondsF() : 0)
+              << " packages/s)";
     run_default_message_loop_ = false;
     return;
   }
@@ -330,7 +392,9 @@ void XWalkBrowserMainParts::PreMainMessageLoopRun() {
     if (command_line->HasSwitch(switches::kInstall)) {
       if (base::PathExists(path)) {
         std::string id;
-        if (service->Install(path, &id)) {
+        bool installed = command_line->HasSwitch(switches::kKeepPacked) ?
+            service->InstallPacked(path, &id) : service->Install(path, &id);
+        if (installed) {
 #if defined(OS_TIZEN_MOBILE)
           scoped_refptr<xwalk::application::PackageInstaller> installer =
               xwalk::application::PackageInstaller::Create(service, id,
@@ -347,6 +411,14 @@ void XWalkBrowserMainParts::PreMainMessageLoopRun() {
       }
       run_default_message_loop_ = false;
       return;
+    } else if (command_line->HasSwitch(switches::kUpdate)) {
+      std::string id;
+      if (service->Update(path, &id))
+        LOG(INFO) << "[OK] Application updated: " << id;
+      else
+        LOG(ERROR) << "[ERR] Application update failure: " << path.value();
+      run_default_message_loop_ = false;
+      return;
     } else if (base::DirectoryExists(path)) {
       run_default_message_loop_ = service->Launch(path);
       return;
@@ -380,26 +452,29 @@ void XWalkBrowserMainParts::PostMainMessageLoopRun() {
 #endif
 }
 
+void XWalkBrowserMainParts::RegisterInternalExtensions() {
+#if !defined(OS_ANDROID)
+  extensions_.push_back(new RuntimeExtension());
+  extensions_.push_back(
+      new ApplicationExtension(runtime_context()->GetApplicationSystem()));
+  extensions_.push_back(
+      new experimental::DialogExtension(runtime_registry_.get()));
+#endif
+}
+
 void XWalkBrowserMainParts::RegisterInternalExtensionsInServer(
     extensions::XWalkExtensionServer* server) {
   CHECK(server);
-#if defined(OS_ANDROID)
-  ScopedVector<XWalkExtension>::const_iterator it = extensions_.begin();
+  std::vector<scoped_refptr<XWalkExtension> >::const_iterator it =
+      extensions_.begin();
   for (; it != extensions_.end(); ++it)
-    server->RegisterExtension(scoped_ptr<XWalkExtension>(*it));
-#else
-  server->RegisterExtension(scoped_ptr<XWalkExtension>(new RuntimeExtension()));
-  server->RegisterExtension(scoped_ptr<XWalkExtension>(
-      new ApplicationExtension(runtime_context()->GetApplicationSystem())));
-  server->RegisterExtension(scoped_ptr<XWalkExtension>(
-      new experimental::DialogExtension(runtime_registry_.get())));
-#endif
+    server->RegisterExtension(*it);
 }
 
 #if defined(OS_ANDROID)
 void XWalkBrowserMainParts::RegisterExtension(
-    scoped_ptr<XWalkExtension> extension) {
-  extensions_.push_back(extension.release());
+    const scoped_refptr<XWalkExtension>& extension) {
+  extensions_.push_back(extension);
 }
 #endif
 
@@ -6,9 +6,10 @@
 #define XWALK_RUNTIME_BROWSER_XWALK_BROWSER_MAIN_PARTS_H_
 
 #include <string>
+#include <vector>
 #include "base/basictypes.h"
+#include "base/memory/ref_counted.h"
 #include "base/memory/scoped_ptr.h"
-#include "base/memory/scoped_vector.h"
 #include "content/public/browser/browser_main_parts.h"
 #include "content/public/common/main_function_params.h"
 #include "url/gurl.h"
@@ -54,7 +55,8 @@ class XWalkBrowserMainParts : public content::BrowserMainParts,
   // XWalkExtensionAndroid needs to register its extensions on
   // XWalkBrowserMainParts so they get correctly registered on-demand
   // by XWalkExtensionService each time a in_process Server is created.
-  void RegisterExtension(scoped_ptr<extensions::XWalkExtension> extension);
+  void RegisterExtension(
+      const scoped_refptr<extensions::XWalkExtension>& extension);
 #else
   RuntimeContext* runtime_context() { return runtime_context_.get(); }
 #endif
@@ -74,7 +76,6 @@ class XWalkBrowserMainParts : public content::BrowserMainParts,
 
 #if defined(OS_ANDROID)
   RuntimeContext* runtime_context_;
-  ScopedVector<extensions::XWalkExtension> extensions_;
 #else
   scoped_ptr<RuntimeContext> runtime_context_;
 #endif
@@ -84,6 +85,11 @@ class XWalkBrowserMainParts : public content::BrowserMainParts,
 
   scoped_ptr<extensions::XWalkExtensionService> extension_service_;
 
+  // Internal extensions, created once and shared by the extension servers of
+  // all render processes. Declared after |runtime_registry_| because some of
+  // them observe it.
+  std::vector<scoped_refptr<extensions::XWalkExtension> > extensions_;
+
   // Should be about:blank If no URL is specified in command line arguments.
   GURL startup_url_;
 
@@ -13,6 +13,10 @@ const char kXWalkDataPath[] = "data-path";
 // Specifies the icon file for the app window.
 const char kAppIcon[] = "app-icon";
 
+// Specifies write a compressed copy of the text resources of the applications
+// installed or updated, served instead of the resources.
+const char kCompressApplicationResources[] = "compress-app-resources";
+
 // Specifies the window whether launched with fullscreen mode.
 const char kFullscreen[] = "fullscreen";
 
@@ -22,9 +26,25 @@ const char kListApplications[] = "list-apps";
 // Specifies install an application.
 const char kInstall[] = "install";
 
+// Specifies install the XPK packages given as arguments, or found in the
+// directories given as arguments, in parallel.
+const char kInstallBatch[] = "install-batch";
+
+// Specifies install an application without extracting its package, its
+// resources are served from the package. Used with --install.
+const char kKeepPacked[] = "keep-packed";
+
+// Specifies store the files of the applications installed from now on once
+// for identical content across applications.
+const char kShareApplicationResources[] = "share-app-resources";
+
 // Spedifies uninstall an application from runtime.
 const char kUninstall[] = "uninstall";
 
+// Specifies update an installed application from an XPK package, only writing
+// the files which changed.
+const char kUpdate[] = "update";
+
 // Specifies where XWalk will look for external extensions.
 const char kXWalkExternalExtensionsPath[] = "external-extensions-path";
 
@@ -12,14 +12,24 @@ extern const char kXWalkDataPath[];
 
 extern const char kAppIcon[];
 
+extern const char kCompressApplicationResources[];
+
 extern const char kFullscreen[];
 
 extern const char kInstall[];
 
+extern const char kInstallBatch[];
+
+extern const char kKeepPacked[];
+
 extern const char kListApplications[];
 
+extern const char kShareApplicationResources[];
+
 extern const char kUninstall[];
 
+extern const char kUpdate[];
+
 extern const char kXWalkExternalExtensionsPath[];
 
 extern const char kXWalkAllowExternalExtensionsForRemoteSources[];
@@ -4,6 +4,8 @@
 
 #include "xwalk/test/base/xwalk_test_utils.h"
 
+#include <stdio.h>
+
 #include "base/command_line.h"
 #include "base/environment.h"
 #include "base/logging.h"
@@ -75,4 +77,11 @@ void NavigateToURL(xwalk::Runtime* runtime, const GURL& url) {
       content::GetQuitTaskForRunLoop(&run_loop));
 }
 
+void PrintPerfResult(const std::string& graph, const std::string& trace,
+                     double value, const std::string& units) {
+  printf("*RESULT %s: %s= %s %s\n", graph.c_str(), trace.c_str(),
+         base::DoubleToString(value).c_str(), units.c_str());
+  fflush(stdout);
+}
+
 }  // namespace xwalk_test_utils
@@ -40,6 +40,11 @@ base::FilePath GetTestFilePath(const base::FilePath& dir,
 // navigation completes.
 void NavigateToURL(xwalk::Runtime* runtime, const GURL& url);
 
+// Prints a result of a performance test in the format parsed by the
+// performance dashboards: "*RESULT <graph>: <trace>= <value> <units>".
+void PrintPerfResult(const std::string& graph, const std::string& trace,
+                     double value, const std::string& units);
+
 }  // namespace xwalk_test_utils
 
 #endif  // XWALK_TEST_BASE_XWALK_TEST_UTILS_H_